@@ -0,0 +1,118 @@
+/**
+    \file AdaptivePacer.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/AdaptivePacer.h"
+
+#include <algorithm>
+
+AdaptivePacer::AdaptivePacer(RateLimiter& rateLimiter)
+    : rateLimiter(rateLimiter),
+      settings(),
+      smoothedLatency(Clock::duration::zero()),
+      lastBackoff(),
+      random(std::random_device()())
+{}
+
+AdaptivePacer::Settings AdaptivePacer::getSettings() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+void AdaptivePacer::setSettings(const Settings& settings)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->settings = settings;
+    if (settings.enabled)
+    {
+        rateLimiter.setInterval(std::min(std::max(rateLimiter.getInterval(), settings.minDelay), settings.maxDelay));
+    }
+}
+
+void AdaptivePacer::onResponse(Clock::duration latency)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // Exponentially weighted moving average like the smoothed round trip time of TCP
+    smoothedLatency
+        = smoothedLatency == Clock::duration::zero() ? latency : smoothedLatency + (latency - smoothedLatency) / 8;
+    if (!settings.enabled)
+    {
+        return;
+    }
+    if (smoothedLatency > settings.latencyTarget)
+    {
+        backOff();
+    }
+    else
+    {
+        rateLimiter.setInterval(std::max(rateLimiter.getInterval() - settings.step, settings.minDelay));
+    }
+}
+
+void AdaptivePacer::onStress()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (settings.enabled)
+    {
+        backOff();
+    }
+}
+
+AdaptivePacer::Clock::duration AdaptivePacer::getDelay() const
+{
+    return rateLimiter.getInterval();
+}
+
+double AdaptivePacer::getRate() const
+{
+    const Clock::duration delay = rateLimiter.getInterval();
+    if (delay <= Clock::duration::zero())
+    {
+        return 0.0;
+    }
+    return 1.0 / std::chrono::duration<double>(delay).count();
+}
+
+AdaptivePacer::Clock::duration AdaptivePacer::getLatency() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return smoothedLatency;
+}
+
+void AdaptivePacer::backOff()
+{
+    const Clock::time_point now = Clock::now();
+    const Clock::duration delay = rateLimiter.getInterval();
+    if (now - lastBackoff < std::max(delay, smoothedLatency))
+    {
+        return;
+    }
+    lastBackoff = now;
+    std::uniform_real_distribution<double> distribution(0.0, settings.jitter);
+    const double factor = settings.backoffFactor * (1.0 + distribution(random));
+    // A zero interval would never grow
+    const double base = static_cast<double>(std::max(delay, settings.step).count());
+    const Clock::duration grown
+        = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, Clock::period>(base * factor));
+    rateLimiter.setInterval(std::min(std::max(grown, settings.minDelay), settings.maxDelay));
+}
@@ -0,0 +1,145 @@
+/**
+    \file BaseAsyncHttpHandler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/BaseAsyncHttpHandler.h"
+
+#include <memory>
+#include <utility>
+
+#include "include/BaseHttpHandler.h"
+#include "include/HueExceptionMacro.h"
+
+namespace
+{
+    // Returns the offset of the body in the response
+    std::size_t FindBody(const std::string& response)
+    {
+        std::size_t start = response.find("\r\n\r\n");
+        if (start == std::string::npos)
+        {
+            throw HueException(CURRENT_FILE_INFO, "Failed to find body in response");
+        }
+        return start + 4;
+    }
+
+    // Starts a http span that ends when the last copy of the pointer is destroyed, nullptr without interceptors
+    std::shared_ptr<Trace::Span> StartSpan(
+        const TraceChain& chain, const std::string& method, const std::string& uri, std::size_t requestBytes)
+    {
+        if (!Trace::isEnabled(&chain))
+        {
+            return nullptr;
+        }
+        auto span = std::make_shared<Trace::Span>(SpanKind::http, method, uri, &chain);
+        span->setRequestBytes(requestBytes);
+        // The callback may run on another thread
+        span->detach();
+        return span;
+    }
+
+    // Records the outcome of a request in span, which may be nullptr
+    void EndSpan(std::shared_ptr<Trace::Span>& span, std::size_t responseBytes, std::exception_ptr error)
+    {
+        if (span)
+        {
+            span->setResponseBytes(responseBytes);
+            span->fail(error);
+            span.reset();
+        }
+    }
+} // namespace
+
+void BaseAsyncHttpHandler::sendHTTPRequest(const std::string& method, const std::string& uri,
+    const std::string& contentType, const std::string& body, const std::string& adr, int port,
+    ResponseCallback onBody) const
+{
+    std::shared_ptr<Trace::Span> span = StartSpan(traceChain, method, uri, body.size());
+    send(BaseHttpHandler::buildRequest(method, uri, contentType, body, adr, port, true), adr, port,
+        [onBody, span](std::string response, std::exception_ptr error) mutable {
+            if (!error)
+            {
+                try
+                {
+                    response.erase(0, FindBody(response));
+                }
+                catch (...)
+                {
+                    response.clear();
+                    error = std::current_exception();
+                }
+            }
+            EndSpan(span, response.size(), error);
+            onBody(std::move(response), error);
+        });
+}
+
+void BaseAsyncHttpHandler::GETJson(const std::string& uri, const nlohmann::json& body, const std::string& adr,
+    int port, JsonCallback onResponse) const
+{
+    sendJsonRequest("GET", uri, body, adr, port, std::move(onResponse));
+}
+
+void BaseAsyncHttpHandler::POSTJson(const std::string& uri, const nlohmann::json& body, const std::string& adr,
+    int port, JsonCallback onResponse) const
+{
+    sendJsonRequest("POST", uri, body, adr, port, std::move(onResponse));
+}
+
+void BaseAsyncHttpHandler::PUTJson(const std::string& uri, const nlohmann::json& body, const std::string& adr,
+    int port, JsonCallback onResponse) const
+{
+    sendJsonRequest("PUT", uri, body, adr, port, std::move(onResponse));
+}
+
+void BaseAsyncHttpHandler::DELETEJson(const std::string& uri, const nlohmann::json& body, const std::string& adr,
+    int port, JsonCallback onResponse) const
+{
+    sendJsonRequest("DELETE", uri, body, adr, port, std::move(onResponse));
+}
+
+void BaseAsyncHttpHandler::sendJsonRequest(const std::string& method, const std::string& uri,
+    const nlohmann::json& body, const std::string& adr, int port, JsonCallback onResponse) const
+{
+    const std::string content = body.dump();
+    std::shared_ptr<Trace::Span> span = StartSpan(traceChain, method, uri, content.size());
+    send(BaseHttpHandler::buildRequest(method, uri, "application/json", content, adr, port, true), adr, port,
+        [onResponse, span](std::string response, std::exception_ptr error) mutable {
+            nlohmann::json result;
+            std::size_t responseBytes = 0;
+            if (!error)
+            {
+                try
+                {
+                    // Parse in place instead of erasing the headers
+                    const std::size_t start = FindBody(response);
+                    responseBytes = response.size() - start;
+                    result = nlohmann::json::parse(response.cbegin() + start, response.cend());
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            }
+            EndSpan(span, responseBytes, error);
+            onResponse(std::move(result), error);
+        });
+}
@@ -22,50 +22,148 @@
 
 #include "include/BaseHttpHandler.h"
 
+#include <chrono>
+#include <streambuf>
+
 #include "include/HueExceptionMacro.h"
+#include "include/Log.h"
+#include "include/RequestMetrics.h"
+#include "include/Trace.h"
+
+namespace
+{
+    // Stream buffer that reads from a range of memory without copying it
+    class MemoryStreambuf : public std::streambuf
+    {
+    public:
+        MemoryStreambuf(char* begin, char* end) { setg(begin, begin, end); }
+    };
+
+    // Stream buffer that counts the bytes read from another stream buffer and the time spent reading them
+    class CountingStreambuf : public std::streambuf
+    {
+    public:
+        explicit CountingStreambuf(std::streambuf& source) : source(source), count(0), readTime(0) {}
+
+        std::size_t getCount() const { return count; }
+        std::chrono::steady_clock::duration getReadTime() const { return readTime; }
+
+    protected:
+        int_type underflow() override
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            const std::streamsize read = source.sgetn(buffer, sizeof(buffer));
+            readTime += std::chrono::steady_clock::now() - start;
+            if (read <= 0)
+            {
+                return traits_type::eof();
+            }
+            count += static_cast<std::size_t>(read);
+            setg(buffer, buffer, buffer + read);
+            return traits_type::to_int_type(buffer[0]);
+        }
+
+    private:
+        std::streambuf& source;
+        std::size_t count;
+        std::chrono::steady_clock::duration readTime;
+        char buffer[4096];
+    };
+
+    // Passes the body to onBody, records its size in span when it is active and reports the time onBody spent
+    // outside of reads as parse time
+    void ReadBody(Trace::Span& span, std::istream& body, const std::function<void(std::istream&)>& onBody)
+    {
+        CountingStreambuf counter(*body.rdbuf());
+        std::istream counted(&counter);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        onBody(counted);
+        RequestMetrics::addParseTime(std::chrono::steady_clock::now() - start - counter.getReadTime());
+        if (span.isActive())
+        {
+            span.setResponseBytes(counter.getCount());
+        }
+    }
+
+    // Runs fun and marks span as failed when it throws
+    template <typename Fun>
+    auto RunInSpan(Trace::Span& span, Fun fun) -> decltype(fun())
+    {
+        try
+        {
+            return fun();
+        }
+        catch (const std::exception& e)
+        {
+            span.fail(e.what());
+            throw;
+        }
+    }
+
+    // Returns the offset of the body in the response, msg is only used for the error message
+    template <typename Message>
+    std::size_t FindBody(const Message& msg, const std::string& response)
+    {
+        std::size_t start = response.find("\r\n\r\n");
+        if (start == std::string::npos)
+        {
+            HUE_LOG(LogLevel::error, "BaseHttpHandler: Failed to find body in response");
+            HUE_LOG(LogLevel::debug, "Request:\n\"" << msg << "\"\nResponse:\n\"" << response << "\"");
+            throw HueException(CURRENT_FILE_INFO, "Failed to find body in response");
+        }
+        return start + 4;
+    }
+} // namespace
+
+std::string BaseHttpHandler::buildRequest(const std::string& method, const std::string& uri,
+    const std::string& contentType, const std::string& body, const std::string& adr, int port, bool keepAlive)
+{
+    return HttpRequestWriter(method, uri, contentType, body, adr, port, keepAlive).str();
+}
 
 std::string BaseHttpHandler::sendGetHTTPBody(const std::string& msg, const std::string& adr, int port) const
 {
     std::string response = send(msg, adr, port);
-    size_t start = response.find("\r\n\r\n");
-    if (start == std::string::npos)
+    const std::size_t start = FindBody(msg, response);
+    response.erase(0, start);
+    return response;
+}
+
+void BaseHttpHandler::sendGetHTTPBody(const std::string& msg, const std::function<void(std::istream&)>& onBody,
+    const std::string& adr, int port) const
+{
+    std::string response = send(msg, adr, port);
+    const std::size_t start = FindBody(msg, response);
+    // Read the body in place instead of erasing the headers
+    MemoryStreambuf buffer(&response[start], &response[0] + response.size());
+    std::istream body(&buffer);
+    onBody(body);
+}
+
+void BaseHttpHandler::sendMulticast(const std::string& msg, const std::function<bool(const std::string&)>& onAnswer,
+    const std::string& adr, int port, int timeout) const
+{
+    for (const std::string& answer : sendMulticast(msg, adr, port, timeout))
     {
-        std::cerr << "BaseHttpHandler: Failed to find body in response\n";
-        std::cerr << "Request:\n";
-        std::cerr << "\"" << msg << "\"\n";
-        std::cerr << "Response:\n";
-        std::cerr << "\"" << response << "\"\n";
-        throw HueException(CURRENT_FILE_INFO, "Failed to find body in response");
+        if (!onAnswer(answer))
+        {
+            break;
+        }
     }
-    response.erase(0, start + 4);
-    return response;
 }
 
 std::string BaseHttpHandler::sendHTTPRequest(const std::string& method, const std::string& uri,
     const std::string& contentType, const std::string& body, const std::string& adr, int port) const
 {
-    std::string request;
-    // Protocol reference:
-    // https://www.w3.org/Protocols/rfc2616/rfc2616-sec5.html Request-Line
-    request.append(method); // Method
-    request.append(" "); // Separation
-    request.append(uri); // Request-URI
-    request.append(" "); // Separation
-    request.append("HTTP/1.0"); // HTTP-Version
-    request.append("\r\n"); // Ending
-                            // Entities
-    request.append("Content-Type:"); // entity-header
-    request.append(" "); // Separation
-    request.append(contentType); // media-type
-    request.append("\r\n"); // Entity ending
-    request.append("Content-Length:"); // entity-header
-    request.append(" "); // Separation
-    request.append(std::to_string(body.size())); // length
-    request.append("\r\n\r\n"); // Entity ending & Request-Line ending
-    request.append(body); // message-body
-    request.append("\r\n\r\n"); // Ending
-
-    return sendGetHTTPBody(request.c_str(), adr, port);
+    Trace::Span span(SpanKind::http, method, uri, &traceChain);
+    span.setRequestBytes(body.size());
+    return RunInSpan(span, [&]() {
+        const HttpRequestWriter request(method, uri, contentType, body, adr, port, useKeepAlive());
+        std::string response = sendRequest(request, adr, port);
+        response.erase(0, FindBody(request, response));
+        span.setResponseBytes(response.size());
+        return response;
+    });
 }
 
 std::string BaseHttpHandler::GETString(const std::string& uri, const std::string& contentType, const std::string& body,
@@ -95,23 +193,69 @@ std::string BaseHttpHandler::DELETEString(const std::string& uri, const std::str
 nlohmann::json BaseHttpHandler::GETJson(
     const std::string& uri, const nlohmann::json& body, const std::string& adr, int port) const
 {
-    return nlohmann::json::parse(GETString(uri, "application/json", body.dump(), adr, port));
+    return sendJsonRequest("GET", uri, body, adr, port);
 }
 
 nlohmann::json BaseHttpHandler::POSTJson(
     const std::string& uri, const nlohmann::json& body, const std::string& adr, int port) const
 {
-    return nlohmann::json::parse(POSTString(uri, "application/json", body.dump(), adr, port));
+    return sendJsonRequest("POST", uri, body, adr, port);
 }
 
 nlohmann::json BaseHttpHandler::PUTJson(
     const std::string& uri, const nlohmann::json& body, const std::string& adr, int port) const
 {
-    return nlohmann::json::parse(PUTString(uri, "application/json", body.dump(), adr, port));
+    return sendJsonRequest("PUT", uri, body, adr, port);
 }
 
 nlohmann::json BaseHttpHandler::DELETEJson(
     const std::string& uri, const nlohmann::json& body, const std::string& adr, int port) const
 {
-    return nlohmann::json::parse(DELETEString(uri, "application/json", body.dump(), adr, port));
+    return sendJsonRequest("DELETE", uri, body, adr, port);
+}
+
+bool BaseHttpHandler::GETJsonSax(const std::string& uri, const nlohmann::json& body,
+    nlohmann::json::json_sax_t& handler, const std::string& adr, int port) const
+{
+    bool result = false;
+    const std::string content = body.dump();
+    Trace::Span span(SpanKind::http, "GET", uri, &traceChain);
+    span.setRequestBytes(content.size());
+    RunInSpan(span, [&]() {
+        sendRequest(HttpRequestWriter("GET", uri, "application/json", content, adr, port, useKeepAlive()),
+            [&](std::istream& stream) {
+                ReadBody(span, stream,
+                    [&](std::istream& counted) { result = nlohmann::json::sax_parse(counted, &handler); });
+            },
+            adr, port);
+    });
+    return result;
+}
+
+std::string BaseHttpHandler::sendRequest(const HttpRequestWriter& request, const std::string& adr, int port) const
+{
+    return send(request.str(), adr, port);
+}
+
+void BaseHttpHandler::sendRequest(const HttpRequestWriter& request, const std::function<void(std::istream&)>& onBody,
+    const std::string& adr, int port) const
+{
+    sendGetHTTPBody(request.str(), onBody, adr, port);
+}
+
+nlohmann::json BaseHttpHandler::sendJsonRequest(const std::string& method, const std::string& uri,
+    const nlohmann::json& body, const std::string& adr, int port) const
+{
+    nlohmann::json result;
+    const std::string content = body.dump();
+    Trace::Span span(SpanKind::http, method, uri, &traceChain);
+    span.setRequestBytes(content.size());
+    RunInSpan(span, [&]() {
+        sendRequest(HttpRequestWriter(method, uri, "application/json", content, adr, port, useKeepAlive()),
+            [&](std::istream& stream) {
+                ReadBody(span, stream, [&](std::istream& counted) { result = nlohmann::json::parse(counted); });
+            },
+            adr, port);
+    });
+    return result;
 }
@@ -0,0 +1,250 @@
+/**
+    \file FilteringJsonSax.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/FilteringJsonSax.h"
+
+#include <algorithm>
+
+FilteringJsonSax::FilteringJsonSax(const std::vector<std::string>& paths) : skipDepth(0), captureDepth(0)
+{
+    for (const std::string& path : paths)
+    {
+        Path keys;
+        std::size_t start = 0;
+        while (start < path.size())
+        {
+            std::size_t end = std::min(path.find('/', start), path.size());
+            keys.push_back(path.substr(start, end - start));
+            start = end + 1;
+        }
+        this->paths.push_back(std::move(keys));
+    }
+}
+
+FilteringJsonSax::~FilteringJsonSax() = default;
+
+template <typename F>
+bool FilteringJsonSax::scalar(F forward)
+{
+    if (skipDepth > 0)
+    {
+        return true;
+    }
+    if (captureDepth > 0)
+    {
+        forward();
+    }
+    else if (beginValue(false, false))
+    {
+        forward();
+        endCapture();
+    }
+    return true;
+}
+
+bool FilteringJsonSax::null()
+{
+    return scalar([&] { capture->null(); });
+}
+
+bool FilteringJsonSax::boolean(bool val)
+{
+    return scalar([&] { capture->boolean(val); });
+}
+
+bool FilteringJsonSax::number_integer(number_integer_t val)
+{
+    return scalar([&] { capture->number_integer(val); });
+}
+
+bool FilteringJsonSax::number_unsigned(number_unsigned_t val)
+{
+    return scalar([&] { capture->number_unsigned(val); });
+}
+
+bool FilteringJsonSax::number_float(number_float_t val, const string_t& s)
+{
+    return scalar([&] { capture->number_float(val, s); });
+}
+
+bool FilteringJsonSax::string(string_t& val)
+{
+    return scalar([&] { capture->string(val); });
+}
+
+bool FilteringJsonSax::start_object(std::size_t elements)
+{
+    if (skipDepth > 0)
+    {
+        ++skipDepth;
+    }
+    else if (captureDepth > 0)
+    {
+        ++captureDepth;
+        return capture->start_object(elements);
+    }
+    else if (beginValue(true, true))
+    {
+        captureDepth = 1;
+        return capture->start_object(elements);
+    }
+    return true;
+}
+
+bool FilteringJsonSax::key(string_t& val)
+{
+    if (skipDepth > 0)
+    {
+        return true;
+    }
+    else if (captureDepth > 0)
+    {
+        return capture->key(val);
+    }
+    path.back() = val;
+    return true;
+}
+
+bool FilteringJsonSax::end_object()
+{
+    if (skipDepth > 0)
+    {
+        --skipDepth;
+    }
+    else if (captureDepth > 0)
+    {
+        capture->end_object();
+        if (--captureDepth == 0)
+        {
+            endCapture();
+        }
+    }
+    else
+    {
+        // End of an object that contains selected paths
+        path.pop_back();
+    }
+    return true;
+}
+
+bool FilteringJsonSax::start_array(std::size_t elements)
+{
+    if (skipDepth > 0)
+    {
+        ++skipDepth;
+    }
+    else if (captureDepth > 0)
+    {
+        ++captureDepth;
+        return capture->start_array(elements);
+    }
+    else if (beginValue(true, false))
+    {
+        captureDepth = 1;
+        return capture->start_array(elements);
+    }
+    return true;
+}
+
+bool FilteringJsonSax::end_array()
+{
+    if (skipDepth > 0)
+    {
+        --skipDepth;
+    }
+    else
+    {
+        // Arrays are never entered unless they are captured
+        capture->end_array();
+        if (--captureDepth == 0)
+        {
+            endCapture();
+        }
+    }
+    return true;
+}
+
+bool FilteringJsonSax::parse_error(
+    std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& ex)
+{
+    // Throws the same exceptions as nlohmann::json::parse
+    nlohmann::json unused;
+    return nlohmann::detail::json_sax_dom_parser<nlohmann::json>(unused).parse_error(position, lastToken, ex);
+}
+
+FilteringJsonSax::Match FilteringJsonSax::match() const
+{
+    Match best = Match::none;
+    for (const Path& selected : paths)
+    {
+        if (selected.size() < path.size())
+        {
+            continue;
+        }
+        bool matches = true;
+        for (std::size_t i = 0; i < path.size() && matches; ++i)
+        {
+            matches = selected[i] == "*" || selected[i] == path[i];
+        }
+        if (matches)
+        {
+            if (selected.size() == path.size())
+            {
+                return Match::full;
+            }
+            best = Match::prefix;
+        }
+    }
+    return best;
+}
+
+bool FilteringJsonSax::beginValue(bool container, bool object)
+{
+    const Match m = match();
+    if (m == Match::full)
+    {
+        captured = nullptr;
+        capture.reset(new nlohmann::detail::json_sax_dom_parser<nlohmann::json>(captured));
+        return true;
+    }
+    if (m == Match::prefix && object)
+    {
+        // Enter the object, the key is set by the next key event
+        path.emplace_back();
+    }
+    else if (container)
+    {
+        skipDepth = 1;
+    }
+    return false;
+}
+
+void FilteringJsonSax::endCapture()
+{
+    nlohmann::json* target = &result;
+    for (const std::string& k : path)
+    {
+        target = &(*target)[k];
+    }
+    *target = std::move(captured);
+    capture.reset();
+}
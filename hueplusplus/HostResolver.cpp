@@ -0,0 +1,154 @@
+/**
+    \file HostResolver.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/HostResolver.h"
+
+#include "include/Log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <arpa/inet.h> // inet_pton
+#include <netdb.h> // getaddrinfo
+#include <netinet/in.h> // struct sockaddr_in, struct sockaddr_in6
+
+namespace
+{
+    // Sets the port in an IPv4 or IPv6 address
+    void SetPort(HostResolver::Address& address, int port)
+    {
+        if (address.family() == AF_INET6)
+        {
+            reinterpret_cast<sockaddr_in6&>(address.address).sin6_port = htons(port);
+        }
+        else
+        {
+            reinterpret_cast<sockaddr_in&>(address.address).sin_port = htons(port);
+        }
+    }
+} // namespace
+
+HostResolver::HostResolver(std::chrono::steady_clock::duration ttl) : ttl(ttl) {}
+
+std::vector<HostResolver::Address> HostResolver::resolve(const std::string& host, int port)
+{
+    Address numeric;
+    if (parseNumeric(host, port, numeric))
+    {
+        return {numeric};
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<Address> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto pos = cache.find(host);
+        if (pos != cache.end() && pos->second.expires > now)
+        {
+            result = pos->second.addresses;
+        }
+    }
+    if (result.empty())
+    {
+        // Resolve without holding the lock, getaddrinfo can block for a long time
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_ADDRCONFIG;
+        addrinfo* info = nullptr;
+        int error = getaddrinfo(host.c_str(), nullptr, &hints, &info);
+        if (error != 0)
+        {
+            int errCode = error == EAI_SYSTEM ? errno : EHOSTUNREACH;
+            HUE_LOG(LogLevel::error, "HostResolver: Failed to find host with address " << host << ": "
+                    << gai_strerror(error));
+            throw(std::system_error(errCode, std::generic_category(), "HostResolver: getaddrinfo"));
+        }
+        for (addrinfo* it = info; it != nullptr; it = it->ai_next)
+        {
+            if ((it->ai_family == AF_INET || it->ai_family == AF_INET6) && it->ai_addrlen <= sizeof(sockaddr_storage))
+            {
+                Address address;
+                std::memset(&address.address, 0, sizeof(address.address));
+                std::memcpy(&address.address, it->ai_addr, it->ai_addrlen);
+                address.length = it->ai_addrlen;
+                result.push_back(address);
+            }
+        }
+        freeaddrinfo(info);
+        if (result.empty())
+        {
+            HUE_LOG(LogLevel::error, "HostResolver: No usable address for host " << host);
+            throw(std::system_error(EHOSTUNREACH, std::generic_category(), "HostResolver: getaddrinfo"));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        cache[host] = CacheEntry {result, now + ttl};
+    }
+    for (Address& address : result)
+    {
+        SetPort(address, port);
+    }
+    return result;
+}
+
+void HostResolver::setTTL(std::chrono::steady_clock::duration ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->ttl = ttl;
+    cache.clear();
+}
+
+void HostResolver::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    cache.clear();
+}
+
+bool HostResolver::parseNumeric(const std::string& host, int port, Address& result)
+{
+    std::memset(&result.address, 0, sizeof(result.address));
+    sockaddr_in& v4 = reinterpret_cast<sockaddr_in&>(result.address);
+    if (inet_pton(AF_INET, host.c_str(), &v4.sin_addr) == 1)
+    {
+        v4.sin_family = AF_INET;
+        result.length = sizeof(sockaddr_in);
+        SetPort(result, port);
+        return true;
+    }
+    // IPv6 addresses may be enclosed in brackets like in URLs
+    std::string v6Host = host;
+    if (v6Host.size() > 2 && v6Host.front() == '[' && v6Host.back() == ']')
+    {
+        v6Host = v6Host.substr(1, v6Host.size() - 2);
+    }
+    sockaddr_in6& v6 = reinterpret_cast<sockaddr_in6&>(result.address);
+    if (inet_pton(AF_INET6, v6Host.c_str(), &v6.sin6_addr) == 1)
+    {
+        v6.sin6_family = AF_INET6;
+        result.length = sizeof(sockaddr_in6);
+        SetPort(result, port);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+/**
+    \file HttpRequestWriter.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/HttpRequestWriter.h"
+
+constexpr std::size_t HttpRequestWriter::maxBuffers;
+
+namespace
+{
+    // Constant parts of the request, see https://tools.ietf.org/html/rfc7230#section-3
+    constexpr char space[] = " ";
+    constexpr char hostHeader[] = " HTTP/1.1\r\nHost: ";
+    constexpr char ipv6HostHeader[] = " HTTP/1.1\r\nHost: [";
+    constexpr char keepAliveHeaders[] = "\r\nConnection: keep-alive\r\nContent-Type: ";
+    constexpr char legacyHeaders[] = " HTTP/1.0\r\nContent-Type: ";
+    constexpr char lengthHeader[] = "\r\nContent-Length: ";
+    constexpr char headerEnd[] = "\r\n\r\n";
+
+    // Formats value in decimal so that it ends before end, returns the first character
+    char* FormatNumber(char* end, std::size_t value)
+    {
+        do
+        {
+            *--end = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        return end;
+    }
+} // namespace
+
+HttpRequestWriter::HttpRequestWriter(const std::string& method, const std::string& uri,
+    const std::string& contentType, const std::string& body, const std::string& adr, int port, bool keepAlive)
+    : count(0), size(0), headRequest(method == "HEAD")
+{
+    add(method.data(), method.size()); // Method
+    add(space, sizeof(space) - 1);
+    add(uri.data(), uri.size()); // Request-URI
+    if (!keepAlive)
+    {
+        // HTTP/1.0 without Host header, the response is never chunked and ends when the connection is closed.
+        // The CRLFs after the body are kept from earlier versions.
+        add(legacyHeaders, sizeof(legacyHeaders) - 1);
+        AddContent(contentType, body);
+        add(headerEnd, sizeof(headerEnd) - 1);
+        return;
+    }
+    // HTTP-Version and Host header, mandatory for HTTP/1.1. IPv6 addresses are enclosed in brackets, unless
+    // they already are.
+    const bool ipv6 = adr.find(':') != std::string::npos && adr.front() != '[';
+    if (ipv6)
+    {
+        add(ipv6HostHeader, sizeof(ipv6HostHeader) - 1);
+    }
+    else
+    {
+        add(hostHeader, sizeof(hostHeader) - 1);
+    }
+    add(adr.data(), adr.size());
+    char* const portEnd = numbers + sizeof(numbers) / 2;
+    char* portStart = portEnd;
+    if (port != 80)
+    {
+        portStart = FormatNumber(portEnd, static_cast<std::size_t>(port));
+        *--portStart = ':';
+    }
+    if (ipv6)
+    {
+        *--portStart = ']';
+    }
+    if (portStart != portEnd)
+    {
+        add(portStart, portEnd - portStart);
+    }
+    add(keepAliveHeaders, sizeof(keepAliveHeaders) - 1);
+    AddContent(contentType, body);
+}
+
+void HttpRequestWriter::AddContent(const std::string& contentType, const std::string& body)
+{
+    add(contentType.data(), contentType.size());
+    add(lengthHeader, sizeof(lengthHeader) - 1);
+    char* const lengthEnd = numbers + sizeof(numbers);
+    const char* lengthStart = FormatNumber(lengthEnd, body.size());
+    add(lengthStart, lengthEnd - lengthStart);
+    add(headerEnd, sizeof(headerEnd) - 1);
+    add(body.data(), body.size()); // message-body, framed by Content-Length
+}
+
+std::string HttpRequestWriter::str() const
+{
+    std::string result;
+    result.reserve(size);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        result.append(buffers[i].data, buffers[i].size);
+    }
+    return result;
+}
+
+void HttpRequestWriter::add(const char* data, std::size_t length)
+{
+    if (length != 0)
+    {
+        buffers[count].data = data;
+        buffers[count].size = length;
+        ++count;
+        size += length;
+    }
+}
+
+std::ostream& operator<<(std::ostream& stream, const HttpRequestWriter& request)
+{
+    for (std::size_t i = 0; i < request.getBufferCount(); ++i)
+    {
+        stream.write(request.getBuffers()[i].data, request.getBuffers()[i].size);
+    }
+    return stream;
+}
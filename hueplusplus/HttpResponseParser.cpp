@@ -0,0 +1,285 @@
+/**
+    \file HttpResponseParser.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/HttpResponseParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // Case insensitive comparison of header names and tokens
+    bool EqualsIgnoreCase(const char* begin, const char* end, const char* other)
+    {
+        const std::size_t length = std::strlen(other);
+        return static_cast<std::size_t>(end - begin) == length
+            && std::equal(begin, end, other,
+                [](unsigned char l, unsigned char r) { return std::tolower(l) == std::tolower(r); });
+    }
+
+    // Removes leading and trailing whitespace from [begin, end)
+    void Trim(const char*& begin, const char*& end)
+    {
+        while (begin != end && (*begin == ' ' || *begin == '\t'))
+        {
+            ++begin;
+        }
+        while (end != begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        {
+            --end;
+        }
+    }
+} // namespace
+
+HttpResponseParser::HttpResponseParser(bool headRequest)
+{
+    reset(headRequest);
+}
+
+void HttpResponseParser::reset(bool headRequest)
+{
+    state = State::headers;
+    this->headRequest = headRequest;
+    keepAlive = false;
+    status = 0;
+    bodyStart = std::string::npos;
+    remaining = 0;
+    scanned = 0;
+    line.clear();
+    response.clear();
+}
+
+void HttpResponseParser::setBodyCallback(std::function<void(const char*, std::size_t)> onBody)
+{
+    this->onBody = std::move(onBody);
+}
+
+std::size_t HttpResponseParser::feed(const char* data, std::size_t size)
+{
+    std::size_t consumed = 0;
+    while (consumed < size && state != State::done)
+    {
+        const char* p = data + consumed;
+        const std::size_t n = size - consumed;
+        switch (state)
+        {
+        case State::headers:
+        {
+            response.append(p, n);
+            // Only search the new data, including the last 3 bytes in case the separator was split
+            std::size_t headerEnd = response.find("\r\n\r\n", scanned < 3 ? 0 : scanned - 3);
+            if (headerEnd == std::string::npos)
+            {
+                scanned = response.size();
+                consumed = size;
+                break;
+            }
+            bodyStart = headerEnd + 4;
+            // Give back everything after the headers, it is parsed as body
+            const std::size_t extra = response.size() - bodyStart;
+            response.resize(bodyStart);
+            consumed += n - extra;
+            parseHeaders();
+            break;
+        }
+        case State::body:
+        case State::chunkData:
+        {
+            const std::size_t take = std::min(n, remaining);
+            appendBody(p, take);
+            remaining -= take;
+            consumed += take;
+            if (remaining == 0)
+            {
+                state = state == State::body ? State::done : State::chunkEnd;
+            }
+            break;
+        }
+        case State::untilClose:
+            appendBody(p, n);
+            consumed = size;
+            break;
+        case State::chunkSize:
+        {
+            bool complete = false;
+            consumed += readLine(p, n, complete);
+            if (complete)
+            {
+                // Chunk extensions after ';' are ignored
+                remaining = std::strtoul(line.c_str(), nullptr, 16);
+                line.clear();
+                state = remaining == 0 ? State::trailers : State::chunkData;
+            }
+            break;
+        }
+        case State::chunkEnd:
+        {
+            bool complete = false;
+            consumed += readLine(p, n, complete);
+            if (complete)
+            {
+                line.clear();
+                state = State::chunkSize;
+            }
+            break;
+        }
+        case State::trailers:
+        {
+            bool complete = false;
+            consumed += readLine(p, n, complete);
+            if (complete)
+            {
+                // Trailers are ignored, an empty line ends the response
+                state = line.empty() ? State::done : State::trailers;
+                line.clear();
+            }
+            break;
+        }
+        case State::done:
+            break;
+        }
+    }
+    return consumed;
+}
+
+bool HttpResponseParser::finish()
+{
+    if (state == State::headers && response.empty())
+    {
+        return false;
+    }
+    if (state != State::untilClose && state != State::done)
+    {
+        // Truncated response, keep what was received
+        keepAlive = false;
+    }
+    state = State::done;
+    return true;
+}
+
+void HttpResponseParser::parseHeaders()
+{
+    const char* const begin = response.data();
+    const char* const headerEnd = begin + bodyStart - 4;
+    const char* lineEnd = std::search(begin, headerEnd, "\r\n", "\r\n" + 2);
+
+    // Status line, e.g. "HTTP/1.1 200 OK"
+    keepAlive = lineEnd - begin >= 8 && std::equal(begin, begin + 8, "HTTP/1.1");
+    const char* statusBegin = std::find(begin, lineEnd, ' ');
+    status = statusBegin != lineEnd ? std::atoi(statusBegin + 1) : 0;
+
+    bool chunked = false;
+    bool hasLength = false;
+    std::size_t length = 0;
+    while (lineEnd < headerEnd)
+    {
+        const char* lineBegin = lineEnd + 2;
+        lineEnd = std::search(lineBegin, headerEnd, "\r\n", "\r\n" + 2);
+        const char* colon = std::find(lineBegin, lineEnd, ':');
+        if (colon == lineEnd)
+        {
+            continue;
+        }
+        const char* nameBegin = lineBegin;
+        const char* nameEnd = colon;
+        Trim(nameBegin, nameEnd);
+        const char* valueBegin = colon + 1;
+        const char* valueEnd = lineEnd;
+        Trim(valueBegin, valueEnd);
+        if (EqualsIgnoreCase(nameBegin, nameEnd, "Content-Length"))
+        {
+            length = std::strtoul(valueBegin, nullptr, 10);
+            hasLength = true;
+        }
+        else if (EqualsIgnoreCase(nameBegin, nameEnd, "Transfer-Encoding"))
+        {
+            chunked = !EqualsIgnoreCase(valueBegin, valueEnd, "identity");
+        }
+        else if (EqualsIgnoreCase(nameBegin, nameEnd, "Connection"))
+        {
+            if (EqualsIgnoreCase(valueBegin, valueEnd, "close"))
+            {
+                keepAlive = false;
+            }
+            else if (EqualsIgnoreCase(valueBegin, valueEnd, "keep-alive"))
+            {
+                keepAlive = true;
+            }
+        }
+    }
+
+    if (headRequest || status / 100 == 1 || status == 204 || status == 304)
+    {
+        // No body allowed
+        state = State::done;
+    }
+    else if (chunked)
+    {
+        state = State::chunkSize;
+    }
+    else if (hasLength)
+    {
+        if (!onBody)
+        {
+            response.reserve(bodyStart + length);
+        }
+        remaining = length;
+        state = length == 0 ? State::done : State::body;
+    }
+    else
+    {
+        state = State::untilClose;
+        keepAlive = false;
+    }
+}
+
+std::size_t HttpResponseParser::readLine(const char* data, std::size_t size, bool& complete)
+{
+    const char* end = std::find(data, data + size, '\n');
+    complete = end != data + size;
+    const std::size_t consumed = complete ? end - data + 1 : size;
+    line.append(data, consumed);
+    if (complete)
+    {
+        // Remove line ending
+        line.pop_back();
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+    }
+    return consumed;
+}
+
+void HttpResponseParser::appendBody(const char* data, std::size_t size)
+{
+    if (onBody)
+    {
+        onBody(data, size);
+    }
+    else
+    {
+        response.append(data, size);
+    }
+}
@@ -26,7 +26,6 @@
 #include <cctype>
 #include <chrono>
 #include <cstring>
-#include <iostream>
 #include <locale>
 #include <stdexcept>
 #include <thread>
@@ -34,6 +33,7 @@
 #include "include/ExtendedColorHueStrategy.h"
 #include "include/ExtendedColorTemperatureStrategy.h"
 #include "include/HueExceptionMacro.h"
+#include "include/Log.h"
 #include "include/SimpleBrightnessStrategy.h"
 #include "include/SimpleColorHueStrategy.h"
 #include "include/SimpleColorTemperatureStrategy.h"
@@ -44,12 +44,18 @@ HueFinder::HueFinder(std::shared_ptr<const IHttpHandler> handler) : http_handler
 
 std::vector<HueFinder::HueIdentification> HueFinder::FindBridges() const
 {
-    UPnP uplug;
-    std::vector<std::pair<std::string, std::string>> foundDevices = uplug.getDevices(http_handler);
-
     std::vector<HueIdentification> foundBridges;
-    for (const std::pair<std::string, std::string>& p : foundDevices)
-    {
+    FindBridges([&](const HueIdentification& bridge) {
+        foundBridges.push_back(bridge);
+        return true;
+    });
+    return foundBridges;
+}
+
+void HueFinder::FindBridges(const std::function<bool(const HueIdentification&)>& onBridge) const
+{
+    UPnP uplug;
+    uplug.getDevices(http_handler, [&](const std::pair<std::string, std::string>& p) {
         size_t found = p.second.find("IpBridge");
         if (found != std::string::npos)
         {
@@ -63,11 +69,11 @@ std::vector<HueFinder::HueIdentification> HueFinder::FindBridges() const
             if (!mac.empty())
             {
                 bridge.mac = NormalizeMac(mac);
-                foundBridges.push_back(std::move(bridge));
+                return onBridge(bridge);
             }
         }
-    }
-    return foundBridges;
+        return true;
+    });
 }
 
 Hue HueFinder::GetBridge(const HueIdentification& identification)
@@ -82,7 +88,7 @@ Hue HueFinder::GetBridge(const HueIdentification& identification)
     bridge.requestUsername();
     if (bridge.getUsername().empty())
     {
-        std::cerr << "Failed to request username for ip " << identification.ip << std::endl;
+        HUE_LOG(LogLevel::error, "Failed to request username for ip " << identification.ip);
         throw HueException(CURRENT_FILE_INFO, "Failed to request username!");
     }
     AddUsername(normalizedMac, bridge.getUsername());
@@ -146,6 +152,69 @@ Hue::Hue(
       commands(ip, port, username, http_handler)
 {}
 
+Hue::Hue(const Hue& other)
+    : ip(other.ip),
+      username(other.username),
+      port(other.port),
+      stateMaxAge(other.stateMaxAge),
+      poller(other.poller),
+      simpleBrightnessStrategy(other.simpleBrightnessStrategy),
+      simpleColorHueStrategy(other.simpleColorHueStrategy),
+      extendedColorHueStrategy(other.extendedColorHueStrategy),
+      simpleColorTemperatureStrategy(other.simpleColorTemperatureStrategy),
+      extendedColorTemperatureStrategy(other.extendedColorTemperatureStrategy),
+      http_handler(other.http_handler),
+      commands(other.commands)
+{
+    published->state = other.getStateSnapshot();
+    published->lights = std::make_shared<const LightMap>(CopyLights(*other.published->lights));
+    if (poller)
+    {
+        AddUpdateHandler();
+    }
+}
+
+Hue& Hue::operator=(const Hue& other)
+{
+    if (this != &other)
+    {
+        if (poller)
+        {
+            poller->removeUpdateHandler(updateHandler);
+        }
+        ip = other.ip;
+        username = other.username;
+        port = other.port;
+        {
+            std::lock_guard<std::mutex> lock(published->mutex);
+            std::atomic_store(&published->state, other.getStateSnapshot());
+        }
+        stateMaxAge = other.stateMaxAge;
+        poller = other.poller;
+        simpleBrightnessStrategy = other.simpleBrightnessStrategy;
+        simpleColorHueStrategy = other.simpleColorHueStrategy;
+        extendedColorHueStrategy = other.extendedColorHueStrategy;
+        simpleColorTemperatureStrategy = other.simpleColorTemperatureStrategy;
+        extendedColorTemperatureStrategy = other.extendedColorTemperatureStrategy;
+        http_handler = other.http_handler;
+        commands = other.commands;
+        PublishLights(CopyLights(*other.published->lights));
+        if (poller)
+        {
+            AddUpdateHandler();
+        }
+    }
+    return *this;
+}
+
+Hue::~Hue()
+{
+    if (poller)
+    {
+        poller->removeUpdateHandler(updateHandler);
+    }
+}
+
 std::string Hue::getBridgeIP()
 {
     return ip;
@@ -158,14 +227,8 @@ int Hue::getBridgePort()
 
 std::string Hue::requestUsername()
 {
-    std::cout << "Please press the link Button! You've got 35 secs!\n"; // when the link
-                                                                        // button was
-                                                                        // pressed we
-                                                                        // got 30
-                                                                        // seconds to
-                                                                        // get our
-                                                                        // username for
-                                                                        // control
+    // when the link button was pressed we got 30 seconds to get our username for control
+    HUE_LOG(LogLevel::info, "Please press the link Button! You've got 35 secs!");
 
     nlohmann::json request;
     request["devicetype"] = "HuePlusPlus#User";
@@ -186,8 +249,8 @@ std::string Hue::requestUsername()
                 username = jsonUser;
                 // Update commands with new username and ip
                 commands = HueCommandAPI(ip, port, username, http_handler);
-                std::cout << "Success! Link button was pressed!\n";
-                std::cout << "Username is \"" << username << "\"\n";
+                HUE_LOG(LogLevel::info, "Success! Link button was pressed!");
+                HUE_LOG(LogLevel::info, "Username is \"" << username << "\"");
                 break;
             }
             else if (answer.size() > 0 && answer[0].count("error"))
@@ -222,73 +285,25 @@ void Hue::setPort(const int port)
 
 HueLight& Hue::getLight(int id)
 {
+    const LightMap& lights = *published->lights;
     auto pos = lights.find(id);
     if (pos != lights.end())
     {
-        pos->second.refreshState();
-        return pos->second;
+        pos->second->refreshState();
+        return *pos->second;
     }
     refreshState();
-    if (!state["lights"].count(std::to_string(id)))
+    const nlohmann::json lightState = utils::safeGetMember(*getStateSnapshot(), "lights", std::to_string(id));
+    if (lightState.is_null())
     {
-        std::cerr << "Error in Hue getLight(): light with id " << id << " is not valid\n";
+        HUE_LOG(LogLevel::error, "Error in Hue getLight(): light with id " << id << " is not valid");
         throw HueException(CURRENT_FILE_INFO, "Light id is not valid");
     }
-    // std::cout << state["lights"][std::to_string(id)] << std::endl;
-    std::string type = state["lights"][std::to_string(id)]["modelid"];
-    // std::cout << type << std::endl;
-    if (type == "LCT001" || type == "LCT002" || type == "LCT003" || type == "LCT007" || type == "LLM001")
-    {
-        // HueExtendedColorLight Gamut B
-        HueLight light = HueLight(
-            id, commands, simpleBrightnessStrategy, extendedColorTemperatureStrategy, extendedColorHueStrategy);
-        light.colorType = ColorType::GAMUT_B;
-        lights.emplace(id, light);
-        return lights.find(id)->second;
-    }
-    else if (type == "LCT010" || type == "LCT011" || type == "LCT012" || type == "LCT014" || type == "LCT015"
-        || type == "LCT016" || type == "LLC020" || type == "LST002")
-    {
-        // HueExtendedColorLight Gamut C
-        HueLight light = HueLight(
-            id, commands, simpleBrightnessStrategy, extendedColorTemperatureStrategy, extendedColorHueStrategy);
-        light.colorType = ColorType::GAMUT_C;
-        lights.emplace(id, light);
-        return lights.find(id)->second;
-    }
-    else if (type == "LST001" || type == "LLC005" || type == "LLC006" || type == "LLC007" || type == "LLC010"
-        || type == "LLC011" || type == "LLC012" || type == "LLC013" || type == "LLC014")
-    {
-        // HueColorLight Gamut A
-        HueLight light = HueLight(id, commands, simpleBrightnessStrategy, nullptr, simpleColorHueStrategy);
-        light.colorType = ColorType::GAMUT_A;
-        lights.emplace(id, light);
-        return lights.find(id)->second;
-    }
-    else if (type == "LWB004" || type == "LWB006" || type == "LWB007" || type == "LWB010" || type == "LWB014"
-        || type == "LDF001" || type == "LDF002" || type == "LDD001" || type == "LDD002" || type == "MWM001")
-    {
-        // HueDimmableLight No Color Type
-        HueLight light = HueLight(id, commands, simpleBrightnessStrategy, nullptr, nullptr);
-        light.colorType = ColorType::NONE;
-        lights.emplace(id, light);
-        return lights.find(id)->second;
-    }
-    else if (type == "LLM010" || type == "LLM011" || type == "LLM012" || type == "LTW001" || type == "LTW004"
-        || type == "LTW010" || type == "LTW011" || type == "LTW012" || type == "LTW013" || type == "LTW014"
-        || type == "LTW015" || type == "LTP001" || type == "LTP002" || type == "LTP003" || type == "LTP004"
-        || type == "LTP005" || type == "LTD003" || type == "LTF001" || type == "LTF002" || type == "LTC001"
-        || type == "LTC002" || type == "LTC003" || type == "LTC004" || type == "LTC011" || type == "LTC012"
-        || type == "LTD001" || type == "LTD002" || type == "LFF001" || type == "LTT001" || type == "LDT001")
-    {
-        // HueTemperatureLight
-        HueLight light = HueLight(id, commands, simpleBrightnessStrategy, simpleColorTemperatureStrategy, nullptr);
-        light.colorType = ColorType::TEMPERATURE;
-        lights.emplace(id, light);
-        return lights.find(id)->second;
-    }
-    std::cerr << "Could not determine HueLight type:" << type << "!\n";
-    throw HueException(CURRENT_FILE_INFO, "Could not determine HueLight type!");
+    std::shared_ptr<HueLight> light = CreateLight(id, lightState);
+    LightMap next = lights;
+    next.emplace(id, light);
+    PublishLights(std::move(next));
+    return *light;
 }
 
 bool Hue::removeLight(int id)
@@ -296,67 +311,127 @@ bool Hue::removeLight(int id)
     nlohmann::json result
         = commands.DELETERequest("/lights/" + std::to_string(id), nlohmann::json::object(), CURRENT_FILE_INFO);
     bool success = utils::safeGetMember(result, 0, "success") == "/lights/" + std::to_string(id) + " deleted";
-    if (success && lights.count(id) != 0)
+    if (success && published->lights->count(id) != 0)
     {
-        lights.erase(id);
+        LightMap next = *published->lights;
+        next.erase(id);
+        PublishLights(std::move(next));
     }
     return success;
 }
 
 std::vector<std::reference_wrapper<HueLight>> Hue::getAllLights()
 {
-    refreshState();
-    nlohmann::json lightsState = state["lights"];
-    for (nlohmann::json::iterator it = lightsState.begin(); it != lightsState.end(); ++it)
-    {
-        getLight(std::stoi(it.key()));
-    }
+    refreshAllLights();
     std::vector<std::reference_wrapper<HueLight>> result;
-    for (auto& entry : lights)
+    for (const auto& entry : *published->lights)
     {
-        result.emplace_back(entry.second);
+        result.emplace_back(*entry.second);
     }
     return result;
 }
 
-bool Hue::lightExists(int id)
+void Hue::refreshAllLights()
 {
     refreshState();
-    auto pos = lights.find(id);
-    if (pos != lights.end())
+    UpdateLights();
+}
+
+void Hue::setStateMaxAge(std::chrono::milliseconds maxAge)
+{
+    stateMaxAge = maxAge;
+    for (const auto& entry : *published->lights)
     {
-        return true;
+        entry.second->setStateMaxAge(maxAge);
+    }
+}
+
+std::chrono::milliseconds Hue::getStateMaxAge() const
+{
+    return stateMaxAge;
+}
+
+StatePoller& Hue::startPolling(std::chrono::milliseconds interval)
+{
+    if (poller)
+    {
+        poller->setInterval(interval);
+        return *poller;
     }
-    if (state["lights"].count(std::to_string(id)))
+    poller = std::make_shared<StatePoller>(commands, interval);
+    AddUpdateHandler();
+    for (const auto& entry : *published->lights)
     {
-        return true;
+        entry.second->poller = poller;
     }
-    return false;
+    return *poller;
 }
 
-bool Hue::lightExists(int id) const
+void Hue::stopPolling()
 {
-    auto pos = lights.find(id);
-    if (pos != lights.end())
+    if (!poller)
+    {
+        return;
+    }
+    poller->removeUpdateHandler(updateHandler);
+    poller->stop();
+    poller = nullptr;
+    for (const auto& entry : *published->lights)
+    {
+        entry.second->poller = nullptr;
+    }
+}
+
+StatePoller* Hue::getPoller() const
+{
+    return poller.get();
+}
+
+bool Hue::lightExists(int id)
+{
+    refreshState();
+    if (published->lights->count(id))
     {
         return true;
     }
-    if (state["lights"].count(std::to_string(id)))
+    return utils::safeGetMember(*getStateSnapshot(), "lights", std::to_string(id)) != nullptr;
+}
+
+bool Hue::lightExists(int id) const
+{
+    if (findLight(id))
     {
         return true;
     }
-    return false;
+    const std::shared_ptr<const nlohmann::json> current = getStateSnapshot();
+    auto lightsIt = current->find("lights");
+    return lightsIt != current->end() && lightsIt->count(std::to_string(id));
 }
 
 std::string Hue::getPictureOfLight(int id) const
 {
-    std::string ret = "";
-    auto pos = lights.find(id);
-    if (pos != lights.end())
+    const nlohmann::json modelId = utils::safeGetMember(*getStateSnapshot(), "lights", std::to_string(id), "modelid");
+    if (modelId.is_string())
     {
-        ret = getPictureOfModel(pos->second.getModelId());
+        return getPictureOfModel(modelId.get<std::string>());
     }
-    return ret;
+    return "";
+}
+
+std::shared_ptr<const HueLight> Hue::findLight(int id) const
+{
+    const std::shared_ptr<const LightMap> current = std::atomic_load(&published->lights);
+    auto pos = current->find(id);
+    if (pos == current->end())
+    {
+        return nullptr;
+    }
+    return pos->second;
+}
+
+std::shared_ptr<const nlohmann::json> Hue::getStateSnapshot() const
+{
+    return std::atomic_load(&published->state);
 }
 
 std::string Hue::getPictureOfModel(const std::string& model_id) const
@@ -492,12 +567,143 @@ void Hue::refreshState()
     nlohmann::json answer = commands.GETRequest("", nlohmann::json::object(), CURRENT_FILE_INFO);
     if (answer.is_object() && answer.count("lights"))
     {
-        state = answer;
+        std::lock_guard<std::mutex> lock(published->mutex);
+        std::atomic_store(&published->state, std::make_shared<const nlohmann::json>(std::move(answer)));
     }
     else
     {
-        std::cout << "Answer in Hue::refreshState of http_handler->GETJson(...) is "
-                     "not expected!\nAnswer:\n\t"
-                  << answer.dump() << std::endl;
+        HUE_LOG(LogLevel::warning,
+            "Answer in Hue::refreshState of http_handler->GETJson(...) is not expected!\nAnswer:\n\t" << answer.dump());
+    }
+}
+
+std::shared_ptr<HueLight> Hue::CreateLight(int id, const nlohmann::json& lightState)
+{
+    std::string type = lightState.value("modelid", "");
+    std::shared_ptr<HueLight> light;
+    if (type == "LCT001" || type == "LCT002" || type == "LCT003" || type == "LCT007" || type == "LLM001")
+    {
+        // HueExtendedColorLight Gamut B
+        light.reset(new HueLight(id, commands, simpleBrightnessStrategy, extendedColorTemperatureStrategy,
+            extendedColorHueStrategy, lightState));
+        light->colorType = ColorType::GAMUT_B;
+    }
+    else if (type == "LCT010" || type == "LCT011" || type == "LCT012" || type == "LCT014" || type == "LCT015"
+        || type == "LCT016" || type == "LLC020" || type == "LST002")
+    {
+        // HueExtendedColorLight Gamut C
+        light.reset(new HueLight(id, commands, simpleBrightnessStrategy, extendedColorTemperatureStrategy,
+            extendedColorHueStrategy, lightState));
+        light->colorType = ColorType::GAMUT_C;
     }
+    else if (type == "LST001" || type == "LLC005" || type == "LLC006" || type == "LLC007" || type == "LLC010"
+        || type == "LLC011" || type == "LLC012" || type == "LLC013" || type == "LLC014")
+    {
+        // HueColorLight Gamut A
+        light.reset(
+            new HueLight(id, commands, simpleBrightnessStrategy, nullptr, simpleColorHueStrategy, lightState));
+        light->colorType = ColorType::GAMUT_A;
+    }
+    else if (type == "LWB004" || type == "LWB006" || type == "LWB007" || type == "LWB010" || type == "LWB014"
+        || type == "LDF001" || type == "LDF002" || type == "LDD001" || type == "LDD002" || type == "MWM001")
+    {
+        // HueDimmableLight No Color Type
+        light.reset(new HueLight(id, commands, simpleBrightnessStrategy, nullptr, nullptr, lightState));
+        light->colorType = ColorType::NONE;
+    }
+    else if (type == "LLM010" || type == "LLM011" || type == "LLM012" || type == "LTW001" || type == "LTW004"
+        || type == "LTW010" || type == "LTW011" || type == "LTW012" || type == "LTW013" || type == "LTW014"
+        || type == "LTW015" || type == "LTP001" || type == "LTP002" || type == "LTP003" || type == "LTP004"
+        || type == "LTP005" || type == "LTD003" || type == "LTF001" || type == "LTF002" || type == "LTC001"
+        || type == "LTC002" || type == "LTC003" || type == "LTC004" || type == "LTC011" || type == "LTC012"
+        || type == "LTD001" || type == "LTD002" || type == "LFF001" || type == "LTT001" || type == "LDT001")
+    {
+        // HueTemperatureLight
+        light.reset(new HueLight(
+            id, commands, simpleBrightnessStrategy, simpleColorTemperatureStrategy, nullptr, lightState));
+        light->colorType = ColorType::TEMPERATURE;
+    }
+    else
+    {
+        HUE_LOG(LogLevel::error, "Could not determine HueLight type:" << type << "!");
+        throw HueException(CURRENT_FILE_INFO, "Could not determine HueLight type!");
+    }
+    light->stateMaxAge = stateMaxAge;
+    light->poller = poller;
+    return light;
+}
+
+void Hue::UpdateLights()
+{
+    const std::shared_ptr<const nlohmann::json> current = getStateSnapshot();
+    auto lightsIt = current->find("lights");
+    if (lightsIt == current->end() || !lightsIt->is_object())
+    {
+        return;
+    }
+    const nlohmann::json& lightsState = *lightsIt;
+    const LightMap& lights = *published->lights;
+    // Lights that are missing from the state were deleted
+    LightMap next;
+    for (auto it = lightsState.begin(); it != lightsState.end(); ++it)
+    {
+        const int id = std::stoi(it.key());
+        auto pos = lights.find(id);
+        if (pos == lights.end())
+        {
+            next.emplace(id, CreateLight(id, it.value()));
+            continue;
+        }
+        if (it->count("state"))
+        {
+            pos->second->state = it.value();
+            pos->second->lastStateUpdate = std::chrono::steady_clock::now();
+            pos->second->stateOutdated = false;
+            pos->second->PublishState();
+        }
+        next.emplace(id, pos->second);
+    }
+    PublishLights(std::move(next));
+}
+
+Hue::LightMap Hue::CopyLights(const LightMap& source)
+{
+    LightMap copies;
+    for (const auto& entry : source)
+    {
+        copies.emplace(entry.first, std::make_shared<HueLight>(*entry.second));
+    }
+    return copies;
+}
+
+void Hue::PublishLights(LightMap next)
+{
+    std::atomic_store(&published->lights, std::make_shared<const LightMap>(std::move(next)));
+}
+
+void Hue::AddUpdateHandler()
+{
+    // The handler must not use this, because the poller may outlive it
+    std::weak_ptr<Published> target = published;
+    updateHandler = poller->addUpdateHandler([target](const nlohmann::json& polledLights) {
+        std::shared_ptr<Published> current = target.lock();
+        if (!current)
+        {
+            return;
+        }
+        for (const auto& entry : *std::atomic_load(&current->lights))
+        {
+            auto it = polledLights.find(std::to_string(entry.first));
+            if (it != polledLights.end() && it->count("state"))
+            {
+                // The thread that uses the light adopts the polled state in HueLight::refreshState
+                std::atomic_store(&entry.second->snapshot, std::make_shared<const nlohmann::json>(*it));
+            }
+        }
+        std::lock_guard<std::mutex> lock(current->mutex);
+        const std::shared_ptr<const nlohmann::json> previous = std::atomic_load(&current->state);
+        nlohmann::json next = previous->is_object() ? *previous : nlohmann::json::object();
+        next["lights"] = polledLights;
+        std::atomic_store(&current->state, std::make_shared<const nlohmann::json>(std::move(next)));
+    });
 }
@@ -22,56 +22,615 @@
 
 #include "include/HueCommandAPI.h"
 
+#include <future>
+#include <map>
+#include <memory>
+#include <system_error>
 #include <thread>
+#include <tuple>
 
 #include "include/HueExceptionMacro.h"
+#include "include/Log.h"
+#include "include/RequestOptions.h"
+#include "include/RequestMetrics.h"
+#include "include/RequestScheduler.h"
+#include "include/SyncHttpHandler.h"
+#include "include/Trace.h"
 
 constexpr std::chrono::steady_clock::duration HueCommandAPI::minDelay;
+constexpr std::chrono::steady_clock::duration HueCommandAPI::groupMinDelay;
 
 namespace
 {
-    // Runs functor with appropriate timeout and retries when timed out or connection reset
-    template <typename Timeout, typename Fun>
-    nlohmann::json RunWithTimeout(
-        std::shared_ptr<Timeout> timeout, std::chrono::steady_clock::duration minDelay, Fun fun)
+    // Whether the response is an internal error (901) of the bridge, which happens when it is overloaded
+    bool IsInternalError(const nlohmann::json& response)
     {
-        auto now = std::chrono::steady_clock::now();
-        std::lock_guard<std::mutex> lock(timeout->mutex);
-        if (timeout->timeout > now)
+        const nlohmann::json& entry = response.is_array() && !response.empty() ? response[0] : response;
+        if (!entry.is_object())
         {
-            std::this_thread::sleep_until(timeout->timeout);
+            return false;
         }
+        auto error = entry.find("error");
+        return error != entry.end() && error->is_object() && error->value("type", 0) == 901;
+    }
+    bool IsInternalError(bool)
+    {
+        return false;
+    }
+
+    // Records the time since start as network time of an attempt, without the parse time of the handler
+    std::chrono::steady_clock::duration RecordAttempt(
+        RequestMetrics::Endpoint& endpoint, std::chrono::steady_clock::time_point start)
+    {
+        const std::chrono::steady_clock::duration parse = RequestMetrics::takeParseTime();
+        const std::chrono::steady_clock::duration latency = std::chrono::steady_clock::now() - start - parse;
+        endpoint.recordParse(parse);
+        endpoint.recordNetwork(latency);
+        return latency;
+    }
+
+    // Runs functor and reports its latency or the signs of an overloaded bridge to the pacer
+    template <typename Fun>
+    auto RunMeasured(AdaptivePacer& pacer, RequestMetrics::Endpoint& endpoint, Fun& fun) -> decltype(fun())
+    {
+        // Discard parse time of requests that were not measured
+        RequestMetrics::takeParseTime();
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
         try
         {
-            nlohmann::json response = fun();
-            timeout->timeout = now + minDelay;
-            return response;
+            auto result = fun();
+            const std::chrono::steady_clock::duration latency = RecordAttempt(endpoint, start);
+            if (IsInternalError(result))
+            {
+                pacer.onStress();
+            }
+            else
+            {
+                pacer.onResponse(latency);
+            }
+            return result;
         }
         catch (const std::system_error& e)
         {
+            RecordAttempt(endpoint, start);
             if (e.code() == std::errc::connection_reset || e.code() == std::errc::timed_out)
             {
-                // Happens when hue is too busy, wait and try again (once)
-                std::this_thread::sleep_for(minDelay);
-                nlohmann::json v = fun();
-                timeout->timeout = std::chrono::steady_clock::now() + minDelay;
-                return v;
+                pacer.onStress();
             }
-            // Cannot recover from other types of errors
             throw;
         }
+        catch (...)
+        {
+            RecordAttempt(endpoint, start);
+            throw;
+        }
+    }
+
+    // Records the time of a whole call when destroyed
+    class TotalTimer
+    {
+    public:
+        explicit TotalTimer(RequestMetrics::Endpoint& endpoint)
+            : endpoint(endpoint), start(std::chrono::steady_clock::now())
+        {}
+        ~TotalTimer() { endpoint.recordTotal(std::chrono::steady_clock::now() - start); }
+
+        TotalTimer(const TotalTimer&) = delete;
+        TotalTimer& operator=(const TotalTimer&) = delete;
+
+    private:
+        RequestMetrics::Endpoint& endpoint;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // Fills in failure when the response is an error of the bridge
+    bool GetAPIError(const nlohmann::json& response, RetryPolicy::Failure& failure)
+    {
+        const nlohmann::json& entry = response.is_array() && !response.empty() ? response[0] : response;
+        if (!entry.is_object())
+        {
+            return false;
+        }
+        auto error = entry.find("error");
+        if (error == entry.end())
+        {
+            return false;
+        }
+        failure.type = RetryPolicy::ErrorType::api;
+        failure.apiError = error->is_object() ? error->value("type", 0) : 0;
+        return true;
+    }
+    bool GetAPIError(bool, RetryPolicy::Failure&)
+    {
+        return false;
+    }
+
+    // Counts the response as success or error of the bridge
+    void RecordOutcome(RequestMetrics::Endpoint& endpoint, const nlohmann::json& response)
+    {
+        RetryPolicy::Failure failure;
+        if (GetAPIError(response, failure))
+        {
+            endpoint.recordAPIError(failure.apiError);
+        }
+        else
+        {
+            endpoint.recordSuccess();
+        }
+    }
+    // Outcome of SAX requests is only known to the caller
+    void RecordOutcome(RequestMetrics::Endpoint&, bool) {}
+
+    // Runs functor with appropriate timeout and retries as long as the policy allows.
+    // Requests wait for their turn in the scheduler, which does not hold a lock while they wait or run,
+    // so requests of several threads can be in flight at the same time (and pipelined by the handler).
+    // The deadline covers the whole call including the delay and the retries.
+    template <typename Fun>
+    auto RunWithTimeout(RequestScheduler& scheduler, RequestMetrics::Endpoint& endpoint, const RetryPolicy& policy,
+        bool idempotent, std::chrono::steady_clock::duration requestTimeout, Fun fun) -> decltype(fun())
+    {
+        const TotalTimer timer(endpoint);
+        const RequestOptions::Scope scope(RequestOptions::withTimeout(requestTimeout));
+        const RequestOptions& options = RequestOptions::current();
+        const RequestOptions::Clock::time_point deadline = options.deadline;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration delay = std::chrono::steady_clock::duration::zero();
+        // Asks the policy and decides whether the next attempt can be made before the deadline
+        const auto retry = [&](RetryPolicy::Failure& failure, unsigned int attempt) {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            failure.attempt = attempt;
+            failure.idempotent = idempotent;
+            failure.elapsed = now - start;
+            failure.interval = scheduler.getRateLimiter().getInterval();
+            if (!policy.shouldRetry(failure, delay) || now + delay >= deadline)
+            {
+                return false;
+            }
+            endpoint.recordRetry();
+            HUE_LOG(LogLevel::debug,
+                "HueCommandAPI: Attempt " << attempt << " failed, retrying in "
+                                          << std::chrono::duration_cast<std::chrono::milliseconds>(delay).count()
+                                          << " ms");
+            return true;
+        };
+        for (unsigned int attempt = 1;; ++attempt)
+        {
+            const std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+            try
+            {
+                scheduler.wait(options.priority, deadline);
+            }
+            catch (...)
+            {
+                endpoint.recordQueueWait(std::chrono::steady_clock::now() - waitStart);
+                endpoint.recordFailure();
+                throw;
+            }
+            endpoint.recordQueueWait(std::chrono::steady_clock::now() - waitStart);
+            RetryPolicy::Failure failure;
+            try
+            {
+                auto result = RunMeasured(scheduler.getPacer(), endpoint, fun);
+                if (!GetAPIError(result, failure) || !retry(failure, attempt))
+                {
+                    RecordOutcome(endpoint, result);
+                    return result;
+                }
+            }
+            catch (const std::system_error& e)
+            {
+                failure.type = RetryPolicy::ErrorType::transport;
+                failure.code = e.code();
+                if (!retry(failure, attempt))
+                {
+                    endpoint.recordFailure();
+                    throw;
+                }
+            }
+            catch (const HueException&)
+            {
+                failure.type = RetryPolicy::ErrorType::http;
+                if (!retry(failure, attempt))
+                {
+                    endpoint.recordFailure();
+                    throw;
+                }
+            }
+            catch (const nlohmann::json::exception&)
+            {
+                failure.type = RetryPolicy::ErrorType::http;
+                if (!retry(failure, attempt))
+                {
+                    endpoint.recordFailure();
+                    throw;
+                }
+            }
+            catch (...)
+            {
+                endpoint.recordFailure();
+                throw;
+            }
+            std::this_thread::sleep_for(delay);
+        }
+    }
+
+    // Whether path is the state of a single light, like "/lights/1/state"
+    bool IsLightStatePath(const std::string& path)
+    {
+        const std::size_t start = path.empty() || path.front() != '/' ? 0 : 1;
+        const std::string prefix = "lights/";
+        const std::string suffix = "/state";
+        if (path.compare(start, prefix.size(), prefix) != 0 || path.size() <= start + prefix.size() + suffix.size()
+            || path.compare(path.size() - suffix.size(), suffix.size(), suffix) != 0)
+        {
+            return false;
+        }
+        const std::string id = path.substr(start + prefix.size(), path.size() - suffix.size() - start - prefix.size());
+        return id.find('/') == std::string::npos;
+    }
+
+    // Whether a light state change can be merged with others.
+    // Alerts are actions and increments depend on the previous value, so they must be sent as they are.
+    bool CanMerge(const nlohmann::json& request)
+    {
+        if (!request.is_object() || request.empty())
+        {
+            return false;
+        }
+        for (auto it = request.begin(); it != request.end(); ++it)
+        {
+            const std::string& key = it.key();
+            if (key == "alert" || (key.size() > 4 && key.compare(key.size() - 4, 4, "_inc") == 0))
+            {
+                return false;
+            }
+        }
+        return true;
     }
+
+    // Merges a later light state change into pending, so that its values win
+    void MergeInto(nlohmann::json& pending, const nlohmann::json& request)
+    {
+        // The bridge prefers xy over ct over hue and sat, so an earlier color mode would override the later one
+        if (request.count("xy"))
+        {
+            pending.erase("ct");
+            pending.erase("hue");
+            pending.erase("sat");
+        }
+        if (request.count("ct"))
+        {
+            pending.erase("xy");
+            pending.erase("hue");
+            pending.erase("sat");
+        }
+        if (request.count("hue") || request.count("sat"))
+        {
+            pending.erase("xy");
+            pending.erase("ct");
+        }
+        // The latest explicit transitiontime applies, the default only when no merged change has one
+        pending.update(request);
+    }
+
+    // Returns the entries of a response that belong to the attributes of request.
+    // Entries look like {"success": {"/lights/1/state/bri": 100}} or {"error": {"address": "/lights/1/state/bri"}}.
+    nlohmann::json FilterResponse(const nlohmann::json& response, const nlohmann::json& request)
+    {
+        if (!response.is_array())
+        {
+            return response;
+        }
+        const auto belongsToRequest = [&](const std::string& address) {
+            const std::size_t slash = address.rfind('/');
+            return request.count(slash == std::string::npos ? address : address.substr(slash + 1)) != 0;
+        };
+        nlohmann::json result = nlohmann::json::array();
+        for (const nlohmann::json& entry : response)
+        {
+            auto success = entry.find("success");
+            auto error = entry.find("error");
+            if (success != entry.end() && success->is_object() && success->size() == 1)
+            {
+                if (belongsToRequest(success->begin().key()))
+                {
+                    result.push_back(entry);
+                }
+            }
+            else if (error != entry.end() && error->is_object() && error->count("address"))
+            {
+                if (belongsToRequest(error->at("address").get<std::string>()))
+                {
+                    result.push_back(entry);
+                }
+            }
+            else
+            {
+                result.push_back(entry);
+            }
+        }
+        return result.empty() ? response : result;
+    }
+
+    // Passes SAX events on to another handler and keeps the first error object of the bridge
+    class ErrorCheckingSax : public nlohmann::json::json_sax_t
+    {
+    public:
+        explicit ErrorCheckingSax(nlohmann::json::json_sax_t& handler)
+            : handler(handler),
+              depth(0),
+              topArray(false),
+              topElements(0),
+              errorPending(false),
+              captureDepth(0),
+              events(false),
+              hasError(false)
+        {}
+
+        // Whether any event was passed on
+        bool hasEvents() const { return events; }
+        // Response in the form {"error": {...}} that is understood by HueAPIResponseException::Create
+        nlohmann::json getError() const { return hasError ? nlohmann::json {{"error", error}} : nlohmann::json(); }
+
+        bool null() override
+        {
+            scalar([&] { capture->null(); });
+            return handler.null();
+        }
+        bool boolean(bool val) override
+        {
+            scalar([&] { capture->boolean(val); });
+            return handler.boolean(val);
+        }
+        bool number_integer(number_integer_t val) override
+        {
+            scalar([&] { capture->number_integer(val); });
+            return handler.number_integer(val);
+        }
+        bool number_unsigned(number_unsigned_t val) override
+        {
+            scalar([&] { capture->number_unsigned(val); });
+            return handler.number_unsigned(val);
+        }
+        bool number_float(number_float_t val, const string_t& s) override
+        {
+            scalar([&] { capture->number_float(val, s); });
+            return handler.number_float(val, s);
+        }
+        bool string(string_t& val) override
+        {
+            scalar([&] { capture->string(val); });
+            return handler.string(val);
+        }
+        bool start_object(std::size_t elements) override
+        {
+            startContainer(false, [&] { capture->start_object(elements); });
+            return handler.start_object(elements);
+        }
+        bool key(string_t& val) override
+        {
+            events = true;
+            if (capture)
+            {
+                capture->key(val);
+            }
+            else
+            {
+                // Errors are {"error": {...}} or [{"error": {...}}, ...]
+                errorPending = !hasError && val == "error"
+                    && ((depth == 1 && !topArray) || (depth == 2 && topArray && topElements == 1));
+            }
+            return handler.key(val);
+        }
+        bool end_object() override
+        {
+            endContainer([&] { capture->end_object(); });
+            return handler.end_object();
+        }
+        bool start_array(std::size_t elements) override
+        {
+            startContainer(true, [&] { capture->start_array(elements); });
+            return handler.start_array(elements);
+        }
+        bool end_array() override
+        {
+            endContainer([&] { capture->end_array(); });
+            return handler.end_array();
+        }
+        bool parse_error(
+            std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& ex) override
+        {
+            return handler.parse_error(position, lastToken, ex);
+        }
+
+    private:
+        void beginValue()
+        {
+            events = true;
+            if (depth == 1 && topArray)
+            {
+                ++topElements;
+            }
+            if (errorPending)
+            {
+                errorPending = false;
+                hasError = true;
+                capture.reset(new nlohmann::detail::json_sax_dom_parser<nlohmann::json>(error));
+            }
+        }
+        template <typename F>
+        void scalar(F forward)
+        {
+            beginValue();
+            if (capture)
+            {
+                forward();
+                if (captureDepth == 0)
+                {
+                    capture.reset();
+                }
+            }
+        }
+        template <typename F>
+        void startContainer(bool array, F forward)
+        {
+            beginValue();
+            if (depth == 0)
+            {
+                topArray = array;
+            }
+            ++depth;
+            if (capture)
+            {
+                forward();
+                ++captureDepth;
+            }
+        }
+        template <typename F>
+        void endContainer(F forward)
+        {
+            --depth;
+            if (capture)
+            {
+                forward();
+                if (--captureDepth == 0)
+                {
+                    capture.reset();
+                }
+            }
+        }
+
+    private:
+        nlohmann::json::json_sax_t& handler;
+        std::size_t depth;
+        bool topArray;
+        std::size_t topElements;
+        bool errorPending;
+        std::size_t captureDepth;
+        bool events;
+        bool hasError;
+        nlohmann::json error;
+        std::unique_ptr<nlohmann::detail::json_sax_dom_parser<nlohmann::json>> capture;
+    };
 } // namespace
 
+struct HueCommandAPI::PendingWrites
+{
+    // Merged change that is sent by the first caller, the others wait for its response
+    struct Write
+    {
+        nlohmann::json request;
+        std::promise<nlohmann::json> response;
+        std::shared_future<nlohmann::json> result = response.get_future().share();
+    };
+
+    std::mutex mutex;
+    // Changes that were not sent yet by priority and path
+    std::map<std::pair<RequestOptions::Priority, std::string>, std::shared_ptr<Write>> writes;
+};
+
+struct HueCommandAPI::PendingReads
+{
+    // Request that is sent by the first caller, the others wait for its response
+    struct Read
+    {
+        std::promise<nlohmann::json> response;
+        std::shared_future<nlohmann::json> result = response.get_future().share();
+    };
+
+    std::mutex mutex;
+    // Requests that were not answered yet by priority, path and body
+    std::map<std::tuple<RequestOptions::Priority, std::string, std::string>, std::shared_ptr<Read>> reads;
+};
+
 HueCommandAPI::HueCommandAPI(
     const std::string& ip, const int port, const std::string& username, std::shared_ptr<const IHttpHandler> httpHandler)
     : ip(ip),
       port(port),
       username(username),
       httpHandler(std::move(httpHandler)),
-      timeout(new TimeoutData{std::chrono::steady_clock::now(), {}})
+      schedulers(std::make_shared<Schedulers>()),
+      pendingWrites(std::make_shared<PendingWrites>()),
+      pendingReads(std::make_shared<PendingReads>()),
+      metrics(std::make_shared<RequestMetrics>()),
+      traceChain(std::make_shared<TraceChain>()),
+      requestTimeout(std::chrono::steady_clock::duration::zero())
+{}
+
+HueCommandAPI::HueCommandAPI(const std::string& ip, const int port, const std::string& username,
+    std::shared_ptr<const IAsyncHttpHandler> asyncHandler)
+    : HueCommandAPI(ip, port, username, std::make_shared<SyncHttpHandler>(std::move(asyncHandler)))
 {}
 
+void HueCommandAPI::setTimeout(std::chrono::steady_clock::duration timeout)
+{
+    requestTimeout = timeout;
+}
+
+void HueCommandAPI::setBurst(std::size_t burst)
+{
+    schedulers->lights.getRateLimiter().setBurst(burst);
+    schedulers->groups.getRateLimiter().setBurst(burst);
+    schedulers->other.getRateLimiter().setBurst(burst);
+}
+
+void HueCommandAPI::setBurst(RequestType type, std::size_t burst)
+{
+    GetScheduler(type).getRateLimiter().setBurst(burst);
+}
+
+void HueCommandAPI::setMinDelay(RequestType type, std::chrono::steady_clock::duration delay)
+{
+    GetScheduler(type).getRateLimiter().setInterval(delay);
+}
+
+std::chrono::steady_clock::duration HueCommandAPI::getMinDelay(RequestType type) const
+{
+    return GetScheduler(type).getRateLimiter().getInterval();
+}
+
+void HueCommandAPI::setAdaptivePacing(RequestType type, const AdaptivePacer::Settings& settings)
+{
+    GetScheduler(type).getPacer().setSettings(settings);
+}
+
+double HueCommandAPI::getRequestRate(RequestType type) const
+{
+    return GetScheduler(type).getPacer().getRate();
+}
+
+std::chrono::steady_clock::duration HueCommandAPI::getLatency(RequestType type) const
+{
+    return GetScheduler(type).getPacer().getLatency();
+}
+
+void HueCommandAPI::setRetryPolicy(std::shared_ptr<const RetryPolicy> policy)
+{
+    std::atomic_store(&schedulers->retryPolicy, policy ? std::move(policy) : std::make_shared<RetryPolicy>());
+}
+
+std::shared_ptr<const RetryPolicy> HueCommandAPI::getRetryPolicy() const
+{
+    return std::atomic_load(&schedulers->retryPolicy);
+}
+
+const RequestMetrics& HueCommandAPI::getMetrics() const
+{
+    return *metrics;
+}
+
+TraceChain& HueCommandAPI::getTraceChain() const
+{
+    return *traceChain;
+}
+
+void HueCommandAPI::setAgingDelay(std::chrono::steady_clock::duration delay)
+{
+    schedulers->lights.setAgingDelay(delay);
+    schedulers->groups.setAgingDelay(delay);
+    schedulers->other.setAgingDelay(delay);
+}
+
 nlohmann::json HueCommandAPI::PUTRequest(const std::string& path, const nlohmann::json& request) const
 {
     return PUTRequest(path, request, CURRENT_FILE_INFO);
@@ -80,8 +639,16 @@ nlohmann::json HueCommandAPI::PUTRequest(const std::string& path, const nlohmann
 nlohmann::json HueCommandAPI::PUTRequest(
     const std::string& path, const nlohmann::json& request, FileInfo fileInfo) const
 {
-    return HandleError(fileInfo,
-        RunWithTimeout(timeout, minDelay, [&]() { return httpHandler->PUTJson(CombinedPath(path), request, ip); }));
+    return Trace::inSpan(traceChain.get(), SpanKind::api, "PUT", path, [&]() {
+        if (IsLightStatePath(path) && CanMerge(request))
+        {
+            return HandleError(fileInfo, CoalescedPUTRequest(path, request));
+        }
+        RequestMetrics::Endpoint& endpoint = metrics->getEndpoint("PUT", path);
+        return HandleError(fileInfo,
+            RunWithTimeout(GetScheduler(GetRequestType(true, path)), endpoint, *getRetryPolicy(), false,
+                requestTimeout, [&]() { return httpHandler->PUTJson(CombinedPath(path), request, ip); }));
+    });
 }
 
 nlohmann::json HueCommandAPI::GETRequest(const std::string& path, const nlohmann::json& request) const
@@ -92,8 +659,40 @@ nlohmann::json HueCommandAPI::GETRequest(const std::string& path, const nlohmann
 nlohmann::json HueCommandAPI::GETRequest(
     const std::string& path, const nlohmann::json& request, FileInfo fileInfo) const
 {
-    return HandleError(fileInfo,
-        RunWithTimeout(timeout, minDelay, [&]() { return httpHandler->GETJson(CombinedPath(path), request, ip); }));
+    return Trace::inSpan(traceChain.get(), SpanKind::api, "GET", path,
+        [&]() { return HandleError(fileInfo, SharedGETRequest(path, request)); });
+}
+
+bool HueCommandAPI::GETRequest(
+    const std::string& path, const nlohmann::json& request, nlohmann::json::json_sax_t& handler) const
+{
+    return GETRequest(path, request, handler, CURRENT_FILE_INFO);
+}
+
+bool HueCommandAPI::GETRequest(const std::string& path, const nlohmann::json& request,
+    nlohmann::json::json_sax_t& handler, FileInfo fileInfo) const
+{
+    return Trace::inSpan(traceChain.get(), SpanKind::api, "GET", path, [&]() {
+        ErrorCheckingSax checker(handler);
+        RequestMetrics::Endpoint& endpoint = metrics->getEndpoint("GET", path);
+        const bool result = RunWithTimeout(
+            GetScheduler(GetRequestType(false, path)), endpoint, *getRetryPolicy(), true, requestTimeout, [&]() {
+                if (checker.hasEvents())
+                {
+                    // The handler cannot take back the events it already received
+                    throw std::system_error(std::make_error_code(std::errc::connection_aborted),
+                        "HueCommandAPI: Connection lost while parsing response");
+                }
+                return httpHandler->GETJsonSax(CombinedPath(path), request, checker, ip);
+            });
+        RecordOutcome(endpoint, checker.getError());
+        if (IsInternalError(checker.getError()))
+        {
+            GetScheduler(RequestType::other).getPacer().onStress();
+        }
+        HandleError(std::move(fileInfo), checker.getError());
+        return result;
+    });
 }
 
 nlohmann::json HueCommandAPI::DELETERequest(const std::string& path, const nlohmann::json& request) const
@@ -104,8 +703,176 @@ nlohmann::json HueCommandAPI::DELETERequest(const std::string& path, const nlohm
 nlohmann::json HueCommandAPI::DELETERequest(
     const std::string& path, const nlohmann::json& request, FileInfo fileInfo) const
 {
-    return HandleError(fileInfo,
-        RunWithTimeout(timeout, minDelay, [&]() { return httpHandler->DELETEJson(CombinedPath(path), request, ip); }));
+    return Trace::inSpan(traceChain.get(), SpanKind::api, "DELETE", path, [&]() {
+        RequestMetrics::Endpoint& endpoint = metrics->getEndpoint("DELETE", path);
+        return HandleError(fileInfo,
+            RunWithTimeout(GetScheduler(GetRequestType(true, path)), endpoint, *getRetryPolicy(), true,
+                requestTimeout, [&]() { return httpHandler->DELETEJson(CombinedPath(path), request, ip); }));
+    });
+}
+
+nlohmann::json HueCommandAPI::CoalescedPUTRequest(const std::string& path, const nlohmann::json& request) const
+{
+    const RequestOptions& options = RequestOptions::current();
+    const std::pair<RequestOptions::Priority, std::string> key(options.priority, CombinedPath(path));
+    std::shared_ptr<PendingWrites::Write> write;
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(pendingWrites->mutex);
+        auto pos = pendingWrites->writes.find(key);
+        if (pos != pendingWrites->writes.end())
+        {
+            MergeInto(pos->second->request, request);
+            write = pos->second;
+        }
+        else
+        {
+            write = std::make_shared<PendingWrites::Write>();
+            write->request = request;
+            pendingWrites->writes.emplace(key, write);
+            first = true;
+        }
+    }
+    RequestMetrics::Endpoint& endpoint = metrics->getEndpoint("PUT", path);
+    if (!first)
+    {
+        // The first caller sends the merged change
+        endpoint.recordCoalesced();
+        const RequestOptions::Clock::time_point deadline = options.deadlineWithin(requestTimeout);
+        if (deadline != RequestOptions::Clock::time_point::max()
+            && write->result.wait_until(deadline) == std::future_status::timeout)
+        {
+            throw std::system_error(std::make_error_code(std::errc::timed_out),
+                "HueCommandAPI: Timed out waiting for the response of a merged request");
+        }
+        return FilterResponse(write->result.get(), request);
+    }
+
+    // Removes the write, so later changes are not merged into a request that is already sent
+    const auto take = [&]() {
+        std::lock_guard<std::mutex> lock(pendingWrites->mutex);
+        auto pos = pendingWrites->writes.find(key);
+        if (pos != pendingWrites->writes.end() && pos->second == write)
+        {
+            pendingWrites->writes.erase(pos);
+        }
+        return write->request;
+    };
+    try
+    {
+        nlohmann::json merged;
+        bool taken = false;
+        const nlohmann::json response = RunWithTimeout(
+            GetScheduler(RequestType::lights), endpoint, *getRetryPolicy(), true, requestTimeout, [&]() {
+                // A retry sends the same request again, which is idempotent because it has no increments
+                if (!taken)
+                {
+                    merged = take();
+                    taken = true;
+                }
+                return httpHandler->PUTJson(key.second, merged, ip);
+            });
+        write->response.set_value(response);
+        return FilterResponse(response, request);
+    }
+    catch (...)
+    {
+        take();
+        write->response.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+nlohmann::json HueCommandAPI::SharedGETRequest(const std::string& path, const nlohmann::json& request) const
+{
+    const RequestOptions& options = RequestOptions::current();
+    const std::tuple<RequestOptions::Priority, std::string, std::string> key(
+        options.priority, CombinedPath(path), request.dump());
+    std::shared_ptr<PendingReads::Read> read;
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(pendingReads->mutex);
+        std::shared_ptr<PendingReads::Read>& pending = pendingReads->reads[key];
+        if (!pending)
+        {
+            pending = std::make_shared<PendingReads::Read>();
+            first = true;
+        }
+        read = pending;
+    }
+    RequestMetrics::Endpoint& endpoint = metrics->getEndpoint("GET", path);
+    if (!first)
+    {
+        // The first caller sends the request
+        endpoint.recordCoalesced();
+        const RequestOptions::Clock::time_point deadline = options.deadlineWithin(requestTimeout);
+        if (deadline != RequestOptions::Clock::time_point::max()
+            && read->result.wait_until(deadline) == std::future_status::timeout)
+        {
+            throw std::system_error(std::make_error_code(std::errc::timed_out),
+                "HueCommandAPI: Timed out waiting for the response of an identical request");
+        }
+        return read->result.get();
+    }
+
+    // Removes the read, so later callers send a new request once the response is known
+    const auto finish = [&]() {
+        std::lock_guard<std::mutex> lock(pendingReads->mutex);
+        auto pos = pendingReads->reads.find(key);
+        if (pos != pendingReads->reads.end() && pos->second == read)
+        {
+            pendingReads->reads.erase(pos);
+        }
+    };
+    try
+    {
+        const nlohmann::json response
+            = RunWithTimeout(GetScheduler(GetRequestType(false, path)), endpoint, *getRetryPolicy(), true,
+                requestTimeout, [&]() { return httpHandler->GETJson(std::get<1>(key), request, ip); });
+        finish();
+        read->response.set_value(response);
+        return response;
+    }
+    catch (...)
+    {
+        finish();
+        read->response.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+HueCommandAPI::RequestType HueCommandAPI::GetRequestType(bool write, const std::string& path)
+{
+    if (!write)
+    {
+        return RequestType::other;
+    }
+    // The first segment of the path decides the resource, with or without leading '/'
+    const std::size_t start = path.empty() || path.front() != '/' ? 0 : 1;
+    const std::size_t end = path.find('/', start);
+    const std::string resource = path.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    if (resource == "lights")
+    {
+        return RequestType::lights;
+    }
+    if (resource == "groups")
+    {
+        return RequestType::groups;
+    }
+    return RequestType::other;
+}
+
+RequestScheduler& HueCommandAPI::GetScheduler(RequestType type) const
+{
+    switch (type)
+    {
+    case RequestType::lights:
+        return schedulers->lights;
+    case RequestType::groups:
+        return schedulers->groups;
+    default:
+        return schedulers->other;
+    }
 }
 
 nlohmann::json HueCommandAPI::HandleError(FileInfo fileInfo, const nlohmann::json& response) const
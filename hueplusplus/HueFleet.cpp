@@ -0,0 +1,164 @@
+/**
+    \file HueFleet.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/HueFleet.h"
+
+#include <algorithm>
+
+#include "include/HueException.h"
+#include "include/HueExceptionMacro.h"
+
+HueFleet::HueFleet(std::size_t threads)
+{
+    threads = std::max<std::size_t>(threads, 1);
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(&HueFleet::Work, this);
+    }
+}
+
+HueFleet::~HueFleet()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+Hue& HueFleet::addBridge(const std::string& name, Hue bridge)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Bridge>& entry = bridges[name];
+    entry = std::make_shared<Bridge>(std::move(bridge));
+    return entry->hue;
+}
+
+Hue& HueFleet::getBridge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto pos = bridges.find(name);
+    if (pos == bridges.end())
+    {
+        throw HueException(CURRENT_FILE_INFO, "No bridge named " + name);
+    }
+    return pos->second->hue;
+}
+
+std::vector<std::string> HueFleet::getBridgeNames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> names;
+    names.reserve(bridges.size());
+    for (const auto& entry : bridges)
+    {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+std::vector<std::future<nlohmann::json>> HueFleet::setLightStates(
+    const std::vector<LightId>& lights, const nlohmann::json& state)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const LightId& light : lights)
+        {
+            if (bridges.count(light.bridge) == 0)
+            {
+                throw HueException(CURRENT_FILE_INFO, "No bridge named " + light.bridge);
+            }
+        }
+    }
+    std::vector<std::future<nlohmann::json>> results;
+    results.reserve(lights.size());
+    for (const LightId& light : lights)
+    {
+        std::string path = "/lights/" + std::to_string(light.id) + "/state";
+        results.push_back(submit(light.bridge, [path, state](Hue& hue) {
+            return hue.getCommandAPI().PUTRequest(path, state, CURRENT_FILE_INFO);
+        }));
+    }
+    return results;
+}
+
+void HueFleet::Enqueue(const std::string& bridge, std::function<void(Hue&)> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto pos = bridges.find(bridge);
+        if (pos == bridges.end())
+        {
+            throw HueException(CURRENT_FILE_INFO, "No bridge named " + bridge);
+        }
+        std::shared_ptr<Bridge>& entry = pos->second;
+        Hue& hue = entry->hue;
+        // Requests of the task use the options of the thread that submitted it
+        RequestOptions options = RequestOptions::current();
+        entry->tasks.push_back([&hue, options, task]() {
+            RequestOptions::Scope scope(options);
+            task(hue);
+        });
+        if (!entry->running && entry->tasks.size() == 1)
+        {
+            ready.push_back(entry);
+        }
+    }
+    wakeup.notify_one();
+}
+
+void HueFleet::Work()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeup.wait(lock, [this] { return stopped || !ready.empty(); });
+        if (stopped)
+        {
+            return;
+        }
+        std::shared_ptr<Bridge> bridge = std::move(ready.front());
+        ready.pop_front();
+        std::function<void()> task = std::move(bridge->tasks.front());
+        bridge->tasks.pop_front();
+        bridge->running = true;
+
+        lock.unlock();
+        // Exceptions are stored in the future of the packaged task
+        task();
+        lock.lock();
+
+        bridge->running = false;
+        if (!bridge->tasks.empty())
+        {
+            // Go to the back of the line, so other bridges get their turn
+            ready.push_back(std::move(bridge));
+            wakeup.notify_one();
+        }
+    }
+}
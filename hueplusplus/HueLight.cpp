@@ -22,11 +22,13 @@
 
 #include "include/HueLight.h"
 
+#include <algorithm>
 #include <cmath>
-#include <iostream>
 #include <thread>
 
 #include "include/HueExceptionMacro.h"
+#include "include/Log.h"
+#include "include/StatePoller.h"
 #include "include/Utils.h"
 #include "include/json/json.hpp"
 
@@ -50,7 +52,7 @@ bool HueLight::isOn()
 
 bool HueLight::isOn() const
 {
-    return state["state"]["on"];
+    return (*getStateSnapshot())["state"]["on"];
 }
 
 int HueLight::getId() const
@@ -60,7 +62,7 @@ int HueLight::getId() const
 
 std::string HueLight::getType() const
 {
-    return state["type"];
+    return (*getStateSnapshot())["type"];
 }
 
 std::string HueLight::getName()
@@ -71,46 +73,50 @@ std::string HueLight::getName()
 
 std::string HueLight::getName() const
 {
-    return state["name"];
+    return (*getStateSnapshot())["name"];
 }
 
 std::string HueLight::getModelId() const
 {
-    return state["modelid"];
+    return (*getStateSnapshot())["modelid"];
 }
 
 std::string HueLight::getUId() const
 {
-    if (state.count("uniqueid"))
+    const std::shared_ptr<const nlohmann::json> current = getStateSnapshot();
+    if (current->count("uniqueid"))
     {
-        return state["uniqueid"];
+        return (*current)["uniqueid"];
     }
     return std::string();
 }
 
 std::string HueLight::getManufacturername() const
 {
-    if (state.count("manufacturername"))
+    const std::shared_ptr<const nlohmann::json> current = getStateSnapshot();
+    if (current->count("manufacturername"))
     {
-        return state["manufacturername"];
+        return (*current)["manufacturername"];
     }
     return std::string();
 }
 
 std::string HueLight::getProductname() const
 {
-    if (state.count("productname"))
+    const std::shared_ptr<const nlohmann::json> current = getStateSnapshot();
+    if (current->count("productname"))
     {
-        return state["productname"];
+        return (*current)["productname"];
     }
     return std::string();
 }
 
 std::string HueLight::getLuminaireUId() const
 {
-    if (state.count("luminaireuniqueid"))
+    const std::shared_ptr<const nlohmann::json> current = getStateSnapshot();
+    if (current->count("luminaireuniqueid"))
     {
-        return state["luminaireuniqueid"];
+        return (*current)["luminaireuniqueid"];
     }
     return std::string();
 }
@@ -123,7 +129,7 @@ std::string HueLight::getSwVersion()
 
 std::string HueLight::getSwVersion() const
 {
-    return state["swversion"];
+    return (*getStateSnapshot())["swversion"];
 }
 
 bool HueLight::setName(const std::string& name)
@@ -176,6 +182,55 @@ HueLight::HueLight(int id, const HueCommandAPI& commands, std::shared_ptr<const
     refreshState();
 }
 
+HueLight::HueLight(int id, const HueCommandAPI& commands, std::shared_ptr<const BrightnessStrategy> brightnessStrategy,
+    std::shared_ptr<const ColorTemperatureStrategy> colorTempStrategy,
+    std::shared_ptr<const ColorHueStrategy> colorHueStrategy, const nlohmann::json& state)
+    : id(id),
+      state(state),
+      lastStateUpdate(std::chrono::steady_clock::now()),
+      brightnessStrategy(std::move(brightnessStrategy)),
+      colorTemperatureStrategy(std::move(colorTempStrategy)),
+      colorHueStrategy(std::move(colorHueStrategy)),
+      commands(commands)
+{
+    PublishState();
+}
+
+HueLight::HueLight(const HueLight& other)
+    : id(other.id),
+      state(other.state),
+      lastStateUpdate(other.lastStateUpdate),
+      stateOutdated(other.stateOutdated),
+      stateMaxAge(other.stateMaxAge),
+      poller(other.poller),
+      snapshot(std::make_shared<const nlohmann::json>(other.state)),
+      colorType(other.colorType),
+      brightnessStrategy(other.brightnessStrategy),
+      colorTemperatureStrategy(other.colorTemperatureStrategy),
+      colorHueStrategy(other.colorHueStrategy),
+      commands(other.commands)
+{}
+
+HueLight& HueLight::operator=(const HueLight& other)
+{
+    if (this != &other)
+    {
+        id = other.id;
+        state = other.state;
+        lastStateUpdate = other.lastStateUpdate;
+        stateOutdated = other.stateOutdated;
+        stateMaxAge = other.stateMaxAge;
+        poller = other.poller;
+        colorType = other.colorType;
+        brightnessStrategy = other.brightnessStrategy;
+        colorTemperatureStrategy = other.colorTemperatureStrategy;
+        colorHueStrategy = other.colorHueStrategy;
+        commands = other.commands;
+        PublishState();
+    }
+    return *this;
+}
+
 bool HueLight::OnNoRefresh(uint8_t transition)
 {
     nlohmann::json request = nlohmann::json::object();
@@ -224,13 +279,87 @@ bool HueLight::OffNoRefresh(uint8_t transition)
     return utils::validateReplyForLight(request, reply, id);
 }
 
+void HueLight::setStateMaxAge(std::chrono::milliseconds maxAge)
+{
+    stateMaxAge = maxAge;
+}
+
+std::chrono::milliseconds HueLight::getStateMaxAge() const
+{
+    return stateMaxAge;
+}
+
+std::shared_ptr<const nlohmann::json> HueLight::getStateSnapshot() const
+{
+    return std::atomic_load(&snapshot);
+}
+
+void HueLight::PublishState()
+{
+    std::atomic_store(&snapshot, std::make_shared<const nlohmann::json>(state));
+}
+
 nlohmann::json HueLight::SendPutRequest(const nlohmann::json& request, const std::string& subPath, FileInfo fileInfo)
 {
-    return commands.PUTRequest("/lights/" + std::to_string(id) + subPath, request, std::move(fileInfo));
+    const std::string path = "/lights/" + std::to_string(id);
+    // The state is unknown until the reply is received
+    stateOutdated = true;
+    nlohmann::json reply = commands.PUTRequest(path + subPath, request, std::move(fileInfo));
+
+    // Values that were not confirmed by the reply did not change
+    std::vector<std::string> unapplied;
+    const std::vector<std::string> changed = utils::applyReplyToState(reply, path, state, &unapplied);
+    for (const std::string& member : changed)
+    {
+        // The bridge switches the color mode to the color that was set last
+        const char* colormode = nullptr;
+        if (member == "/state/xy")
+        {
+            colormode = "xy";
+        }
+        else if (member == "/state/ct")
+        {
+            colormode = "ct";
+        }
+        else if (member == "/state/hue" || member == "/state/sat")
+        {
+            colormode = "hs";
+        }
+        if (colormode && state["state"].count("colormode"))
+        {
+            state["state"]["colormode"] = colormode;
+        }
+    }
+    if (!changed.empty())
+    {
+        PublishState();
+        // The confirmed values are as new as the reply
+        lastStateUpdate = std::chrono::steady_clock::now();
+    }
+    // Relative changes like "bri_inc" were confirmed, but their result is unknown. The transition time is no state.
+    stateOutdated = std::any_of(unapplied.begin(), unapplied.end(),
+        [](const std::string& member) { return member != "/state/transitiontime"; });
+    return reply;
 }
 
 void HueLight::refreshState()
 {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (poller && poller->getUpdateTime() > lastStateUpdate)
+    {
+        std::chrono::steady_clock::time_point polledTime;
+        nlohmann::json polledState = poller->getLightState(id, polledTime);
+        if (polledState.count("state"))
+        {
+            state = std::move(polledState);
+            lastStateUpdate = polledTime;
+            PublishState();
+        }
+    }
+    if (!stateOutdated && std::chrono::duration_cast<std::chrono::milliseconds>(now - lastStateUpdate) < stateMaxAge)
+    {
+        return;
+    }
     // std::chrono::steady_clock::time_point start =
     // std::chrono::steady_clock::now(); std::cout << "\tRefreshing lampstate of
     // lamp with id: " << id << ", ip: " << ip << "\n";
@@ -239,12 +368,15 @@ void HueLight::refreshState()
     if (answer.count("state"))
     {
         state = answer;
+        lastStateUpdate = now;
+        stateOutdated = false;
+        PublishState();
     }
     else
     {
-        std::cout << "Answer in HueLight::refreshState of "
-                     "http_handler->GETJson(...) is not expected!\nAnswer:\n\t"
-                  << answer.dump() << std::endl;
+        HUE_LOG(LogLevel::warning,
+            "Answer in HueLight::refreshState of http_handler->GETJson(...) is not expected!\nAnswer:\n\t"
+                << answer.dump());
     }
     // std::cout << "\tRefresh state took: " <<
     // std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()
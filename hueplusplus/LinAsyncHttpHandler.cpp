@@ -0,0 +1,870 @@
+/**
+    \file LinAsyncHttpHandler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/LinAsyncHttpHandler.h"
+
+#include "include/HttpResponseParser.h"
+#include "include/Log.h"
+#include "include/RequestOptions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+#include <sys/epoll.h> // epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h> // eventfd
+#include <sys/socket.h> // socket, connect, sendmsg
+#include <sys/uio.h> // iovec
+#include <unistd.h> // read, write, close
+
+namespace
+{
+    // Size of the receive buffer shared by all connections of the event loop
+    constexpr std::size_t receiveBufferSize = 64 * 1024;
+    // Maximum number of events handled per epoll_wait
+    constexpr int maxEvents = 64;
+    // Maximum number of pipelined requests sent with one call
+    constexpr std::size_t maxWriteBuffers = 16;
+
+    bool IsHeadRequest(const std::string& msg)
+    {
+        return msg.compare(0, 5, "HEAD ") == 0;
+    }
+
+    std::system_error SystemError(int errCode, const char* what)
+    {
+        HUE_LOG(LogLevel::error, "LinAsyncHttpHandler: " << what << ": " << std::strerror(errCode));
+        return std::system_error(errCode, std::generic_category(), std::string("LinAsyncHttpHandler: ") + what);
+    }
+
+    // Calls a completion callback, exceptions must not escape into the event loop
+    void Complete(
+        const IAsyncHttpHandler::ResponseCallback& callback, std::string response, std::exception_ptr error)
+    {
+        try
+        {
+            callback(std::move(response), error);
+        }
+        catch (const std::exception& e)
+        {
+            HUE_LOG(LogLevel::error, "LinAsyncHttpHandler: Exception in completion callback: " << e.what());
+        }
+        catch (...)
+        {
+            HUE_LOG(LogLevel::error, "LinAsyncHttpHandler: Unknown exception in completion callback");
+        }
+    }
+} // namespace
+
+class LinAsyncHttpHandler::EventLoop
+{
+public:
+    struct Request
+    {
+        std::string msg;
+        std::string adr;
+        int port;
+        std::vector<HostResolver::Address> addresses;
+        RequestOptions::Clock::time_point deadline;
+        ResponseCallback callback;
+    };
+
+public:
+    EventLoop();
+    ~EventLoop();
+
+    // Queues the request and wakes the event loop, can be called from any thread
+    void submit(std::unique_ptr<Request> request);
+
+    void setMaxConnections(std::size_t count)
+    {
+        maxConnections = count;
+        wakeup();
+    }
+
+    void setPipelining(std::size_t depth)
+    {
+        pipelineDepth = depth;
+        wakeup();
+    }
+
+private:
+    struct Host;
+
+    struct Connection
+    {
+        int socketFD = -1;
+        Host* host = nullptr;
+        bool connecting = true;
+        uint32_t events = 0; //!< Events the socket is registered for, 0 when not registered
+        std::size_t address = 0; //!< Index of the address that is connected
+        //! Requests that were sent or wait to be sent, the next response belongs to the first one
+        std::deque<std::unique_ptr<Request>> requests;
+        std::size_t unsent = 0; //!< Index of the first request that was not sent completely
+        std::size_t written = 0; //!< Bytes of that request that were already sent
+        HttpResponseParser parser;
+        std::size_t completed = 0; //!< Number of responses received on the connection
+        bool received = false; //!< Whether anything was received for the first request
+        bool closed = false;
+    };
+
+    struct Host
+    {
+        std::vector<Connection*> connections;
+        std::deque<std::unique_ptr<Request>> pending;
+    };
+
+private:
+    void run();
+    void wakeup();
+    // Moves submitted requests to their hosts, returns false when the loop should stop
+    bool takeSubmitted();
+    // Assigns pending requests to idle, new or pipelined connections and sends them
+    void dispatch(Host& host);
+    // Returns the connection the request can be pipelined on, or nullptr
+    Connection* pipelineTarget(Host& host, const Request& request) const;
+    void enqueue(Connection& connection, std::unique_ptr<Request> request);
+    void open(Host& host, std::unique_ptr<Request> request);
+    // Connects to the current address of the connection or the ones after it
+    void connectNext(Connection& connection, int errCode);
+    void handleEvent(Connection& connection, uint32_t events);
+    void write(Connection& connection);
+    void read(Connection& connection);
+    // Registers the socket for the events the connection currently waits for
+    void watch(Connection& connection);
+    void completeFirst(Connection& connection);
+    // Closes the connection and fails the requests that were sent completely, because the host may have applied
+    // them. The others are sent again. The first request also fails when it was not sent, unless a reused
+    // connection was closed before it arrived. When the host closed the connection after a response
+    // (hostClosed), it did not process the remaining requests and all of them are sent again.
+    void abort(Connection& connection, int errCode, const char* what, bool hostClosed = false);
+    void close(Connection& connection);
+    // Fails all requests whose deadline passed and closes the connections they were sent on
+    void expire();
+    // Returns the epoll_wait timeout until the next deadline
+    int waitTime() const;
+
+private:
+    int epollFD;
+    int eventFD;
+    std::atomic<std::size_t> maxConnections;
+    std::atomic<std::size_t> pipelineDepth;
+    std::size_t closeCount;
+    // No request expires before this time, it can be earlier than the actual next deadline
+    RequestOptions::Clock::time_point nextDeadline;
+    std::unique_ptr<char[]> buffer;
+    std::map<std::pair<std::string, int>, Host> hosts;
+    std::unordered_map<Connection*, std::unique_ptr<Connection>> connections;
+    // Connections closed while handling events, destroyed after all events of the batch were handled
+    std::vector<std::unique_ptr<Connection>> closed;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Request>> submitted;
+    bool stopped;
+
+    std::thread thread;
+};
+
+LinAsyncHttpHandler::EventLoop::EventLoop()
+    : epollFD(-1),
+      eventFD(-1),
+      maxConnections(4),
+      pipelineDepth(1),
+      closeCount(0),
+      nextDeadline(RequestOptions::Clock::time_point::max()),
+      buffer(new char[receiveBufferSize]),
+      stopped(false)
+{
+    epollFD = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFD < 0)
+    {
+        throw SystemError(errno, "Failed to create epoll instance");
+    }
+    eventFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFD < 0)
+    {
+        int errCode = errno;
+        ::close(epollFD);
+        throw SystemError(errCode, "Failed to create eventfd");
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(epollFD, EPOLL_CTL_ADD, eventFD, &event) < 0)
+    {
+        int errCode = errno;
+        ::close(eventFD);
+        ::close(epollFD);
+        throw SystemError(errCode, "Failed to watch eventfd");
+    }
+    thread = std::thread(&EventLoop::run, this);
+}
+
+LinAsyncHttpHandler::EventLoop::~EventLoop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    wakeup();
+    thread.join();
+
+    std::vector<std::unique_ptr<Request>> canceled = std::move(submitted);
+    for (auto& host : hosts)
+    {
+        std::move(host.second.pending.begin(), host.second.pending.end(), std::back_inserter(canceled));
+    }
+    for (auto& connection : connections)
+    {
+        std::move(connection.second->requests.begin(), connection.second->requests.end(),
+            std::back_inserter(canceled));
+        if (connection.second->socketFD >= 0)
+        {
+            ::close(connection.second->socketFD);
+        }
+    }
+    ::close(eventFD);
+    ::close(epollFD);
+
+    const std::exception_ptr error = std::make_exception_ptr(std::system_error(
+        std::make_error_code(std::errc::operation_canceled), "LinAsyncHttpHandler: Request canceled"));
+    for (auto& request : canceled)
+    {
+        Complete(request->callback, std::string(), error);
+    }
+}
+
+void LinAsyncHttpHandler::EventLoop::submit(std::unique_ptr<Request> request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stopped)
+        {
+            submitted.push_back(std::move(request));
+        }
+    }
+    if (request)
+    {
+        Complete(request->callback, std::string(),
+            std::make_exception_ptr(std::system_error(
+                std::make_error_code(std::errc::operation_canceled), "LinAsyncHttpHandler: Request canceled")));
+        return;
+    }
+    wakeup();
+}
+
+void LinAsyncHttpHandler::EventLoop::wakeup()
+{
+    const uint64_t one = 1;
+    // Only fails when the counter would overflow, then the loop is woken up anyway
+    ssize_t result = ::write(eventFD, &one, sizeof(one));
+    (void)result;
+}
+
+void LinAsyncHttpHandler::EventLoop::run()
+{
+    epoll_event events[maxEvents];
+    while (true)
+    {
+        int count = epoll_wait(epollFD, events, maxEvents, waitTime());
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            SystemError(errno, "Failed to wait for events");
+            return;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].data.ptr == nullptr)
+            {
+                if (!takeSubmitted())
+                {
+                    return;
+                }
+                continue;
+            }
+            Connection& connection = *static_cast<Connection*>(events[i].data.ptr);
+            // A connection closed by an earlier event of this batch can still have events
+            if (!connection.closed)
+            {
+                handleEvent(connection, events[i].events);
+                dispatch(*connection.host);
+            }
+        }
+        if (RequestOptions::Clock::now() >= nextDeadline)
+        {
+            expire();
+        }
+        closed.clear();
+    }
+}
+
+bool LinAsyncHttpHandler::EventLoop::takeSubmitted()
+{
+    uint64_t value;
+    ssize_t result = ::read(eventFD, &value, sizeof(value));
+    (void)result;
+
+    std::vector<std::unique_ptr<Request>> requests;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped)
+        {
+            return false;
+        }
+        requests.swap(submitted);
+    }
+    for (std::unique_ptr<Request>& request : requests)
+    {
+        Host& host = hosts[std::make_pair(request->adr, request->port)];
+        nextDeadline = std::min(nextDeadline, request->deadline);
+        host.pending.push_back(std::move(request));
+    }
+    // Also starts requests that were waiting for a higher connection limit
+    for (auto& host : hosts)
+    {
+        dispatch(host.second);
+    }
+    return true;
+}
+
+void LinAsyncHttpHandler::EventLoop::dispatch(Host& host)
+{
+    std::size_t closes;
+    do
+    {
+        closes = closeCount;
+        while (!host.pending.empty())
+        {
+            Connection* target = nullptr;
+            for (Connection* connection : host.connections)
+            {
+                if (connection->requests.empty())
+                {
+                    target = connection;
+                    break;
+                }
+            }
+            if (target == nullptr && host.connections.size() < std::max<std::size_t>(maxConnections, 1))
+            {
+                std::unique_ptr<Request> request = std::move(host.pending.front());
+                host.pending.pop_front();
+                open(host, std::move(request));
+                continue;
+            }
+            if (target == nullptr)
+            {
+                target = pipelineTarget(host, *host.pending.front());
+                if (target == nullptr)
+                {
+                    break;
+                }
+            }
+            std::unique_ptr<Request> request = std::move(host.pending.front());
+            host.pending.pop_front();
+            enqueue(*target, std::move(request));
+        }
+        // Requests queued on the same connection are sent together
+        const std::vector<Connection*> current = host.connections;
+        for (Connection* connection : current)
+        {
+            if (!connection->closed && !connection->connecting && !(connection->events & EPOLLOUT)
+                && connection->unsent < connection->requests.size())
+            {
+                write(*connection);
+            }
+        }
+        // Requests of connections that failed while sending are pending again
+    } while (closes != closeCount && !host.pending.empty());
+}
+
+LinAsyncHttpHandler::EventLoop::Connection* LinAsyncHttpHandler::EventLoop::pipelineTarget(
+    Host& host, const Request& request) const
+{
+    const std::size_t depth = pipelineDepth;
+    // A POST request could not be sent again when the connection is lost before its response
+    if (depth <= 1 || request.msg.compare(0, 5, "POST ") == 0)
+    {
+        return nullptr;
+    }
+    Connection* target = nullptr;
+    for (Connection* connection : host.connections)
+    {
+        if (connection->requests.size() < depth
+            && (target == nullptr || connection->requests.size() < target->requests.size()))
+        {
+            target = connection;
+        }
+    }
+    return target;
+}
+
+void LinAsyncHttpHandler::EventLoop::enqueue(Connection& connection, std::unique_ptr<Request> request)
+{
+    if (connection.requests.empty())
+    {
+        connection.parser.reset(IsHeadRequest(request->msg));
+        connection.received = false;
+    }
+    connection.requests.push_back(std::move(request));
+}
+
+void LinAsyncHttpHandler::EventLoop::open(Host& host, std::unique_ptr<Request> request)
+{
+    std::unique_ptr<Connection> owned(new Connection());
+    Connection& connection = *owned;
+    connections.emplace(&connection, std::move(owned));
+    host.connections.push_back(&connection);
+    connection.host = &host;
+    enqueue(connection, std::move(request));
+    connectNext(connection, 0);
+}
+
+void LinAsyncHttpHandler::EventLoop::connectNext(Connection& connection, int errCode)
+{
+    const std::vector<HostResolver::Address>& addresses = connection.requests.front()->addresses;
+    for (; connection.address < addresses.size(); ++connection.address)
+    {
+        const HostResolver::Address& address = addresses[connection.address];
+        connection.socketFD = socket(address.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        connection.events = 0;
+        if (connection.socketFD < 0)
+        {
+            abort(connection, errno, "Failed to open socket");
+            return;
+        }
+        if (connect(connection.socketFD, reinterpret_cast<const sockaddr*>(&address.address), address.length) == 0)
+        {
+            // The requests are sent by dispatch
+            connection.connecting = false;
+            watch(connection);
+            return;
+        }
+        if (errno == EINPROGRESS)
+        {
+            watch(connection);
+            return;
+        }
+        errCode = errno;
+        ::close(connection.socketFD);
+        connection.socketFD = -1;
+    }
+    abort(connection, errCode, "Failed to connect socket");
+}
+
+void LinAsyncHttpHandler::EventLoop::handleEvent(Connection& connection, uint32_t events)
+{
+    if (connection.connecting)
+    {
+        int errCode = 0;
+        socklen_t length = sizeof(errCode);
+        if (getsockopt(connection.socketFD, SOL_SOCKET, SO_ERROR, &errCode, &length) < 0)
+        {
+            errCode = errno;
+        }
+        if (errCode != 0)
+        {
+            // Closing the socket also removes it from the epoll instance
+            ::close(connection.socketFD);
+            connection.socketFD = -1;
+            ++connection.address;
+            connectNext(connection, errCode);
+            return;
+        }
+        connection.connecting = false;
+        write(connection);
+        return;
+    }
+    if ((events & EPOLLOUT) && connection.unsent < connection.requests.size())
+    {
+        write(connection);
+    }
+    if (!connection.closed && (events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+    {
+        if (connection.requests.empty())
+        {
+            // Idle connections are only readable when the peer closed them
+            close(connection);
+        }
+        else
+        {
+            read(connection);
+        }
+    }
+}
+
+void LinAsyncHttpHandler::EventLoop::write(Connection& connection)
+{
+    iovec buffers[maxWriteBuffers];
+    while (connection.unsent < connection.requests.size())
+    {
+        // Send all unsent requests with one call
+        std::size_t count = 0;
+        std::size_t offset = connection.written;
+        for (std::size_t i = connection.unsent; i < connection.requests.size() && count < maxWriteBuffers; ++i)
+        {
+            const std::string& msg = connection.requests[i]->msg;
+            buffers[count].iov_base = const_cast<char*>(msg.data()) + offset;
+            buffers[count].iov_len = msg.size() - offset;
+            offset = 0;
+            ++count;
+        }
+        msghdr message = {};
+        message.msg_iov = buffers;
+        message.msg_iovlen = count;
+        // sendmsg instead of writev, because only send functions accept MSG_NOSIGNAL
+        ssize_t bytes = sendmsg(connection.socketFD, &message, MSG_NOSIGNAL);
+        if (bytes < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            abort(connection, errno, "Failed to write message to socket");
+            return;
+        }
+        std::size_t sent = bytes;
+        while (sent > 0)
+        {
+            const std::size_t remaining = connection.requests[connection.unsent]->msg.size() - connection.written;
+            if (sent < remaining)
+            {
+                connection.written += sent;
+                break;
+            }
+            sent -= remaining;
+            ++connection.unsent;
+            connection.written = 0;
+        }
+    }
+    watch(connection);
+}
+
+void LinAsyncHttpHandler::EventLoop::read(Connection& connection)
+{
+    ssize_t bytes = ::read(connection.socketFD, buffer.get(), receiveBufferSize);
+    if (bytes < 0)
+    {
+        if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            abort(connection, errno, "Failed to read response from socket");
+        }
+        return;
+    }
+    if (bytes == 0)
+    {
+        if (!connection.parser.finish())
+        {
+            abort(connection, ECONNRESET, "Connection closed before response");
+            return;
+        }
+        // Connection closed, the response ends with whatever was received
+        completeFirst(connection);
+        abort(connection, ECONNRESET, "Connection closed before response", true);
+        return;
+    }
+    std::size_t offset = 0;
+    while (offset < static_cast<std::size_t>(bytes))
+    {
+        if (connection.requests.empty())
+        {
+            // Additional data after the response would be mistaken for the next response
+            close(connection);
+            return;
+        }
+        connection.received = true;
+        offset += connection.parser.feed(buffer.get() + offset, bytes - offset);
+        if (!connection.parser.isComplete())
+        {
+            return;
+        }
+        // A response that arrives before its request was sent completely ends the connection
+        const bool keepAlive = connection.parser.isKeepAlive() && connection.unsent > 0;
+        completeFirst(connection);
+        if (!keepAlive)
+        {
+            // The host does not answer the other requests on this connection
+            abort(connection, ECONNRESET, "Connection closed before response", true);
+            return;
+        }
+    }
+}
+
+void LinAsyncHttpHandler::EventLoop::watch(Connection& connection)
+{
+    uint32_t events = EPOLLOUT;
+    if (!connection.connecting)
+    {
+        events = EPOLLIN;
+        if (connection.unsent < connection.requests.size())
+        {
+            events |= EPOLLOUT;
+        }
+    }
+    if (connection.events == events)
+    {
+        return;
+    }
+    epoll_event event = {};
+    event.events = events;
+    event.data.ptr = &connection;
+    if (epoll_ctl(epollFD, connection.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, connection.socketFD, &event) < 0)
+    {
+        abort(connection, errno, "Failed to watch socket");
+        return;
+    }
+    connection.events = events;
+}
+
+void LinAsyncHttpHandler::EventLoop::completeFirst(Connection& connection)
+{
+    std::unique_ptr<Request> request = std::move(connection.requests.front());
+    connection.requests.pop_front();
+    if (connection.unsent > 0)
+    {
+        --connection.unsent;
+    }
+    else
+    {
+        connection.written = 0;
+    }
+    ++connection.completed;
+    connection.received = false;
+    std::string response = connection.parser.takeResponse();
+    if (!connection.requests.empty())
+    {
+        connection.parser.reset(IsHeadRequest(connection.requests.front()->msg));
+    }
+    Complete(request->callback, std::move(response), nullptr);
+}
+
+void LinAsyncHttpHandler::EventLoop::abort(Connection& connection, int errCode, const char* what, bool hostClosed)
+{
+    std::deque<std::unique_ptr<Request>> requests = std::move(connection.requests);
+    std::size_t failCount = 0;
+    if (!hostClosed)
+    {
+        // Requests that were sent completely are left to the RetryPolicy of the caller,
+        // because they are not idempotent when the host already applied them
+        failCount = connection.unsent;
+        const bool staleConnection
+            = connection.completed > 0 && !connection.received && (errCode == ECONNRESET || errCode == EPIPE);
+        if (failCount == 0 && !staleConnection)
+        {
+            failCount = 1;
+        }
+    }
+    Host& host = *connection.host;
+    close(connection);
+    failCount = std::min(failCount, requests.size());
+    std::vector<std::unique_ptr<Request>> failed;
+    for (std::size_t i = 0; i < failCount; ++i)
+    {
+        failed.push_back(std::move(requests.front()));
+        requests.pop_front();
+    }
+    std::move(requests.rbegin(), requests.rend(), std::front_inserter(host.pending));
+    for (std::unique_ptr<Request>& request : failed)
+    {
+        Complete(request->callback, std::string(), std::make_exception_ptr(SystemError(errCode, what)));
+    }
+}
+
+void LinAsyncHttpHandler::EventLoop::close(Connection& connection)
+{
+    if (connection.closed)
+    {
+        return;
+    }
+    connection.closed = true;
+    ++closeCount;
+    if (connection.socketFD >= 0)
+    {
+        ::close(connection.socketFD);
+        connection.socketFD = -1;
+    }
+    Host& host = *connection.host;
+    host.connections.erase(std::find(host.connections.begin(), host.connections.end(), &connection));
+    auto pos = connections.find(&connection);
+    closed.push_back(std::move(pos->second));
+    connections.erase(pos);
+}
+
+void LinAsyncHttpHandler::EventLoop::expire()
+{
+    const RequestOptions::Clock::time_point now = RequestOptions::Clock::now();
+    const std::exception_ptr error = std::make_exception_ptr(
+        std::system_error(std::make_error_code(std::errc::timed_out), "LinAsyncHttpHandler: Request timed out"));
+    const std::exception_ptr resetError = std::make_exception_ptr(
+        SystemError(ECONNRESET, "Connection closed before response, because an earlier request timed out"));
+    std::vector<std::unique_ptr<Request>> expired;
+    std::vector<std::unique_ptr<Request>> reset;
+    for (auto& entry : hosts)
+    {
+        Host& host = entry.second;
+        // The response to the first request of a connection has to arrive first,
+        // so only its deadline can end the connection
+        const std::vector<Connection*> current = host.connections;
+        for (Connection* connection : current)
+        {
+            if (connection->requests.empty() || connection->requests.front()->deadline > now)
+            {
+                continue;
+            }
+            std::deque<std::unique_ptr<Request>> requests = std::move(connection->requests);
+            const std::size_t unsent = connection->unsent;
+            close(*connection);
+            for (std::size_t i = requests.size(); i-- > 0;)
+            {
+                if (requests[i]->deadline <= now)
+                {
+                    expired.push_back(std::move(requests[i]));
+                }
+                else if (i < unsent)
+                {
+                    // Was sent, but the host may have applied it, so the RetryPolicy of the caller decides
+                    reset.push_back(std::move(requests[i]));
+                }
+                else
+                {
+                    // Was never sent completely, so it is sent again on another connection
+                    host.pending.push_front(std::move(requests[i]));
+                }
+            }
+        }
+        auto end = std::partition(host.pending.begin(), host.pending.end(),
+            [&](const std::unique_ptr<Request>& request) { return request->deadline > now; });
+        std::move(end, host.pending.end(), std::back_inserter(expired));
+        host.pending.erase(end, host.pending.end());
+    }
+    // Find the next deadline
+    nextDeadline = RequestOptions::Clock::time_point::max();
+    for (auto& entry : hosts)
+    {
+        for (const std::unique_ptr<Request>& request : entry.second.pending)
+        {
+            nextDeadline = std::min(nextDeadline, request->deadline);
+        }
+        for (Connection* connection : entry.second.connections)
+        {
+            for (const std::unique_ptr<Request>& request : connection->requests)
+            {
+                nextDeadline = std::min(nextDeadline, request->deadline);
+            }
+        }
+    }
+    if (!expired.empty())
+    {
+        HUE_LOG(LogLevel::error, "LinAsyncHttpHandler: " << expired.size() << " requests timed out");
+    }
+    for (std::unique_ptr<Request>& request : expired)
+    {
+        Complete(request->callback, std::string(), error);
+    }
+    for (std::unique_ptr<Request>& request : reset)
+    {
+        Complete(request->callback, std::string(), resetError);
+    }
+    for (auto& entry : hosts)
+    {
+        dispatch(entry.second);
+    }
+}
+
+int LinAsyncHttpHandler::EventLoop::waitTime() const
+{
+    if (nextDeadline == RequestOptions::Clock::time_point::max())
+    {
+        return -1;
+    }
+    // Round up, so the loop does not wake up just before the deadline
+    const std::chrono::milliseconds::rep remaining
+        = std::chrono::duration_cast<std::chrono::milliseconds>(nextDeadline - RequestOptions::Clock::now()).count()
+        + 1;
+    return static_cast<int>(std::min<std::chrono::milliseconds::rep>(
+        std::max<std::chrono::milliseconds::rep>(remaining, 0), std::numeric_limits<int>::max()));
+}
+
+LinAsyncHttpHandler::LinAsyncHttpHandler()
+    : timeout(std::chrono::seconds(10)), resolver(), loop(new EventLoop())
+{}
+
+LinAsyncHttpHandler::~LinAsyncHttpHandler() = default;
+
+void LinAsyncHttpHandler::setMaxConnections(std::size_t count)
+{
+    loop->setMaxConnections(count);
+}
+
+void LinAsyncHttpHandler::setPipelining(std::size_t depth)
+{
+    loop->setPipelining(depth);
+}
+
+void LinAsyncHttpHandler::setTimeout(std::chrono::steady_clock::duration timeout)
+{
+    this->timeout = timeout;
+}
+
+void LinAsyncHttpHandler::setHostCacheTTL(std::chrono::steady_clock::duration ttl)
+{
+    resolver.setTTL(ttl);
+}
+
+void LinAsyncHttpHandler::send(
+    const std::string& msg, const std::string& adr, int port, ResponseCallback onResponse) const
+{
+    std::unique_ptr<EventLoop::Request> request(new EventLoop::Request());
+    try
+    {
+        request->addresses = resolver.resolve(adr, port);
+    }
+    catch (...)
+    {
+        Complete(onResponse, std::string(), std::current_exception());
+        return;
+    }
+    request->deadline = RequestOptions::current().deadlineWithin(timeout);
+    request->msg = msg;
+    request->adr = adr;
+    request->port = port;
+    request->callback = std::move(onResponse);
+    loop->submit(std::move(request));
+}
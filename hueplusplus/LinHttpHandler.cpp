@@ -22,202 +22,670 @@
 
 #include "include/LinHttpHandler.h"
 
+#include "include/HttpResponseParser.h"
+#include "include/HueExceptionMacro.h"
+#include "include/Log.h"
+#include "include/RequestOptions.h"
+
+#include <algorithm>
 #include <chrono>
 #include <cstring>
-#include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <streambuf>
 #include <stdexcept>
 #include <system_error>
 
 #include <arpa/inet.h>
-#include <netdb.h> // struct hostent, gethostbyname
 #include <netinet/in.h> // struct sockaddr_in, struct sockaddr
+#include <poll.h> // poll
 #include <stdio.h> // printf, sprintf
 #include <stdlib.h> // exit
 #include <string.h> // functions for C style null-terminated strings
 #include <sys/socket.h> // socket, connect
+#include <sys/uio.h> // iovec
 #include <unistd.h> // read, write, close
 
 class SocketCloser
 {
 public:
     explicit SocketCloser(int sockFd) : s(sockFd) {}
-    ~SocketCloser() { close(s); }
+    ~SocketCloser()
+    {
+        if (s >= 0)
+        {
+            close(s);
+        }
+    }
+    //! \brief Releases ownership of the socket without closing it
+    int release()
+    {
+        int result = s;
+        s = -1;
+        return result;
+    }
 
 private:
     int s;
 };
 
-std::string LinHttpHandler::send(const std::string& msg, const std::string& adr, int port) const
+namespace
 {
-    // create socket
-    int socketFD = socket(AF_INET, SOCK_STREAM, 0);
+    // Size of the receive buffer of each connection
+    constexpr std::size_t receiveBufferSize = 64 * 1024;
 
-    SocketCloser closeMySocket(socketFD);
-    if (socketFD < 0)
+    // Socket with its receive buffer, both are reused for keep-alive requests
+    struct Connection
     {
-        int errCode = errno;
-        std::cerr << "LinHttpHandler: Failed to open socket: " << std::strerror(errCode) << "\n";
-        throw(std::system_error(errCode, std::generic_category(), "LinHttpHandler: Failed to open socket"));
-    }
+        int socketFD = -1;
+        std::unique_ptr<char[]> buffer;
+        // Whether anything was received for the current request
+        bool received = false;
+        // Time by which the current request must be completed
+        RequestOptions::Clock::time_point deadline = RequestOptions::Clock::time_point::max();
+    };
 
-    // lookup ip address
-    hostent* server;
-    server = gethostbyname(adr.c_str());
-    if (server == NULL)
+    // Waits until the socket is ready for events, throws timed_out when the deadline passes first
+    void WaitFor(int socketFD, short events, RequestOptions::Clock::time_point deadline)
     {
-        int errCode = errno;
-        std::cerr << "LinHttpHandler: Failed to find host with address " << adr << ": " << std::strerror(errCode)
-                  << "\n";
-        throw(std::system_error(errCode, std::generic_category(), "LinHttpHandler: gethostbyname"));
+        while (true)
+        {
+            int timeout = -1;
+            if (deadline != RequestOptions::Clock::time_point::max())
+            {
+                // Round up, so the wait does not end just before the deadline
+                const std::chrono::milliseconds::rep remaining
+                    = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - RequestOptions::Clock::now())
+                          .count()
+                    + 1;
+                timeout = static_cast<int>(std::min<std::chrono::milliseconds::rep>(
+                    std::max<std::chrono::milliseconds::rep>(remaining, 0), std::numeric_limits<int>::max()));
+            }
+            pollfd fd = {socketFD, events, 0};
+            int result = poll(&fd, 1, timeout);
+            if (result > 0)
+            {
+                return;
+            }
+            if (result < 0 && errno != EINTR)
+            {
+                int errCode = errno;
+                HUE_LOG(LogLevel::error, "LinHttpHandler: Failed to poll socket: " << std::strerror(errCode));
+                throw(std::system_error(errCode, std::generic_category(), "LinHttpHandler: Failed to poll socket"));
+            }
+            if (result == 0 && RequestOptions::Clock::now() >= deadline)
+            {
+                HUE_LOG(LogLevel::error, "LinHttpHandler: Request timed out");
+                throw(std::system_error(
+                    std::make_error_code(std::errc::timed_out), "LinHttpHandler: Request timed out"));
+            }
+        }
     }
+} // namespace
 
-    // fill in the structure
-    sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    memcpy(&server_addr.sin_addr.s_addr, server->h_addr, server->h_length);
-
-    // connect the socket
-    if (connect(socketFD, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0)
+//! Keeps idle keep-alive connections per address and port
+class LinHttpHandler::ConnectionPool
+{
+public:
+    explicit ConnectionPool(std::size_t maxIdle) : maxIdle(maxIdle) {}
+    ~ConnectionPool()
     {
-        int errCode = errno;
-        std::cerr << "LinHttpHandler: Failed to connect socket: " << std::strerror(errCode) << "\n";
-        throw(std::system_error(errCode, std::generic_category(), "LinHttpHandler: Failed to connect socket"));
+        for (auto& entry : idle)
+        {
+            for (Connection& connection : entry.second)
+            {
+                close(connection.socketFD);
+            }
+        }
     }
 
-    // send the request
-    size_t total = msg.length();
-    size_t sent = 0;
-    do
+    //! \brief Takes an idle connection that is still open, socketFD is -1 if there is none
+    Connection acquire(const std::string& adr, int port)
     {
-        ssize_t bytes = write(socketFD, msg.c_str() + sent, total - sent);
-        if (bytes < 0)
+        std::lock_guard<std::mutex> lock(mutex);
+        auto pos = idle.find(std::make_pair(adr, port));
+        if (pos == idle.end())
         {
-            int errCode = errno;
-            std::cerr << "LinHttpHandler: Failed to write message to socket: " << std::strerror(errCode) << "\n";
-            throw(std::system_error(
-                errCode, std::generic_category(), "LinHttpHandler: Failed to write message to socket"));
+            return Connection();
         }
-        else if (bytes == 0)
+        std::vector<Connection>& connections = pos->second;
+        Connection connection;
+        while (!connections.empty())
+        {
+            connection = std::move(connections.back());
+            connections.pop_back();
+            // An idle socket must not be readable, otherwise it was closed by the peer
+            // or contains garbage that would be mistaken for the next response
+            pollfd fd = {connection.socketFD, POLLIN, 0};
+            if (poll(&fd, 1, 0) == 0)
+            {
+                return connection;
+            }
+            close(connection.socketFD);
+            connection.socketFD = -1;
+        }
+        // Keep the buffer of the last closed connection for a new one
+        return connection;
+    }
+
+    //! \brief Returns a connection for reuse, closes it if there are already enough idle connections
+    void release(const std::string& adr, int port, Connection connection)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Connection>& connections = idle[std::make_pair(adr, port)];
+        if (connections.size() < maxIdle)
         {
-            break;
+            connections.push_back(std::move(connection));
         }
         else
         {
-            sent += bytes;
+            close(connection.socketFD);
         }
-    } while (sent < total);
+    }
 
-    // receive the response
-    std::string response;
-    char buffer[128] = {};
-    do
+    std::size_t maxIdle;
+
+private:
+    std::mutex mutex;
+    std::map<std::pair<std::string, int>, std::vector<Connection>> idle;
+};
+
+namespace
+{
+    // Reads once from the socket and passes the data to the parser.
+    // Returns whether there was data after the end of the response.
+    // Throws connection_reset if the connection was closed before anything was received.
+    bool ReadMore(Connection& connection, HttpResponseParser& parser)
     {
-        ssize_t bytes = read(socketFD, buffer, 127);
+        if (!connection.buffer)
+        {
+            connection.buffer.reset(new char[receiveBufferSize]);
+        }
+        ssize_t bytes;
+        while ((bytes = read(connection.socketFD, connection.buffer.get(), receiveBufferSize)) < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                WaitFor(connection.socketFD, POLLIN, connection.deadline);
+            }
+            else if (errno != EINTR)
+            {
+                break;
+            }
+        }
         if (bytes < 0)
         {
             int errCode = errno;
-            std::cerr << "LinHttpHandler: Failed to read response from socket: " << std::strerror(errCode) << std::endl;
+            HUE_LOG(LogLevel::error, "LinHttpHandler: Failed to read response from socket: " << std::strerror(errCode));
             throw(std::system_error(
                 errCode, std::generic_category(), "LinHttpHandler: Failed to read response from socket"));
         }
         else if (bytes == 0)
         {
-            break;
+            if (!parser.finish())
+            {
+                throw(std::system_error(std::make_error_code(std::errc::connection_reset),
+                    "LinHttpHandler: Connection closed before response"));
+            }
+            // Connection closed, the response ends with whatever was received
+            return false;
         }
-        else
+        connection.received = true;
+        return parser.feed(connection.buffer.get(), bytes) != static_cast<std::size_t>(bytes);
+    }
+
+    // Reads one response from the socket into the buffer of the connection.
+    // Returns whether the connection can be used for another request.
+    bool ReadResponse(Connection& connection, bool headRequest, std::string& response)
+    {
+        HttpResponseParser parser(headRequest);
+        bool trailingData = false;
+        while (!parser.isComplete())
+        {
+            trailingData = ReadMore(connection, parser);
+        }
+        response = parser.takeResponse();
+        // Additional data after the response would be mistaken for the next response
+        return parser.isKeepAlive() && !trailingData;
+    }
+
+    // Stream buffer that reads the body of a response from the connection while it is received.
+    // The body is not copied, the get area points into the receive buffer of the connection.
+    class BodyStreambuf : public std::streambuf
+    {
+    public:
+        BodyStreambuf(Connection& connection, HttpResponseParser& parser)
+            : connection(connection), parser(parser), next(0), trailingData(false)
         {
-            response.append(buffer, bytes);
+            parser.setBodyCallback([this](const char* data, std::size_t size) { pieces.emplace_back(data, size); });
         }
-    } while (true);
 
+        // Reads until all headers are received or the connection is closed
+        void readHeaders()
+        {
+            while (!parser.isComplete() && parser.getBodyStart() == std::string::npos)
+            {
+                trailingData = ReadMore(connection, parser);
+            }
+        }
+
+        // Whether the connection can be used for another request
+        bool isReusable() const { return parser.isComplete() && parser.isKeepAlive() && !trailingData; }
+
+    protected:
+        int_type underflow() override
+        {
+            // Only read again when all pieces are used, because they point into the receive buffer
+            while (next == pieces.size())
+            {
+                if (parser.isComplete())
+                {
+                    return traits_type::eof();
+                }
+                pieces.clear();
+                next = 0;
+                trailingData = ReadMore(connection, parser);
+            }
+            // The stream only reads from the get area
+            char* begin = const_cast<char*>(pieces[next].first);
+            setg(begin, begin, begin + pieces[next].second);
+            ++next;
+            return traits_type::to_int_type(*begin);
+        }
+
+    private:
+        Connection& connection;
+        HttpResponseParser& parser;
+        std::vector<std::pair<const char*, std::size_t>> pieces;
+        std::size_t next;
+        bool trailingData;
+    };
+
+    bool IsHeadRequest(const std::string& msg)
+    {
+        return msg.compare(0, 5, "HEAD ") == 0;
+    }
+
+    bool IsHeadRequest(const HttpRequestWriter& request)
+    {
+        return request.isHeadRequest();
+    }
+
+    // Reads the headers of a response and passes the body to onBody while it is received.
+    // Returns whether the connection can be used for another request.
+    template <typename Message>
+    bool StreamResponse(Connection& connection, const Message& msg, const std::function<void(std::istream&)>& onBody)
+    {
+        HttpResponseParser parser(IsHeadRequest(msg));
+        BodyStreambuf buffer(connection, parser);
+        buffer.readHeaders();
+        if (parser.getBodyStart() == std::string::npos)
+        {
+            HUE_LOG(LogLevel::error, "LinHttpHandler: Failed to find body in response");
+            HUE_LOG(LogLevel::debug, "Request:\n\"" << msg << "\"\nResponse:\n\"" << parser.getResponse() << "\"");
+            throw HueException(CURRENT_FILE_INFO, "Failed to find body in response");
+        }
+        std::istream body(&buffer);
+        onBody(body);
+        // When onBody did not read the whole body, the rest is discarded with the connection
+        return buffer.isReusable();
+    }
+
+    // Writes the whole message to the socket.
+    void WriteMessage(const Connection& connection, const std::string& msg)
+    {
+        size_t total = msg.length();
+        size_t sent = 0;
+        do
+        {
+            // MSG_NOSIGNAL: a connection closed by the peer must not raise SIGPIPE
+            ssize_t bytes = ::send(connection.socketFD, msg.c_str() + sent, total - sent, MSG_NOSIGNAL);
+            if (bytes < 0)
+            {
+                int errCode = errno;
+                if (errCode == EAGAIN || errCode == EWOULDBLOCK)
+                {
+                    WaitFor(connection.socketFD, POLLOUT, connection.deadline);
+                    continue;
+                }
+                if (errCode == EINTR)
+                {
+                    continue;
+                }
+                HUE_LOG(LogLevel::error, "LinHttpHandler: Failed to write message to socket: "
+                        << std::strerror(errCode));
+                throw(std::system_error(
+                    errCode, std::generic_category(), "LinHttpHandler: Failed to write message to socket"));
+            }
+            else if (bytes == 0)
+            {
+                break;
+            }
+            else
+            {
+                sent += bytes;
+            }
+        } while (sent < total);
+    }
+
+    // Writes all pieces of the request to the socket without concatenating them.
+    void WriteMessage(const Connection& connection, const HttpRequestWriter& request)
+    {
+        iovec buffers[HttpRequestWriter::maxBuffers];
+        for (std::size_t i = 0; i < request.getBufferCount(); ++i)
+        {
+            buffers[i].iov_base = const_cast<char*>(request.getBuffers()[i].data);
+            buffers[i].iov_len = request.getBuffers()[i].size;
+        }
+        msghdr message = {};
+        message.msg_iov = buffers;
+        message.msg_iovlen = request.getBufferCount();
+        while (message.msg_iovlen > 0)
+        {
+            // sendmsg instead of writev, because only send functions accept MSG_NOSIGNAL
+            ssize_t bytes = sendmsg(connection.socketFD, &message, MSG_NOSIGNAL);
+            if (bytes < 0)
+            {
+                int errCode = errno;
+                if (errCode == EAGAIN || errCode == EWOULDBLOCK)
+                {
+                    WaitFor(connection.socketFD, POLLOUT, connection.deadline);
+                    continue;
+                }
+                if (errCode == EINTR)
+                {
+                    continue;
+                }
+                HUE_LOG(LogLevel::error, "LinHttpHandler: Failed to write message to socket: "
+                        << std::strerror(errCode));
+                throw(std::system_error(
+                    errCode, std::generic_category(), "LinHttpHandler: Failed to write message to socket"));
+            }
+            else if (bytes == 0)
+            {
+                break;
+            }
+            // Skip what was sent, the kernel may have sent only part of the pieces
+            std::size_t sent = bytes;
+            while (message.msg_iovlen > 0 && sent >= message.msg_iov->iov_len)
+            {
+                sent -= message.msg_iov->iov_len;
+                ++message.msg_iov;
+                --message.msg_iovlen;
+            }
+            if (message.msg_iovlen > 0)
+            {
+                message.msg_iov->iov_base = static_cast<char*>(message.msg_iov->iov_base) + sent;
+                message.msg_iov->iov_len -= sent;
+            }
+        }
+    }
+
+    // Opens a new socket connected to the first reachable address.
+    // The socket is non-blocking, so all operations on it can wait for the deadline.
+    int Connect(const std::vector<HostResolver::Address>& addresses, RequestOptions::Clock::time_point deadline)
+    {
+        int errCode = 0;
+        for (const HostResolver::Address& address : addresses)
+        {
+            // create socket
+            int socketFD = socket(address.family(), SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+            SocketCloser closeMySocket(socketFD);
+            if (socketFD < 0)
+            {
+                errCode = errno;
+                HUE_LOG(LogLevel::error, "LinHttpHandler: Failed to open socket: " << std::strerror(errCode));
+                throw(std::system_error(errCode, std::generic_category(), "LinHttpHandler: Failed to open socket"));
+            }
+
+            // connect the socket
+            if (connect(socketFD, reinterpret_cast<const sockaddr*>(&address.address), address.length) == 0)
+            {
+                return closeMySocket.release();
+            }
+            errCode = errno;
+            if (errCode == EINPROGRESS)
+            {
+                WaitFor(socketFD, POLLOUT, deadline);
+                socklen_t length = sizeof(errCode);
+                if (getsockopt(socketFD, SOL_SOCKET, SO_ERROR, &errCode, &length) < 0)
+                {
+                    errCode = errno;
+                }
+                if (errCode == 0)
+                {
+                    return closeMySocket.release();
+                }
+            }
+        }
+        HUE_LOG(LogLevel::error, "LinHttpHandler: Failed to connect socket: " << std::strerror(errCode));
+        throw(std::system_error(errCode, std::generic_category(), "LinHttpHandler: Failed to connect socket"));
+    }
+
+    // Sends the message over an idle connection or a new one and reads the response with read,
+    // which returns whether the connection can be used for another request.
+    // If the peer closed an idle connection before anything was received, nothing was processed
+    // and the message is sent again on another connection.
+    // The deadline covers the whole exchange including connecting and retries.
+    template <typename Pool, typename Message, typename Read>
+    void Exchange(Pool* pool, HostResolver& resolver, const Message& msg, const std::string& adr, int port,
+        RequestOptions::Clock::time_point deadline, Read read)
+    {
+        Connection connection = pool ? pool->acquire(adr, port) : Connection();
+        while (connection.socketFD >= 0)
+        {
+            SocketCloser closeMySocket(connection.socketFD);
+            connection.received = false;
+            connection.deadline = deadline;
+            try
+            {
+                WriteMessage(connection, msg);
+                if (read(connection))
+                {
+                    closeMySocket.release();
+                    pool->release(adr, port, std::move(connection));
+                }
+                return;
+            }
+            catch (const std::system_error& e)
+            {
+                if (connection.received
+                    || (e.code() != std::errc::connection_reset && e.code() != std::errc::broken_pipe))
+                {
+                    throw;
+                }
+            }
+            Connection next = pool->acquire(adr, port);
+            if (!next.buffer)
+            {
+                next.buffer = std::move(connection.buffer);
+            }
+            connection = std::move(next);
+        }
+
+        connection.socketFD = Connect(resolver.resolve(adr, port), deadline);
+        SocketCloser closeMySocket(connection.socketFD);
+        connection.received = false;
+        connection.deadline = deadline;
+        WriteMessage(connection, msg);
+        if (read(connection) && pool)
+        {
+            closeMySocket.release();
+            pool->release(adr, port, std::move(connection));
+        }
+    }
+} // namespace
+
+LinHttpHandler::LinHttpHandler()
+    : keepAlive(true), timeout(std::chrono::seconds(10)), pool(new ConnectionPool(4)), resolver()
+{}
+
+LinHttpHandler::~LinHttpHandler() = default;
+
+void LinHttpHandler::setKeepAlive(bool enable)
+{
+    keepAlive = enable;
+}
+
+void LinHttpHandler::setMaxIdleConnections(std::size_t count)
+{
+    pool->maxIdle = count;
+}
+
+void LinHttpHandler::setTimeout(std::chrono::steady_clock::duration timeout)
+{
+    this->timeout = timeout;
+}
+
+void LinHttpHandler::setHostCacheTTL(std::chrono::steady_clock::duration ttl)
+{
+    resolver.setTTL(ttl);
+}
+
+bool LinHttpHandler::useKeepAlive() const
+{
+    return keepAlive;
+}
+
+std::string LinHttpHandler::send(const std::string& msg, const std::string& adr, int port) const
+{
+    const bool headRequest = IsHeadRequest(msg);
+    const RequestOptions::Clock::time_point deadline = RequestOptions::current().deadlineWithin(timeout);
+    std::string response;
+    Exchange(keepAlive ? pool.get() : nullptr, resolver, msg, adr, port, deadline,
+        [&](Connection& connection) { return ReadResponse(connection, headRequest, response); });
+    return response;
+}
+
+void LinHttpHandler::sendGetHTTPBody(const std::string& msg, const std::function<void(std::istream&)>& onBody,
+    const std::string& adr, int port) const
+{
+    const RequestOptions::Clock::time_point deadline = RequestOptions::current().deadlineWithin(timeout);
+    Exchange(keepAlive ? pool.get() : nullptr, resolver, msg, adr, port, deadline,
+        [&](Connection& connection) { return StreamResponse(connection, msg, onBody); });
+}
+
+std::string LinHttpHandler::sendRequest(const HttpRequestWriter& request, const std::string& adr, int port) const
+{
+    const RequestOptions::Clock::time_point deadline = RequestOptions::current().deadlineWithin(timeout);
+    std::string response;
+    Exchange(keepAlive ? pool.get() : nullptr, resolver, request, adr, port, deadline,
+        [&](Connection& connection) { return ReadResponse(connection, request.isHeadRequest(), response); });
     return response;
 }
 
+void LinHttpHandler::sendRequest(const HttpRequestWriter& request, const std::function<void(std::istream&)>& onBody,
+    const std::string& adr, int port) const
+{
+    const RequestOptions::Clock::time_point deadline = RequestOptions::current().deadlineWithin(timeout);
+    Exchange(keepAlive ? pool.get() : nullptr, resolver, request, adr, port, deadline,
+        [&](Connection& connection) { return StreamResponse(connection, request, onBody); });
+}
+
 std::vector<std::string> LinHttpHandler::sendMulticast(
     const std::string& msg, const std::string& adr, int port, int timeout) const
 {
-    hostent* server; // host information
-    sockaddr_in server_addr; // server address
-
-    // fill in the server's address and data
-    memset((char*)&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
+    std::vector<std::string> returnString;
+    sendMulticast(
+        msg,
+        [&](const std::string& answer) {
+            returnString.push_back(answer);
+            return true;
+        },
+        adr, port, timeout);
+    return returnString;
+}
 
+void LinHttpHandler::sendMulticast(const std::string& msg, const std::function<bool(const std::string&)>& onAnswer,
+    const std::string& adr, int port, int timeout) const
+{
     // look up the address of the server given its name
-    server = gethostbyname(adr.c_str());
-    if (!server)
-    {
-        int errCode = errno;
-        std::cerr << "LinHttpHandler: sendMulticast: Failed to obtain address of " << msg << ": "
-                  << std::strerror(errCode) << "\n";
-        throw(std::system_error(
-            errCode, std::generic_category(), "LinHttpHandler: sendMulticast: Failed to obtain address of host"));
-    }
-
-    // put the host's address into the server address structure
-    memcpy((void*)&server_addr.sin_addr, server->h_addr_list[0], server->h_length);
+    const HostResolver::Address server = resolver.resolve(adr, port).front();
 
     // create the socket
-    int socketFD = socket(AF_INET, SOCK_DGRAM, 0);
+    int socketFD = socket(server.family(), SOCK_DGRAM, 0);
     SocketCloser closeMySendSocket(socketFD);
     if (socketFD < 0)
     {
         int errCode = errno;
-        std::cerr << "LinHttpHandler: sendMulticast: Failed to open socket: " << std::strerror(errCode) << "\n";
+        HUE_LOG(LogLevel::error, "LinHttpHandler: sendMulticast: Failed to open socket: " << std::strerror(errCode));
         throw(std::system_error(
             errCode, std::generic_category(), "LinHttpHandler: sendMulticast: Failed to open socket"));
     }
 
     // send a message to the server
-    if (sendto(socketFD, msg.c_str(), strlen(msg.c_str()), 0, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0)
+    if (sendto(socketFD, msg.c_str(), msg.size(), 0, reinterpret_cast<const sockaddr*>(&server.address), server.length)
+        < 0)
     {
         int errCode = errno;
-        std::cerr << "LinHttpHandler: sendMulticast: Failed to send message: " << std::strerror(errCode) << "\n";
+        HUE_LOG(LogLevel::error, "LinHttpHandler: sendMulticast: Failed to send message: " << std::strerror(errCode));
         throw(std::system_error(
             errCode, std::generic_category(), "LinHttpHandler: sendMulticast: Failed to send message"));
     }
 
-    std::string response;
     char buffer[2048] = {}; // receive buffer
 
-    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(timeout))
+    const std::chrono::steady_clock::time_point deadline
+        = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+    while (true)
     {
-        ssize_t bytesReceived = recv(socketFD, &buffer, 2048, MSG_DONTWAIT);
+        // Sleep in poll until a datagram arrives or the deadline is reached
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now() + std::chrono::microseconds(999));
+        if (remaining.count() <= 0)
+        {
+            return;
+        }
+        pollfd fd = {socketFD, POLLIN, 0};
+        int ready = poll(&fd, 1, static_cast<int>(remaining.count()));
+        if (ready < 0)
+        {
+            int errCode = errno;
+            if (errCode == EINTR)
+            {
+                continue;
+            }
+            HUE_LOG(LogLevel::error, "LinHttpHandler: sendMulticast: Failed to wait for response: "
+                    << std::strerror(errCode));
+            throw(std::system_error(
+                errCode, std::generic_category(), "LinHttpHandler: sendMulticast: Failed to wait for response"));
+        }
+        else if (ready == 0)
+        {
+            return;
+        }
+
+        ssize_t bytesReceived = recv(socketFD, &buffer, sizeof(buffer), MSG_DONTWAIT);
         if (bytesReceived < 0)
         {
             int errCode = errno;
-            if (errCode != EAGAIN && errCode != EWOULDBLOCK)
+            if (errCode != EAGAIN && errCode != EWOULDBLOCK && errCode != EINTR)
             {
-                std::cerr << "LinHttpHandler: sendMulticast: Failed to read response "
-                             "from socket: "
-                          << std::strerror(errCode) << "\n";
+                HUE_LOG(LogLevel::error, "LinHttpHandler: sendMulticast: Failed to read response from socket: "
+                        << std::strerror(errCode));
                 throw(std::system_error(errCode, std::generic_category(),
                     "LinHttpHandler: sendMulticast: Failed to read "
                     "response from socket"));
             }
             continue;
         }
-        if (bytesReceived)
+
+        // every answer ends with an empty line
+        const std::string response(buffer, bytesReceived);
+        size_t pos = response.find("\r\n\r\n");
+        size_t prevpos = 0;
+        while (pos != std::string::npos)
         {
-            response.append(buffer, bytesReceived);
+            if (!onAnswer(response.substr(prevpos, pos - prevpos)))
+            {
+                return;
+            }
+            pos += 4;
+            prevpos = pos;
+            pos = response.find("\r\n\r\n", pos);
         }
     }
-
-    // construct return vector
-    std::vector<std::string> returnString;
-    size_t pos = response.find("\r\n\r\n");
-    size_t prevpos = 0;
-    while (pos != std::string::npos)
-    {
-        returnString.push_back(response.substr(prevpos, pos - prevpos));
-        pos += 4;
-        prevpos = pos;
-        pos = response.find("\r\n\r\n", pos);
-    }
-    return returnString;
 }
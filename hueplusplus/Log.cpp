@@ -0,0 +1,70 @@
+/**
+    \file Log.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/Log.h"
+
+#include <iostream>
+#include <mutex>
+
+namespace
+{
+    void WriteToCerr(LogLevel, const std::string& message)
+    {
+        std::cerr << message << '\n';
+    }
+
+    std::mutex sinkMutex;
+    Log::Sink currentSink = WriteToCerr;
+} // namespace
+
+std::atomic<int> Log::minLevel(static_cast<int>(LogLevel::info));
+
+void Log::setSink(Sink sink)
+{
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    currentSink = std::move(sink);
+}
+
+void Log::resetSink()
+{
+    setSink(WriteToCerr);
+}
+
+void Log::setLevel(LogLevel level)
+{
+    minLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Log::getLevel()
+{
+    return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed));
+}
+
+void Log::write(LogLevel level, const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (currentSink)
+    {
+        currentSink(level, message);
+    }
+}
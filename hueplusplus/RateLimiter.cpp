@@ -0,0 +1,71 @@
+/**
+    \file RateLimiter.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/RateLimiter.h"
+
+#include <algorithm>
+
+RateLimiter::RateLimiter(Clock::duration interval, std::size_t burst)
+    : interval(interval.count()),
+      burst(std::max<std::size_t>(burst, 1)),
+      emptyUntil(Clock::now().time_since_epoch().count())
+{}
+
+bool RateLimiter::tryReserve(Clock::time_point& next)
+{
+    const Clock::rep now = Clock::now().time_since_epoch().count();
+    const Clock::rep step = interval.load(std::memory_order_relaxed);
+    // A full bucket holds burst tokens, so a request can start burst - 1 steps before the bucket is empty
+    const Clock::rep tolerance = step * static_cast<Clock::rep>(burst.load(std::memory_order_relaxed) - 1);
+    Clock::rep current = emptyUntil.load(std::memory_order_relaxed);
+    do
+    {
+        const Clock::rep start = std::max(now, current - tolerance);
+        if (start > now)
+        {
+            next = Clock::time_point(Clock::duration(start));
+            return false;
+        }
+    } while (!emptyUntil.compare_exchange_weak(current, std::max(current, now) + step, std::memory_order_relaxed));
+    return true;
+}
+
+RateLimiter::Clock::duration RateLimiter::getInterval() const
+{
+    return Clock::duration(interval.load(std::memory_order_relaxed));
+}
+
+void RateLimiter::setInterval(Clock::duration interval)
+{
+    this->interval.store(interval.count(), std::memory_order_relaxed);
+}
+
+std::size_t RateLimiter::getBurst() const
+{
+    return burst.load(std::memory_order_relaxed);
+}
+
+void RateLimiter::setBurst(std::size_t burst)
+{
+    this->burst.store(std::max<std::size_t>(burst, 1), std::memory_order_relaxed);
+}
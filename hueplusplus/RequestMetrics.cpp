@@ -0,0 +1,401 @@
+/**
+    \file RequestMetrics.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/RequestMetrics.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <tuple>
+
+constexpr std::size_t LatencyHistogram::bucketCount;
+constexpr std::size_t RequestMetrics::maxEndpoints;
+constexpr std::size_t RequestMetrics::Endpoint::errorSlots;
+
+namespace
+{
+    // Parse time reported by the handlers of this thread, see RequestMetrics::addParseTime
+    thread_local RequestMetrics::Clock::duration parseTime {0};
+
+    // Values below have their own bucket, above each power of two has this many buckets
+    constexpr std::uint64_t subBuckets = 8;
+    constexpr unsigned int subBucketBits = 3;
+    // Largest value in microseconds that is distinguished
+    constexpr std::uint64_t maxMicros = (std::uint64_t(1) << 41) - 1;
+
+    // Position of the highest set bit
+    unsigned int HighestBit(std::uint64_t value)
+    {
+        unsigned int bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+    }
+
+    std::string EscapeLabel(const std::string& value)
+    {
+        std::string result;
+        result.reserve(value.size());
+        for (char c : value)
+        {
+            if (c == '\\' || c == '"')
+            {
+                result.push_back('\\');
+            }
+            if (c == '\n')
+            {
+                result.append("\\n");
+                continue;
+            }
+            result.push_back(c);
+        }
+        return result;
+    }
+
+    std::string Labels(const RequestMetrics::EndpointSnapshot& endpoint)
+    {
+        return "method=\"" + EscapeLabel(endpoint.method) + "\",path=\"" + EscapeLabel(endpoint.path) + "\"";
+    }
+
+    void WriteHistogram(std::ostream& out, const std::string& name,
+        const std::vector<RequestMetrics::EndpointSnapshot>& endpoints,
+        LatencyHistogram::Snapshot RequestMetrics::EndpointSnapshot::*phase)
+    {
+        // Upper bounds of the exported buckets in seconds
+        static const double bounds[] = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+        out << "# TYPE " << name << " histogram\n";
+        for (const RequestMetrics::EndpointSnapshot& endpoint : endpoints)
+        {
+            const LatencyHistogram::Snapshot& histogram = endpoint.*phase;
+            const std::string labels = Labels(endpoint);
+            for (double bound : bounds)
+            {
+                const auto limit = std::chrono::duration_cast<LatencyHistogram::Clock::duration>(
+                    std::chrono::duration<double>(bound));
+                out << name << "_bucket{" << labels << ",le=\"" << bound << "\"} " << histogram.countAtMost(limit)
+                    << '\n';
+            }
+            out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count << '\n';
+            out << name << "_sum{" << labels << "} " << std::chrono::duration<double>(histogram.sum).count() << '\n';
+            out << name << "_count{" << labels << "} " << histogram.count << '\n';
+        }
+    }
+} // namespace
+
+LatencyHistogram::Clock::duration LatencyHistogram::Snapshot::quantile(double q) const
+{
+    if (count == 0)
+    {
+        return Clock::duration::zero();
+    }
+    const std::uint64_t rank
+        = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * count)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return std::chrono::microseconds(upperBound(i));
+        }
+    }
+    return std::chrono::microseconds(upperBound(buckets.size() - 1));
+}
+
+std::uint64_t LatencyHistogram::Snapshot::countAtMost(Clock::duration limit) const
+{
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(limit).count();
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i < buckets.size() && micros >= 0 && upperBound(i) <= std::uint64_t(micros); ++i)
+    {
+        result += buckets[i];
+    }
+    return result;
+}
+
+LatencyHistogram::LatencyHistogram() : count(0), sumMicros(0)
+{
+    for (std::atomic<std::uint64_t>& bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(Clock::duration duration)
+{
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    const std::uint64_t value = micros > 0 ? static_cast<std::uint64_t>(micros) : 0;
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sumMicros.fetch_add(value, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot result;
+    result.buckets.reserve(bucketCount);
+    for (const std::atomic<std::uint64_t>& bucket : buckets)
+    {
+        result.buckets.push_back(bucket.load(std::memory_order_relaxed));
+        result.count += result.buckets.back();
+    }
+    // Sum may be slightly ahead or behind of the buckets while requests are recorded
+    result.sum = std::chrono::microseconds(sumMicros.load(std::memory_order_relaxed));
+    return result;
+}
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t micros)
+{
+    if (micros < subBuckets)
+    {
+        return static_cast<std::size_t>(micros);
+    }
+    micros = std::min(micros, maxMicros);
+    const unsigned int shift = HighestBit(micros) - subBucketBits;
+    return static_cast<std::size_t>(subBuckets + shift * subBuckets + ((micros >> shift) & (subBuckets - 1)));
+}
+
+std::uint64_t LatencyHistogram::upperBound(std::size_t bucket)
+{
+    if (bucket < subBuckets)
+    {
+        return bucket;
+    }
+    const std::uint64_t shift = (bucket - subBuckets) / subBuckets;
+    const std::uint64_t sub = (bucket - subBuckets) % subBuckets;
+    return ((subBuckets + sub + 1) << shift) - 1;
+}
+
+RequestMetrics::Endpoint::Endpoint(const std::string& method, const std::string& path)
+    : method(method), path(path), successes(0), failures(0), retries(0), coalesced(0)
+{
+    for (std::atomic<int>& type : errorTypes)
+    {
+        type.store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<std::uint64_t>& errorCount : errorCounts)
+    {
+        errorCount.store(0, std::memory_order_relaxed);
+    }
+}
+
+void RequestMetrics::Endpoint::recordAPIError(int type)
+{
+    if (type != 0)
+    {
+        for (std::size_t i = 0; i < errorSlots; ++i)
+        {
+            int current = errorTypes[i].load(std::memory_order_acquire);
+            // Claims a free slot for the type
+            if (current == 0 && errorTypes[i].compare_exchange_strong(current, type, std::memory_order_acq_rel))
+            {
+                current = type;
+            }
+            if (current == type)
+            {
+                errorCounts[i].fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+    errorCounts[errorSlots].fetch_add(1, std::memory_order_relaxed);
+}
+
+RequestMetrics::EndpointSnapshot RequestMetrics::Endpoint::snapshot() const
+{
+    EndpointSnapshot result;
+    result.method = method;
+    result.path = path;
+    result.queueWait = queueWait.snapshot();
+    result.network = network.snapshot();
+    result.parse = parse.snapshot();
+    result.total = total.snapshot();
+    result.successes = successes.load(std::memory_order_relaxed);
+    result.failures = failures.load(std::memory_order_relaxed);
+    result.retries = retries.load(std::memory_order_relaxed);
+    result.coalesced = coalesced.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i <= errorSlots; ++i)
+    {
+        const std::uint64_t errorCount = errorCounts[i].load(std::memory_order_relaxed);
+        if (errorCount != 0)
+        {
+            result.apiErrors[i < errorSlots ? errorTypes[i].load(std::memory_order_relaxed) : 0] += errorCount;
+        }
+    }
+    return result;
+}
+
+RequestMetrics::RequestMetrics() : overflow("*", "*")
+{
+    for (std::atomic<Endpoint*>& endpoint : endpoints)
+    {
+        endpoint.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+RequestMetrics::~RequestMetrics()
+{
+    for (std::atomic<Endpoint*>& endpoint : endpoints)
+    {
+        delete endpoint.load(std::memory_order_relaxed);
+    }
+}
+
+RequestMetrics::Endpoint& RequestMetrics::getEndpoint(const std::string& method, const std::string& path)
+{
+    const std::string normalized = normalizePath(path);
+    const std::size_t start = std::hash<std::string>()(method + ' ' + normalized) % maxEndpoints;
+    std::unique_ptr<Endpoint> created;
+    // Open addressing with linear probing, slots are only ever filled
+    for (std::size_t i = 0; i < maxEndpoints; ++i)
+    {
+        std::atomic<Endpoint*>& slot = endpoints[(start + i) % maxEndpoints];
+        Endpoint* current = slot.load(std::memory_order_acquire);
+        if (current == nullptr)
+        {
+            if (!created)
+            {
+                created.reset(new Endpoint(method, normalized));
+            }
+            if (slot.compare_exchange_strong(current, created.get(), std::memory_order_acq_rel))
+            {
+                return *created.release();
+            }
+            // Another thread filled the slot, current is its endpoint
+        }
+        if (current->getMethod() == method && current->getPath() == normalized)
+        {
+            return *current;
+        }
+    }
+    return overflow;
+}
+
+std::vector<RequestMetrics::EndpointSnapshot> RequestMetrics::snapshot() const
+{
+    std::vector<EndpointSnapshot> result;
+    for (const std::atomic<Endpoint*>& slot : endpoints)
+    {
+        const Endpoint* endpoint = slot.load(std::memory_order_acquire);
+        if (endpoint != nullptr)
+        {
+            result.push_back(endpoint->snapshot());
+        }
+    }
+    EndpointSnapshot other = overflow.snapshot();
+    if (other.queueWait.count != 0 || other.network.count != 0 || other.parse.count != 0
+        || other.total.count != 0 || other.successes != 0 || other.failures != 0 || other.retries != 0
+        || other.coalesced != 0 || !other.apiErrors.empty())
+    {
+        result.push_back(std::move(other));
+    }
+    std::sort(result.begin(), result.end(), [](const EndpointSnapshot& lhs, const EndpointSnapshot& rhs) {
+        return std::tie(lhs.path, lhs.method) < std::tie(rhs.path, rhs.method);
+    });
+    return result;
+}
+
+std::string RequestMetrics::normalizePath(const std::string& path)
+{
+    std::string result;
+    result.reserve(path.size() + 1);
+    std::size_t start = path.empty() || path.front() != '/' ? 0 : 1;
+    while (start <= path.size())
+    {
+        std::size_t end = path.find('/', start);
+        if (end == std::string::npos)
+        {
+            end = path.size();
+        }
+        const std::string segment = path.substr(start, end - start);
+        if (!segment.empty() || end != path.size())
+        {
+            result.push_back('/');
+            const bool isId = std::any_of(
+                segment.begin(), segment.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+            result.append(isId ? "{id}" : segment);
+        }
+        start = end + 1;
+    }
+    return result.empty() ? "/" : result;
+}
+
+void RequestMetrics::addParseTime(Clock::duration duration)
+{
+    parseTime += duration;
+}
+
+RequestMetrics::Clock::duration RequestMetrics::takeParseTime()
+{
+    const Clock::duration result = parseTime;
+    parseTime = Clock::duration::zero();
+    return result;
+}
+
+std::string RequestMetrics::toPrometheus(const std::vector<EndpointSnapshot>& endpoints)
+{
+    std::ostringstream out;
+    WriteHistogram(out, "hueplusplus_request_queue_wait_seconds", endpoints, &EndpointSnapshot::queueWait);
+    WriteHistogram(out, "hueplusplus_request_network_seconds", endpoints, &EndpointSnapshot::network);
+    WriteHistogram(out, "hueplusplus_request_parse_seconds", endpoints, &EndpointSnapshot::parse);
+    WriteHistogram(out, "hueplusplus_request_total_seconds", endpoints, &EndpointSnapshot::total);
+
+    out << "# TYPE hueplusplus_requests_total counter\n";
+    for (const EndpointSnapshot& endpoint : endpoints)
+    {
+        std::uint64_t apiErrors = 0;
+        for (const auto& entry : endpoint.apiErrors)
+        {
+            apiErrors += entry.second;
+        }
+        const std::string labels = Labels(endpoint);
+        out << "hueplusplus_requests_total{" << labels << ",outcome=\"success\"} " << endpoint.successes << '\n';
+        out << "hueplusplus_requests_total{" << labels << ",outcome=\"api_error\"} " << apiErrors << '\n';
+        out << "hueplusplus_requests_total{" << labels << ",outcome=\"failure\"} " << endpoint.failures << '\n';
+    }
+    out << "# TYPE hueplusplus_request_retries_total counter\n";
+    for (const EndpointSnapshot& endpoint : endpoints)
+    {
+        out << "hueplusplus_request_retries_total{" << Labels(endpoint) << "} " << endpoint.retries << '\n';
+    }
+    out << "# TYPE hueplusplus_request_coalesced_total counter\n";
+    for (const EndpointSnapshot& endpoint : endpoints)
+    {
+        out << "hueplusplus_request_coalesced_total{" << Labels(endpoint) << "} " << endpoint.coalesced << '\n';
+    }
+    out << "# TYPE hueplusplus_request_api_errors_total counter\n";
+    for (const EndpointSnapshot& endpoint : endpoints)
+    {
+        for (const auto& entry : endpoint.apiErrors)
+        {
+            out << "hueplusplus_request_api_errors_total{" << Labels(endpoint) << ",type=\"" << entry.first
+                << "\"} " << entry.second << '\n';
+        }
+    }
+    return out.str();
+}
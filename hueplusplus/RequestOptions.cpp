@@ -0,0 +1,74 @@
+/**
+    \file RequestOptions.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/RequestOptions.h"
+
+#include <algorithm>
+
+namespace
+{
+    thread_local RequestOptions currentOptions;
+} // namespace
+
+RequestOptions::Scope::Scope(const RequestOptions& options) : previous(currentOptions)
+{
+    currentOptions = options;
+}
+
+RequestOptions::Scope::~Scope()
+{
+    currentOptions = previous;
+}
+
+const RequestOptions& RequestOptions::current()
+{
+    return currentOptions;
+}
+
+RequestOptions RequestOptions::withTimeout(Clock::duration timeout)
+{
+    RequestOptions result = currentOptions;
+    result.deadline = result.deadlineWithin(timeout);
+    return result;
+}
+
+RequestOptions RequestOptions::withPriority(Priority priority)
+{
+    RequestOptions result = currentOptions;
+    result.priority = priority;
+    return result;
+}
+
+RequestOptions::Clock::time_point RequestOptions::deadlineWithin(Clock::duration timeout) const
+{
+    if (timeout <= Clock::duration::zero())
+    {
+        return deadline;
+    }
+    const Clock::time_point now = Clock::now();
+    // Avoid overflow for very long timeouts
+    if (timeout >= deadline - now)
+    {
+        return deadline;
+    }
+    return now + timeout;
+}
@@ -0,0 +1,117 @@
+/**
+    \file RequestScheduler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/RequestScheduler.h"
+
+#include <algorithm>
+#include <system_error>
+
+#include "include/Log.h"
+
+namespace
+{
+    // Waits until notified or until time, which may be Clock::time_point::max()
+    void WaitUntil(std::condition_variable& condition, std::unique_lock<std::mutex>& lock,
+        RequestScheduler::Clock::time_point time)
+    {
+        if (time == RequestScheduler::Clock::time_point::max())
+        {
+            condition.wait(lock);
+        }
+        else
+        {
+            condition.wait_until(lock, time);
+        }
+    }
+} // namespace
+
+RequestScheduler::RequestScheduler(Clock::duration interval)
+    : rateLimiter(interval), pacer(rateLimiter), waitingCount(0), nextSequence(0), agingDelay(std::chrono::seconds(5))
+{}
+
+void RequestScheduler::wait(RequestOptions::Priority priority, Clock::time_point deadline)
+{
+    Clock::time_point next;
+    // Lock-free fast path when nobody else is waiting
+    if (waitingCount.load(std::memory_order_acquire) == 0 && rateLimiter.tryReserve(next))
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    const Ticket ticket(Clock::now() + agingDelay * static_cast<int>(priority), nextSequence++);
+    waiting.insert(ticket);
+    waitingCount.fetch_add(1, std::memory_order_release);
+    // Others may have to wait longer now
+    changed.notify_all();
+    while (true)
+    {
+        if (*waiting.begin() == ticket)
+        {
+            if (rateLimiter.tryReserve(next))
+            {
+                break;
+            }
+            // Woken up early when a request with higher priority arrives
+            WaitUntil(changed, lock, std::min(next, deadline));
+        }
+        else
+        {
+            WaitUntil(changed, lock, deadline);
+        }
+        if (Clock::now() >= deadline)
+        {
+            waiting.erase(ticket);
+            waitingCount.fetch_sub(1, std::memory_order_release);
+            changed.notify_all();
+            HUE_LOG(LogLevel::error, "RequestScheduler: Request timed out while waiting for its turn");
+            throw std::system_error(
+                std::make_error_code(std::errc::timed_out), "RequestScheduler: Request timed out while waiting");
+        }
+    }
+    waiting.erase(ticket);
+    waitingCount.fetch_sub(1, std::memory_order_release);
+    // The next request can now wait for its start time
+    changed.notify_all();
+}
+
+RateLimiter& RequestScheduler::getRateLimiter()
+{
+    return rateLimiter;
+}
+
+AdaptivePacer& RequestScheduler::getPacer()
+{
+    return pacer;
+}
+
+RequestScheduler::Clock::duration RequestScheduler::getAgingDelay() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return agingDelay;
+}
+
+void RequestScheduler::setAgingDelay(Clock::duration delay)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    agingDelay = delay;
+}
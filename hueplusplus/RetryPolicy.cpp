@@ -0,0 +1,88 @@
+/**
+    \file RetryPolicy.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/RetryPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    // Error type of the bridge when it is overloaded
+    constexpr int internalError = 901;
+} // namespace
+
+RetryPolicy::RetryPolicy() : settings() {}
+
+RetryPolicy::RetryPolicy(const Settings& settings) : settings(settings) {}
+
+const RetryPolicy::Settings& RetryPolicy::getSettings() const
+{
+    return settings;
+}
+
+bool RetryPolicy::shouldRetry(const Failure& failure, Clock::duration& delay) const
+{
+    if (failure.attempt >= settings.maxAttempts || !isRetryable(failure))
+    {
+        return false;
+    }
+    delay = getBackoff(failure);
+    return settings.budget == Clock::duration::zero() || failure.elapsed + delay < settings.budget;
+}
+
+bool RetryPolicy::isRetryable(const Failure& failure) const
+{
+    if (!failure.idempotent && !settings.retryPUT)
+    {
+        return false;
+    }
+    switch (failure.type)
+    {
+    case ErrorType::transport:
+        // Happens when hue is too busy
+        return failure.code == std::errc::connection_reset || failure.code == std::errc::timed_out;
+    case ErrorType::http:
+        return settings.retryHttpErrors;
+    case ErrorType::api:
+        return settings.retryInternalErrors && failure.apiError == internalError;
+    default:
+        return false;
+    }
+}
+
+RetryPolicy::Clock::duration RetryPolicy::getBackoff(const Failure& failure) const
+{
+    // Each thread has its own generator, so policies can be shared without locking
+    thread_local std::minstd_rand random(std::random_device {}());
+    std::uniform_real_distribution<double> distribution(0.0, std::max(settings.jitter, 0.0));
+
+    const double exponent = failure.attempt > 0 ? failure.attempt - 1.0 : 0.0;
+    double backoff = std::chrono::duration<double>(settings.initialBackoff).count()
+        * std::pow(std::max(settings.backoffFactor, 1.0), exponent);
+    backoff = std::min(backoff, std::chrono::duration<double>(settings.maxBackoff).count());
+    backoff *= 1.0 + distribution(random);
+    return std::max(failure.interval,
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(backoff)));
+}
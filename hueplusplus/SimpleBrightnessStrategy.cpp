@@ -84,5 +84,5 @@ unsigned int SimpleBrightnessStrategy::getBrightness(HueLight& light) const
 
 unsigned int SimpleBrightnessStrategy::getBrightness(const HueLight& light) const
 {
-    return light.state["state"]["bri"];
+    return (*light.getStateSnapshot())["state"]["bri"];
 }
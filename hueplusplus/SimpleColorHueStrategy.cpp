@@ -404,8 +404,9 @@ std::pair<uint16_t, uint8_t> SimpleColorHueStrategy::getColorHueSaturation(HueLi
 
 std::pair<uint16_t, uint8_t> SimpleColorHueStrategy::getColorHueSaturation(const HueLight& light) const
 {
+    const std::shared_ptr<const nlohmann::json> current = light.getStateSnapshot();
     return std::pair<uint16_t, uint8_t>(
-        static_cast<uint16_t>(light.state["state"]["hue"]), static_cast<uint8_t>(light.state["state"]["sat"]));
+        static_cast<uint16_t>((*current)["state"]["hue"]), static_cast<uint8_t>((*current)["state"]["sat"]));
 }
 
 std::pair<float, float> SimpleColorHueStrategy::getColorXY(HueLight& light) const
@@ -416,7 +417,8 @@ std::pair<float, float> SimpleColorHueStrategy::getColorXY(HueLight& light) cons
 
 std::pair<float, float> SimpleColorHueStrategy::getColorXY(const HueLight& light) const
 {
-    return std::pair<float, float>(light.state["state"]["xy"][0], light.state["state"]["xy"][1]);
+    const std::shared_ptr<const nlohmann::json> current = light.getStateSnapshot();
+    return std::pair<float, float>((*current)["state"]["xy"][0], (*current)["state"]["xy"][1]);
 }
 /*bool SimpleColorHueStrategy::pointInTriangle(float pointx, float pointy, float
 x0, float y0, float x1, float y1, float x2, float y2)
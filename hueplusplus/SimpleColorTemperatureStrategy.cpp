@@ -109,5 +109,5 @@ unsigned int SimpleColorTemperatureStrategy::getColorTemperature(HueLight& light
 
 unsigned int SimpleColorTemperatureStrategy::getColorTemperature(const HueLight& light) const
 {
-    return light.state["state"]["ct"];
+    return (*light.getStateSnapshot())["state"]["ct"];
 }
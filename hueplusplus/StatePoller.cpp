@@ -0,0 +1,335 @@
+/**
+    \file StatePoller.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/StatePoller.h"
+
+#include <exception>
+#include <utility>
+
+#include "include/FilteringJsonSax.h"
+#include "include/HueExceptionMacro.h"
+#include "include/Log.h"
+#include "include/RequestOptions.h"
+
+namespace
+{
+    // Escapes a key for use as a JSON pointer token, see https://tools.ietf.org/html/rfc6901#section-3
+    std::string EscapeToken(const std::string& key)
+    {
+        std::string token;
+        token.reserve(key.size());
+        for (char c : key)
+        {
+            if (c == '~')
+            {
+                token += "~0";
+            }
+            else if (c == '/')
+            {
+                token += "~1";
+            }
+            else
+            {
+                token += c;
+            }
+        }
+        return token;
+    }
+} // namespace
+
+StatePoller::StatePoller(const HueCommandAPI& commands, std::chrono::milliseconds interval)
+    : commands(commands), interval(interval)
+{
+    pollThread = std::thread(&StatePoller::RunPoll, this);
+    dispatchThread = std::thread(&StatePoller::RunDispatch, this);
+}
+
+StatePoller::~StatePoller()
+{
+    stop();
+}
+
+void StatePoller::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+        pending.clear();
+    }
+    pollWakeup.notify_all();
+    dispatchWakeup.notify_all();
+    if (pollThread.joinable())
+    {
+        pollThread.join();
+    }
+    if (dispatchThread.joinable())
+    {
+        dispatchThread.join();
+    }
+}
+
+bool StatePoller::isRunning() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return !stopped;
+}
+
+void StatePoller::setInterval(std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->interval = interval;
+}
+
+std::chrono::milliseconds StatePoller::getInterval() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return interval;
+}
+
+std::uint64_t StatePoller::subscribe(Subscriber subscriber)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::uint64_t id = nextSubscriberId++;
+    subscribers.emplace(id, std::move(subscriber));
+    return id;
+}
+
+void StatePoller::unsubscribe(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    subscribers.erase(id);
+}
+
+std::uint64_t StatePoller::addUpdateHandler(UpdateHandler handler)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::uint64_t id = nextSubscriberId++;
+    updateHandlers.emplace(id, std::move(handler));
+    return id;
+}
+
+void StatePoller::removeUpdateHandler(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    updateHandlers.erase(id);
+}
+
+std::chrono::steady_clock::time_point StatePoller::getUpdateTime() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return updateTime;
+}
+
+nlohmann::json StatePoller::getLightState(int id, std::chrono::steady_clock::time_point& time) const
+{
+    std::shared_ptr<const nlohmann::json> current;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = lights;
+        time = updateTime;
+    }
+    if (!current)
+    {
+        return nullptr;
+    }
+    auto it = current->find(std::to_string(id));
+    if (it == current->end())
+    {
+        return nullptr;
+    }
+    return *it;
+}
+
+std::vector<StatePoller::LightChange> StatePoller::diff(
+    const nlohmann::json& oldLights, const nlohmann::json& newLights)
+{
+    std::vector<LightChange> changes;
+    for (auto it = oldLights.begin(); it != oldLights.end(); ++it)
+    {
+        const int id = std::stoi(it.key());
+        auto newIt = newLights.find(it.key());
+        if (newIt == newLights.end())
+        {
+            changes.push_back({LightChange::Type::removed, id, "", it.value(), nullptr});
+        }
+        else
+        {
+            DiffValue(id, "", it.value(), newIt.value(), changes);
+        }
+    }
+    for (auto it = newLights.begin(); it != newLights.end(); ++it)
+    {
+        if (!oldLights.count(it.key()))
+        {
+            changes.push_back({LightChange::Type::added, std::stoi(it.key()), "", nullptr, it.value()});
+        }
+    }
+    return changes;
+}
+
+void StatePoller::Poll()
+{
+    nlohmann::json next;
+    {
+        // Only the lights are stored, the rest of the bridge state is skipped while parsing
+        FilteringJsonSax handler({"lights"});
+        RequestOptions::Scope scope(RequestOptions::withPriority(RequestOptions::Priority::background));
+        commands.GETRequest("", nlohmann::json::object(), handler, CURRENT_FILE_INFO);
+        next = handler.takeResult()["lights"];
+    }
+    if (!next.is_object())
+    {
+        HUE_LOG(LogLevel::warning, "StatePoller received a bridge state without lights");
+        return;
+    }
+    auto current = std::make_shared<const nlohmann::json>(std::move(next));
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::shared_ptr<const nlohmann::json> previous;
+    std::vector<UpdateHandler> handlers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        previous = lights;
+        lights = current;
+        updateTime = now;
+        handlers.reserve(updateHandlers.size());
+        for (const auto& entry : updateHandlers)
+        {
+            handlers.push_back(entry.second);
+        }
+    }
+    // Subscribers must see the state that caused a change
+    for (const UpdateHandler& handler : handlers)
+    {
+        try
+        {
+            handler(*current);
+        }
+        catch (const std::exception& e)
+        {
+            HUE_LOG(LogLevel::error, "StatePoller update handler threw: " << e.what());
+        }
+    }
+    if (!previous)
+    {
+        // The first state is the base for changes
+        return;
+    }
+    std::vector<LightChange> changes = diff(*previous, *current);
+    if (changes.empty())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped)
+        {
+            return;
+        }
+        for (LightChange& change : changes)
+        {
+            pending.push_back(std::move(change));
+        }
+    }
+    dispatchWakeup.notify_one();
+}
+
+void StatePoller::RunPoll()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopped)
+    {
+        lock.unlock();
+        try
+        {
+            Poll();
+        }
+        catch (const std::exception& e)
+        {
+            HUE_LOG(LogLevel::warning, "StatePoller could not poll the bridge: " << e.what());
+        }
+        lock.lock();
+        pollWakeup.wait_for(lock, interval, [this] { return stopped; });
+    }
+}
+
+void StatePoller::RunDispatch()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        dispatchWakeup.wait(lock, [this] { return stopped || !pending.empty(); });
+        if (stopped)
+        {
+            return;
+        }
+        std::deque<LightChange> changes;
+        changes.swap(pending);
+        std::vector<Subscriber> targets;
+        targets.reserve(subscribers.size());
+        for (const auto& entry : subscribers)
+        {
+            targets.push_back(entry.second);
+        }
+        lock.unlock();
+        for (const LightChange& change : changes)
+        {
+            for (const Subscriber& subscriber : targets)
+            {
+                try
+                {
+                    subscriber(change);
+                }
+                catch (const std::exception& e)
+                {
+                    HUE_LOG(LogLevel::error, "StatePoller subscriber threw: " << e.what());
+                }
+            }
+        }
+        lock.lock();
+    }
+}
+
+void StatePoller::DiffValue(int id, const std::string& attribute, const nlohmann::json& oldValue,
+    const nlohmann::json& newValue, std::vector<LightChange>& changes)
+{
+    if (oldValue.is_object() && newValue.is_object())
+    {
+        for (auto it = oldValue.begin(); it != oldValue.end(); ++it)
+        {
+            auto newIt = newValue.find(it.key());
+            DiffValue(id, attribute + '/' + EscapeToken(it.key()), it.value(),
+                newIt == newValue.end() ? nlohmann::json() : *newIt, changes);
+        }
+        for (auto it = newValue.begin(); it != newValue.end(); ++it)
+        {
+            if (!oldValue.count(it.key()))
+            {
+                DiffValue(id, attribute + '/' + EscapeToken(it.key()), nullptr, it.value(), changes);
+            }
+        }
+    }
+    else if (oldValue != newValue)
+    {
+        changes.push_back({LightChange::Type::changed, id, attribute, oldValue, newValue});
+    }
+}
@@ -0,0 +1,47 @@
+/**
+    \file SyncHttpHandler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "include/SyncHttpHandler.h"
+
+#include <utility>
+
+#include "include/HueExceptionMacro.h"
+
+SyncHttpHandler::SyncHttpHandler(
+    std::shared_ptr<const IAsyncHttpHandler> asyncHandler, std::shared_ptr<const IHttpHandler> multicastHandler)
+    : asyncHandler(std::move(asyncHandler)), multicastHandler(std::move(multicastHandler))
+{}
+
+std::string SyncHttpHandler::send(const std::string& msg, const std::string& adr, int port) const
+{
+    return asyncHandler->send(msg, adr, port).get();
+}
+
+std::vector<std::string> SyncHttpHandler::sendMulticast(
+    const std::string& msg, const std::string& adr, int port, int timeout) const
+{
+    if (!multicastHandler)
+    {
+        throw HueException(CURRENT_FILE_INFO, "SyncHttpHandler: No handler for multicast requests");
+    }
+    return multicastHandler->sendMulticast(msg, adr, port, timeout);
+}
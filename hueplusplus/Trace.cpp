@@ -0,0 +1,226 @@
+/**
+    \file Trace.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include "include/Trace.h"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Random ids like OpenTelemetry uses them, never 0
+    std::uint64_t NewId()
+    {
+        thread_local std::mt19937_64 random(std::random_device {}());
+        std::uint64_t id = 0;
+        while (id == 0)
+        {
+            id = random();
+        }
+        return id;
+    }
+} // namespace
+
+TraceChain::TraceChain() : interceptors(std::make_shared<Interceptors>()), enabled(false) {}
+
+TraceChain::TraceChain(const TraceChain& other) : interceptors(other.get()), enabled(!interceptors->empty()) {}
+
+TraceChain& TraceChain::operator=(const TraceChain& other)
+{
+    if (this != &other)
+    {
+        std::shared_ptr<const Interceptors> changed = other.get();
+        std::lock_guard<std::mutex> lock(mutex);
+        set(std::move(changed));
+    }
+    return *this;
+}
+
+void TraceChain::add(std::shared_ptr<TraceInterceptor> interceptor)
+{
+    if (!interceptor)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto changed = std::make_shared<Interceptors>(*interceptors);
+    changed->push_back(std::move(interceptor));
+    set(std::move(changed));
+}
+
+void TraceChain::remove(const std::shared_ptr<TraceInterceptor>& interceptor)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto changed = std::make_shared<Interceptors>(*interceptors);
+    changed->erase(std::remove(changed->begin(), changed->end(), interceptor), changed->end());
+    set(std::move(changed));
+}
+
+void TraceChain::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    set(std::make_shared<Interceptors>());
+}
+
+std::shared_ptr<const TraceChain::Interceptors> TraceChain::get() const
+{
+    return std::atomic_load(&interceptors);
+}
+
+void TraceChain::set(std::shared_ptr<const Interceptors> changed)
+{
+    const bool empty = changed->empty();
+    // Disable before the interceptors are removed and enable after they are added
+    if (empty)
+    {
+        enabled.store(false, std::memory_order_relaxed);
+    }
+    std::atomic_store(&interceptors, std::move(changed));
+    if (!empty)
+    {
+        enabled.store(true, std::memory_order_relaxed);
+    }
+}
+
+TraceChain Trace::global;
+
+void Trace::addInterceptor(std::shared_ptr<TraceInterceptor> interceptor)
+{
+    global.add(std::move(interceptor));
+}
+
+void Trace::removeInterceptor(const std::shared_ptr<TraceInterceptor>& interceptor)
+{
+    global.remove(interceptor);
+}
+
+void Trace::clearInterceptors()
+{
+    global.clear();
+}
+
+Trace::Span::Span(SpanKind kind, const std::string& method, const std::string& path, const TraceChain* chain)
+{
+    if (!Trace::isEnabled(chain))
+    {
+        return;
+    }
+    RequestOptions options = RequestOptions::current();
+    const std::uint64_t parentId = options.spanId;
+    options.spanId = NewId();
+    if (options.traceId == 0)
+    {
+        options.traceId = options.spanId;
+    }
+    active.reset(new Active(options));
+    TraceSpan& span = active->span;
+    span.traceId = options.traceId;
+    span.spanId = options.spanId;
+    span.parentId = parentId;
+    span.kind = kind;
+    span.method = method;
+    span.path = path;
+    span.start = std::chrono::steady_clock::now();
+    span.end = span.start;
+    active->interceptors = global.get();
+    if (chain != nullptr && chain->isEnabled())
+    {
+        auto combined = std::make_shared<TraceChain::Interceptors>(*active->interceptors);
+        const std::shared_ptr<const TraceChain::Interceptors> local = chain->get();
+        combined->insert(combined->end(), local->begin(), local->end());
+        active->interceptors = std::move(combined);
+    }
+    for (const std::shared_ptr<TraceInterceptor>& interceptor : *active->interceptors)
+    {
+        interceptor->onStart(span);
+    }
+}
+
+Trace::Span::~Span()
+{
+    if (!active)
+    {
+        return;
+    }
+    active->span.end = std::chrono::steady_clock::now();
+    const TraceChain::Interceptors& interceptors = *active->interceptors;
+    for (auto it = interceptors.rbegin(); it != interceptors.rend(); ++it)
+    {
+        (*it)->onEnd(active->span);
+    }
+}
+
+void Trace::Span::setRequestBytes(std::size_t bytes)
+{
+    if (active)
+    {
+        active->span.requestBytes = bytes;
+    }
+}
+
+void Trace::Span::setResponseBytes(std::size_t bytes)
+{
+    if (active)
+    {
+        active->span.responseBytes = bytes;
+    }
+}
+
+void Trace::Span::fail(const std::string& error)
+{
+    if (active)
+    {
+        active->span.failed = true;
+        active->span.error = error;
+    }
+}
+
+void Trace::Span::fail(std::exception_ptr error)
+{
+    if (!active || !error)
+    {
+        return;
+    }
+    try
+    {
+        std::rethrow_exception(error);
+    }
+    catch (const std::exception& e)
+    {
+        fail(std::string(e.what()));
+    }
+    catch (...)
+    {
+        fail(std::string("Unknown exception"));
+    }
+}
+
+void Trace::Span::detach()
+{
+    if (active)
+    {
+        active->scope.reset();
+    }
+}
@@ -27,31 +27,38 @@
 
 std::vector<std::pair<std::string, std::string>> UPnP::getDevices(std::shared_ptr<const IHttpHandler> handler)
 {
-    // send UPnP M-Search request
-    std::vector<std::string> foundDevices
-        = handler->sendMulticast("M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: "
-                                 "\"ssdp:discover\"\r\nMX: 5\r\nST: ssdp:all\r\n\r\n",
-            "239.255.255.250", 1900, 5);
-
     std::vector<std::pair<std::string, std::string>> devices;
+    getDevices(std::move(handler), [&](const std::pair<std::string, std::string>& device) {
+        devices.push_back(device);
+        return true;
+    });
+    return devices;
+}
 
-    // filter out devices
-    for (const std::string& s : foundDevices)
-    {
-        std::pair<std::string, std::string> device;
-        int start = s.find("LOCATION:") + 10;
-        device.first = s.substr(start, s.find("\r\n", start) - start);
-        start = s.find("SERVER:") + 8;
-        device.second = s.substr(start, s.find("\r\n", start) - start);
-        if (std::find_if(devices.begin(), devices.end(),
-                [&](const std::pair<std::string, std::string>& item) { return item.first == device.first; })
-            == devices.end())
-        {
-            devices.push_back(device);
+void UPnP::getDevices(std::shared_ptr<const IHttpHandler> handler,
+    const std::function<bool(const std::pair<std::string, std::string>&)>& onDevice)
+{
+    std::vector<std::string> foundAddresses;
+
+    // send UPnP M-Search request and filter out devices as they answer
+    handler->sendMulticast(
+        "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: "
+        "\"ssdp:discover\"\r\nMX: 5\r\nST: ssdp:all\r\n\r\n",
+        [&](const std::string& s) {
+            std::pair<std::string, std::string> device;
+            int start = s.find("LOCATION:") + 10;
+            device.first = s.substr(start, s.find("\r\n", start) - start);
+            start = s.find("SERVER:") + 8;
+            device.second = s.substr(start, s.find("\r\n", start) - start);
+            if (std::find(foundAddresses.begin(), foundAddresses.end(), device.first) != foundAddresses.end())
+            {
+                return true;
+            }
+            foundAddresses.push_back(device.first);
 
             // std::cout << "Device: \t" << device.first << std::endl;
             // std::cout << "        \t" << device.second << std::endl;
-        }
-    }
-    return devices;
+            return onDevice(device);
+        },
+        "239.255.255.250", 1900, 5);
 }
@@ -22,7 +22,7 @@
 
 #include "include/Utils.h"
 
-#include <iostream>
+#include "include/Log.h"
 
 namespace utils
 {
@@ -61,8 +61,8 @@ namespace utils
                             }
                             if (!success)
                             {
-                                std::cout << "Value " << requestIt.value() << " does not match reply "
-                                          << successIt.value() << std::endl;
+                                HUE_LOG(LogLevel::debug, "Value " << requestIt.value() << " does not match reply "
+                                        << successIt.value());
                             }
                         }
                     }
@@ -79,4 +79,48 @@ namespace utils
         }
         return success;
     }
+
+    std::vector<std::string> applyReplyToState(const nlohmann::json& reply, const std::string& path,
+        nlohmann::json& state, std::vector<std::string>* unapplied)
+    {
+        std::vector<std::string> changed;
+        if (!reply.is_array())
+        {
+            return changed;
+        }
+        for (const nlohmann::json& entry : reply)
+        {
+            const auto successIt = entry.find("success");
+            if (successIt == entry.end() || !successIt->is_object())
+            {
+                continue;
+            }
+            for (auto it = successIt->begin(); it != successIt->end(); ++it)
+            {
+                const std::string& successPath = it.key();
+                // Skip other resources
+                if (successPath.compare(0, path.size(), path) != 0 || successPath.size() <= path.size() + 1
+                    || successPath[path.size()] != '/')
+                {
+                    continue;
+                }
+                // Paths that are no valid json pointer cannot be applied
+                if (successPath.find('~', path.size()) == std::string::npos)
+                {
+                    const nlohmann::json::json_pointer member(successPath.substr(path.size()));
+                    if (state.contains(member))
+                    {
+                        state[member] = it.value();
+                        changed.push_back(member.to_string());
+                        continue;
+                    }
+                }
+                if (unapplied)
+                {
+                    unapplied->push_back(successPath.substr(path.size()));
+                }
+            }
+        }
+        return changed;
+    }
 } // namespace utils
\ No newline at end of file
@@ -22,8 +22,9 @@
 
 #include "include/WinHttpHandler.h"
 
+#include "include/Log.h"
+
 #include <chrono>
-#include <iostream>
 #include <memory>
 #include <system_error>
 
@@ -60,7 +61,7 @@ WinHttpHandler::WinHttpHandler()
     int return_code = WSAStartup(MAKEWORD(2, 2), &wsaData);
     if (return_code != 0)
     {
-        std::cerr << "WinHttpHandler: Failed to open socket: " << return_code << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: Failed to open socket: " << return_code);
         throw(std::system_error(return_code, std::system_category(), "WinHttpHandler: Failed to open socket"));
     }
 }
@@ -82,7 +83,7 @@ std::string WinHttpHandler::send(const std::string& msg, const std::string& adr,
     if (getaddrinfo(adr.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: getaddrinfo failed: " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: getaddrinfo failed: " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: getaddrinfo failed"));
     }
     SOCKET connect_socket = INVALID_SOCKET;
@@ -100,7 +101,7 @@ std::string WinHttpHandler::send(const std::string& msg, const std::string& adr,
         if (connect_socket == INVALID_SOCKET)
         {
             int err = WSAGetLastError();
-            std::cerr << "WinHttpHandler: Error at socket(): " << err << std::endl;
+            HUE_LOG(LogLevel::error, "WinHttpHandler: Error at socket(): " << err);
             throw(std::system_error(err, std::system_category(), "WinHttpHandler: Error at socket()"));
         }
 
@@ -120,7 +121,7 @@ std::string WinHttpHandler::send(const std::string& msg, const std::string& adr,
 
     if (connect_socket == INVALID_SOCKET)
     {
-        std::cerr << "WinHttpHandler: Unable to connect to server!" << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: Unable to connect to server!");
         throw std::system_error(connectError, std::system_category(), "WinHttpHandler: Unable to connect to server!");
     }
     SocketCloser closeSocket(connect_socket);
@@ -129,7 +130,7 @@ std::string WinHttpHandler::send(const std::string& msg, const std::string& adr,
     if (::send(connect_socket, msg.c_str(), msg.size(), 0) == SOCKET_ERROR)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: send failed: " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: send failed: " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: send failed"));
     }
 
@@ -138,7 +139,7 @@ std::string WinHttpHandler::send(const std::string& msg, const std::string& adr,
     if (shutdown(connect_socket, SD_SEND) == SOCKET_ERROR)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: shutdown failed: " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: shutdown failed: " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: shutdown failed"));
     }
 
@@ -163,7 +164,7 @@ std::string WinHttpHandler::send(const std::string& msg, const std::string& adr,
         else
         {
             int err = WSAGetLastError();
-            std::cerr << "WinHttpHandler: recv failed: " << err << std::endl;
+            HUE_LOG(LogLevel::error, "WinHttpHandler: recv failed: " << err);
             throw(std::system_error(err, std::system_category(), "WinHttpHandler: recv failed"));
         }
     } while (res > 0);
@@ -184,7 +185,7 @@ std::vector<std::string> WinHttpHandler::sendMulticast(
     if (getaddrinfo(adr.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: sendMulticast: getaddrinfo failed: " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: sendMulticast: getaddrinfo failed: " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: sendMulticast: getaddrinfo failed"));
     }
     AddrInfoFreer freeResult(result);
@@ -198,7 +199,7 @@ std::vector<std::string> WinHttpHandler::sendMulticast(
     if (connect_socket == INVALID_SOCKET)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: sendMulticast: Error at socket(): " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: sendMulticast: Error at socket(): " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: sendMulticast: Error at socket()"));
     }
     SocketCloser closeSocket(connect_socket);
@@ -213,7 +214,7 @@ std::vector<std::string> WinHttpHandler::sendMulticast(
     if (bind(connect_socket, (struct sockaddr FAR*)&source_sin, sizeof(source_sin)) == SOCKET_ERROR)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: sendMulticast: Binding socket failed: " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: sendMulticast: Binding socket failed: " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: sendMulticast: Binding socket failed"));
     }
 
@@ -228,7 +229,7 @@ std::vector<std::string> WinHttpHandler::sendMulticast(
     if (setsockopt(connect_socket, IPPROTO_IP, IP_MULTICAST_TTL, (char FAR*)&iOptVal, sizeof(int)) == SOCKET_ERROR)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: sendMulticast: setsockopt failed: " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: sendMulticast: setsockopt failed: " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: sendMulticast: setsockopt failed"));
     }
 
@@ -243,7 +244,7 @@ std::vector<std::string> WinHttpHandler::sendMulticast(
         == SOCKET_ERROR)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: sendMulticast: sendto failed: " << WSAGetLastError() << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: sendMulticast: sendto failed: " << WSAGetLastError());
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: sendMulticast: sendto failed"));
     }
 
@@ -252,7 +253,7 @@ std::vector<std::string> WinHttpHandler::sendMulticast(
     if (shutdown(connect_socket, SD_SEND) == SOCKET_ERROR)
     {
         int err = WSAGetLastError();
-        std::cerr << "WinHttpHandler: sendMulticast: shutdown failed: " << err << std::endl;
+        HUE_LOG(LogLevel::error, "WinHttpHandler: sendMulticast: shutdown failed: " << err);
         throw(std::system_error(err, std::system_category(), "WinHttpHandler: sendMulticast: shutdown failed"));
     }
 
@@ -0,0 +1,248 @@
+/**
+    \file BenchServer.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _BENCH_SERVER_H
+#define _BENCH_SERVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//! Local stand-in for a bridge that answers every request with the same body.
+//!
+//! Listens on an ephemeral loopback port and serves each connection on its own thread.
+//! Honors "Connection: close" and otherwise keeps connections alive.
+//! An injected round trip time delays each response relative to the arrival of its request without
+//! delaying the following requests, like a network link would, so pipelined requests overlap.
+class BenchServer
+{
+public:
+    //! \brief Starts the server
+    //! \param body Response body for every request
+    //! \param delay Simulated processing time/round trip before each response is written
+    //! \param rtt Simulated round trip time, each response is written this long after its request arrived
+    explicit BenchServer(std::string body, std::chrono::microseconds delay = std::chrono::microseconds(0),
+        std::chrono::microseconds rtt = std::chrono::microseconds(0))
+        : body(std::move(body)), delay(delay), rtt(rtt)
+    {
+        listenFD = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFD < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "BenchServer: socket");
+        }
+        int reuse = 1;
+        setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        if (bind(listenFD, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFD, 128) < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "BenchServer: bind/listen");
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(listenFD, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        acceptThread = std::thread([this] { acceptLoop(); });
+    }
+
+    ~BenchServer()
+    {
+        shutdown(listenFD, SHUT_RDWR);
+        acceptThread.join();
+        close(listenFD);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Connection& c : connections)
+        {
+            shutdown(c.fd, SHUT_RDWR);
+        }
+        for (Connection& c : connections)
+        {
+            c.worker.join();
+            close(c.fd);
+        }
+    }
+
+    int getPort() const { return port; }
+
+    //! \brief Number of accepted connections so far
+    std::size_t getConnectionCount() const { return acceptCount; }
+
+private:
+    void acceptLoop()
+    {
+        while (true)
+        {
+            int fd = accept(listenFD, nullptr, nullptr);
+            if (fd < 0)
+            {
+                return;
+            }
+            ++acceptCount;
+            std::lock_guard<std::mutex> lock(mutex);
+            // Reap connections that were closed
+            auto finished = std::partition(
+                connections.begin(), connections.end(), [](const Connection& c) { return !*c.done; });
+            for (auto it = finished; it != connections.end(); ++it)
+            {
+                it->worker.join();
+                close(it->fd);
+            }
+            connections.erase(finished, connections.end());
+            std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+            connections.push_back(Connection {fd, done, std::thread([this, fd, done] {
+                serve(fd);
+                *done = true;
+            })});
+        }
+    }
+
+    void serve(int fd)
+    {
+        // Responses are written by a separate thread, so requests keep arriving during the round trip time
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        std::deque<std::pair<std::chrono::steady_clock::time_point, bool>> queue;
+        bool readerDone = false;
+        std::thread writer([&] {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (true)
+            {
+                queueChanged.wait(lock, [&] { return readerDone || !queue.empty(); });
+                if (queue.empty())
+                {
+                    return;
+                }
+                const std::pair<std::chrono::steady_clock::time_point, bool> next = queue.front();
+                queue.pop_front();
+                lock.unlock();
+                std::this_thread::sleep_until(next.first + rtt);
+                const std::string response = makeResponse(next.second);
+                const bool failed = ::send(fd, response.data(), response.size(), MSG_NOSIGNAL) < 0;
+                lock.lock();
+                if (failed || next.second)
+                {
+                    shutdown(fd, SHUT_RDWR);
+                    return;
+                }
+            }
+        });
+
+        std::string buffer;
+        char chunk[4096];
+        while (true)
+        {
+            std::size_t headerEnd = buffer.find("\r\n\r\n");
+            if (headerEnd == std::string::npos)
+            {
+                ssize_t bytes = read(fd, chunk, sizeof(chunk));
+                if (bytes <= 0)
+                {
+                    break;
+                }
+                buffer.append(chunk, bytes);
+                continue;
+            }
+            std::size_t length = 0;
+            std::size_t lengthPos = buffer.find("Content-Length: ");
+            if (lengthPos != std::string::npos && lengthPos < headerEnd)
+            {
+                length = std::strtoul(buffer.c_str() + lengthPos + 16, nullptr, 10);
+            }
+            if (buffer.size() < headerEnd + 4 + length)
+            {
+                ssize_t bytes = read(fd, chunk, sizeof(chunk));
+                if (bytes <= 0)
+                {
+                    break;
+                }
+                buffer.append(chunk, bytes);
+                continue;
+            }
+            const bool closeAfter = buffer.find("Connection: close") < headerEnd;
+            buffer.erase(0, headerEnd + 4 + length);
+            if (delay.count() > 0)
+            {
+                std::this_thread::sleep_for(delay);
+            }
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.emplace_back(std::chrono::steady_clock::now(), closeAfter);
+            }
+            queueChanged.notify_one();
+            if (closeAfter)
+            {
+                break;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            readerDone = true;
+        }
+        queueChanged.notify_one();
+        writer.join();
+        shutdown(fd, SHUT_RDWR);
+    }
+
+    std::string makeResponse(bool closeAfter) const
+    {
+        std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: ";
+        response.append(std::to_string(body.size()));
+        response.append(closeAfter ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n");
+        response.append(body);
+        return response;
+    }
+
+private:
+    struct Connection
+    {
+        int fd;
+        std::shared_ptr<std::atomic<bool>> done;
+        std::thread worker;
+    };
+
+    std::string body;
+    std::chrono::microseconds delay;
+    std::chrono::microseconds rtt;
+    int listenFD;
+    int port;
+    std::thread acceptThread;
+    std::atomic<std::size_t> acceptCount {0};
+    std::mutex mutex;
+    std::vector<Connection> connections;
+};
+
+#endif
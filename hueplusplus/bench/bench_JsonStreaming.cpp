@@ -0,0 +1,173 @@
+/**
+    \file bench_JsonStreaming.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <malloc.h>
+
+#include "BenchServer.h"
+
+#include "../include/FilteringJsonSax.h"
+#include "../include/LinHttpHandler.h"
+
+// Allocations are only counted on the thread that enables counting,
+// so the threads of the stand-in bridge do not influence the result.
+namespace
+{
+    thread_local bool counting = false;
+    std::size_t allocationCount = 0;
+    long long liveBytes = 0;
+    long long peakBytes = 0;
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    if (counting)
+    {
+        ++allocationCount;
+        liveBytes += malloc_usable_size(p);
+        peakBytes = std::max(peakBytes, liveBytes);
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (counting && p)
+    {
+        liveBytes -= malloc_usable_size(p);
+    }
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+namespace
+{
+    // Full state of a bridge with the given number of lights, similar to GET /api/<username>
+    std::string FullState(int lights)
+    {
+        nlohmann::json state;
+        for (int i = 1; i <= lights; ++i)
+        {
+            state["lights"][std::to_string(i)] = {
+                {"state",
+                    {{"on", true}, {"bri", 254}, {"hue", 8418}, {"sat", 140}, {"effect", "none"},
+                        {"xy", {0.4573, 0.41}}, {"ct", 366}, {"alert", "select"}, {"colormode", "ct"},
+                        {"mode", "homeautomation"}, {"reachable", true}}},
+                {"swupdate", {{"state", "noupdates"}, {"lastinstall", "2020-01-01T00:00:00"}}},
+                {"type", "Extended color light"}, {"name", "Light " + std::to_string(i)}, {"modelid", "LCT015"},
+                {"manufacturername", "Signify Netherlands B.V."}, {"productname", "Hue color lamp"},
+                {"capabilities",
+                    {{"certified", true},
+                        {"control",
+                            {{"mindimlevel", 1000}, {"maxlumen", 806}, {"colorgamuttype", "C"},
+                                {"colorgamut", {{0.6915, 0.3083}, {0.17, 0.7}, {0.1532, 0.0475}}},
+                                {"ct", {{"min", 153}, {"max", 500}}}}},
+                        {"streaming", {{"renderer", true}, {"proxy", true}}}}},
+                {"config", {{"archetype", "sultanbulb"}, {"function", "mixed"}, {"direction", "omnidirectional"}}},
+                {"uniqueid", "00:17:88:01:00:00:00:" + std::to_string(10 + i % 90) + "-0b"},
+                {"swversion", "1.50.2_r30933"}};
+        }
+        state["config"] = {{"name", "Philips hue"}, {"zigbeechannel", 15}, {"apiversion", "1.35.0"}};
+        state["groups"] = nlohmann::json::object();
+        state["scenes"] = nlohmann::json::object();
+        return state.dump();
+    }
+
+    struct Result
+    {
+        double us;
+        double allocations;
+        double peakKiB;
+    };
+
+    template <typename F>
+    Result Measure(int requests, F get)
+    {
+        allocationCount = 0;
+        peakBytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requests; ++i)
+        {
+            liveBytes = 0;
+            counting = true;
+            get();
+            counting = false;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return Result {seconds * 1e6 / requests, double(allocationCount) / requests, peakBytes / 1024.};
+    }
+
+    void Print(const char* name, const Result& r)
+    {
+        std::printf("  %-24s %10.1f us   %10.1f allocations   %10.1f KiB peak heap\n", name, r.us, r.allocations,
+            r.peakKiB);
+    }
+
+    void Run(int lights, int requests)
+    {
+        const std::string body = FullState(lights);
+        BenchServer server(body);
+        const int port = server.getPort();
+        LinHttpHandler handler;
+        // Open pooled connection before measuring
+        handler.GETString("/api/user", "application/json", "", "127.0.0.1", port);
+
+        std::printf("%d lights, %zu byte full state, per request:\n", lights, body.size());
+        Print("string, then parse", Measure(requests, [&] {
+            nlohmann::json state
+                = nlohmann::json::parse(handler.GETString("/api/user", "application/json", "", "127.0.0.1", port));
+        }));
+        Print("streamed parse", Measure(requests, [&] {
+            nlohmann::json state = handler.GETJson("/api/user", nullptr, "127.0.0.1", port);
+        }));
+        Print("SAX lights/*/state", Measure(requests, [&] {
+            FilteringJsonSax sax({"lights/*/state"});
+            handler.GETJsonSax("/api/user", nullptr, sax, "127.0.0.1", port);
+        }));
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 50;
+
+    std::printf("LinHttpHandler: parsing the full state, %d GET requests against local stand-in bridge\n", requests);
+    Run(10, requests);
+    Run(50, requests);
+    Run(200, requests);
+    return 0;
+}
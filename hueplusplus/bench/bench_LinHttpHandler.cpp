@@ -0,0 +1,82 @@
+/**
+    \file bench_LinHttpHandler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BenchServer.h"
+
+#include "../include/LinHttpHandler.h"
+
+namespace
+{
+    struct Result
+    {
+        double requestsPerSecond;
+        double p50Us;
+        double p99Us;
+        std::size_t connections;
+    };
+
+    Result Run(bool keepAlive, int requests, const std::string& body)
+    {
+        BenchServer server(body);
+        LinHttpHandler handler;
+        handler.setKeepAlive(keepAlive);
+
+        std::vector<double> latencies;
+        latencies.reserve(requests);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requests; ++i)
+        {
+            const auto requestStart = std::chrono::steady_clock::now();
+            handler.PUTString("/api/user/lights/1/state", "application/json", "{\"bri\":100}", "127.0.0.1",
+                server.getPort());
+            latencies.push_back(
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - requestStart).count());
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::sort(latencies.begin(), latencies.end());
+        return Result {requests / seconds, latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+            server.getConnectionCount()};
+    }
+
+    void Print(const char* name, const Result& r)
+    {
+        std::printf("%-12s %12.0f req/s   p50 %8.1f us   p99 %8.1f us   %6zu connections\n", name,
+            r.requestsPerSecond, r.p50Us, r.p99Us, r.connections);
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 5000;
+    const std::string body = "[{\"success\":{\"/lights/1/state/bri\":100}}]";
+
+    std::printf("LinHttpHandler: %d sequential PUT requests against local stand-in bridge\n", requests);
+    Print("no pooling", Run(false, requests, body));
+    Print("keep-alive", Run(true, requests, body));
+    return 0;
+}
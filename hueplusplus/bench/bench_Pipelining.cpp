@@ -0,0 +1,103 @@
+/**
+    \file bench_Pipelining.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "BenchServer.h"
+
+#include "../include/LinAsyncHttpHandler.h"
+#include "../include/LinHttpHandler.h"
+
+namespace
+{
+    const std::string body = "[{\"success\":{\"/lights/1/state/bri\":100}}]";
+
+    struct Result
+    {
+        double seconds;
+        std::size_t connections;
+    };
+
+    // Sends the requests one after another, each waits for the previous response
+    Result RunSequential(int requests, std::chrono::microseconds rtt)
+    {
+        BenchServer server(body, std::chrono::microseconds(0), rtt);
+        LinHttpHandler handler;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requests; ++i)
+        {
+            handler.PUTJson("/api/user/lights/" + std::to_string(i % 20 + 1) + "/state", {{"bri", 100}}, "127.0.0.1",
+                server.getPort());
+        }
+        return Result {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+            server.getConnectionCount()};
+    }
+
+    // Submits all requests at once, as a bulk scene transition would
+    Result RunAsync(int requests, std::chrono::microseconds rtt, std::size_t connections, std::size_t depth)
+    {
+        BenchServer server(body, std::chrono::microseconds(0), rtt);
+        LinAsyncHttpHandler handler;
+        handler.setMaxConnections(connections);
+        handler.setPipelining(depth);
+        std::vector<std::future<nlohmann::json>> results;
+        results.reserve(requests);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requests; ++i)
+        {
+            results.push_back(handler.PUTJson("/api/user/lights/" + std::to_string(i % 20 + 1) + "/state",
+                {{"bri", 100}}, "127.0.0.1", server.getPort()));
+        }
+        for (std::future<nlohmann::json>& result : results)
+        {
+            result.get();
+        }
+        return Result {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+            server.getConnectionCount()};
+    }
+
+    void Print(const char* name, int requests, const Result& r)
+    {
+        std::printf("%-36s %9.1f ms total %9.0f req/s %4zu connections\n", name, r.seconds * 1000,
+            requests / r.seconds, r.connections);
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 200;
+    const std::chrono::microseconds rtt(argc > 2 ? std::atoi(argv[2]) : 5000);
+
+    std::printf("Pipelining: %d PUT requests, %.1f ms injected round trip time\n", requests, rtt.count() / 1000.0);
+    Print("LinHttpHandler sequential", requests, RunSequential(requests, rtt));
+    Print("async 1 connection", requests, RunAsync(requests, rtt, 1, 1));
+    Print("async 1 connection, pipelining 8", requests, RunAsync(requests, rtt, 1, 8));
+    Print("async 1 connection, pipelining 32", requests, RunAsync(requests, rtt, 1, 32));
+    Print("async 4 connections", requests, RunAsync(requests, rtt, 4, 1));
+    Print("async 4 connections, pipelining 8", requests, RunAsync(requests, rtt, 4, 8));
+    return 0;
+}
@@ -0,0 +1,238 @@
+/**
+    \file bench_ResponseReader.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <dlfcn.h>
+#include <poll.h>
+
+#include "BenchServer.h"
+
+#include "../include/LinHttpHandler.h"
+
+// Syscalls and allocations are only counted on the thread that enables counting,
+// so the threads of the stand-in bridge do not influence the result.
+namespace
+{
+    thread_local bool counting = false;
+    std::size_t syscallCount = 0;
+    std::size_t readCount = 0;
+    std::size_t allocationCount = 0;
+
+    template <typename F>
+    F Next(const char* name)
+    {
+        return reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+    }
+} // namespace
+
+extern "C" ssize_t read(int fd, void* buf, size_t count)
+{
+    static auto next = Next<ssize_t (*)(int, void*, size_t)>("read");
+    if (counting)
+    {
+        ++syscallCount;
+        ++readCount;
+    }
+    return next(fd, buf, count);
+}
+
+extern "C" ssize_t recv(int fd, void* buf, size_t len, int flags)
+{
+    static auto next = Next<ssize_t (*)(int, void*, size_t, int)>("recv");
+    if (counting)
+    {
+        ++syscallCount;
+        ++readCount;
+    }
+    return next(fd, buf, len, flags);
+}
+
+extern "C" ssize_t send(int fd, const void* buf, size_t len, int flags)
+{
+    static auto next = Next<ssize_t (*)(int, const void*, size_t, int)>("send");
+    if (counting)
+    {
+        ++syscallCount;
+    }
+    return next(fd, buf, len, flags);
+}
+
+extern "C" int poll(pollfd* fds, nfds_t nfds, int timeout)
+{
+    static auto next = Next<int (*)(pollfd*, nfds_t, int)>("poll");
+    if (counting)
+    {
+        ++syscallCount;
+    }
+    return next(fds, nfds, timeout);
+}
+
+extern "C" int connect(int fd, const sockaddr* addr, socklen_t len)
+{
+    static auto next = Next<int (*)(int, const sockaddr*, socklen_t)>("connect");
+    if (counting)
+    {
+        ++syscallCount;
+    }
+    return next(fd, addr, len);
+}
+
+extern "C" int socket(int domain, int type, int protocol)
+{
+    static auto next = Next<int (*)(int, int, int)>("socket");
+    if (counting)
+    {
+        ++syscallCount;
+    }
+    return next(domain, type, protocol);
+}
+
+extern "C" int close(int fd)
+{
+    static auto next = Next<int (*)(int)>("close");
+    if (counting)
+    {
+        ++syscallCount;
+    }
+    return next(fd);
+}
+
+void* operator new(std::size_t size)
+{
+    if (counting)
+    {
+        ++allocationCount;
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    struct Result
+    {
+        double syscalls;
+        double reads;
+        double allocations;
+        double us;
+    };
+
+    // Reference: the previous reader, which read 128 bytes at a time until the connection was closed
+    std::string NaiveGet(const std::string& request, int port)
+    {
+        int socketFD = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connect(socketFD, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+        send(socketFD, request.data(), request.size(), MSG_NOSIGNAL);
+        std::string response;
+        char buffer[128] = {};
+        ssize_t bytes;
+        while ((bytes = read(socketFD, buffer, 127)) > 0)
+        {
+            response.append(buffer, bytes);
+        }
+        close(socketFD);
+        return response;
+    }
+
+    template <typename F>
+    Result Measure(int requests, std::size_t expectedSize, F get)
+    {
+        syscallCount = readCount = allocationCount = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requests; ++i)
+        {
+            counting = true;
+            std::string response = get();
+            counting = false;
+            if (response.size() < expectedSize)
+            {
+                std::fprintf(stderr, "Incomplete response: %zu bytes\n", response.size());
+                std::exit(1);
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return Result {double(syscallCount) / requests, double(readCount) / requests,
+            double(allocationCount) / requests, seconds * 1e6 / requests};
+    }
+
+    void Print(const char* name, const Result& r)
+    {
+        std::printf("  %-22s %8.1f syscalls   %8.1f reads   %8.1f allocations   %10.1f us\n", name, r.syscalls,
+            r.reads, r.allocations, r.us);
+    }
+
+    void Run(std::size_t bodySize, int requests)
+    {
+        BenchServer server(std::string(bodySize, 'x'));
+        const int port = server.getPort();
+        const std::string request = "GET /api/user HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+
+        LinHttpHandler closing;
+        closing.setKeepAlive(false);
+        LinHttpHandler pooled;
+        // Open pooled connection before measuring
+        pooled.GETString("/api/user", "application/json", "", "127.0.0.1", port);
+
+        std::printf("%zu byte body, per response:\n", bodySize);
+        Print("128 byte reads", Measure(requests, bodySize, [&] { return NaiveGet(request, port); }));
+        Print("framed, close", Measure(requests, bodySize, [&] {
+            return closing.GETString("/api/user", "application/json", "", "127.0.0.1", port);
+        }));
+        Print("framed, keep-alive", Measure(requests, bodySize, [&] {
+            return pooled.GETString("/api/user", "application/json", "", "127.0.0.1", port);
+        }));
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 200;
+
+    std::printf("LinHttpHandler: response reader, %d GET requests against local stand-in bridge\n", requests);
+    Run(1024, requests);
+    Run(64 * 1024, requests);
+    Run(512 * 1024, requests);
+    return 0;
+}
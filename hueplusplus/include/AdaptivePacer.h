@@ -0,0 +1,102 @@
+/**
+    \file AdaptivePacer.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _ADAPTIVE_PACER_H
+#define _ADAPTIVE_PACER_H
+
+#include <chrono>
+#include <mutex>
+#include <random>
+
+#include "RateLimiter.h"
+
+//! Adapts the interval of a \ref RateLimiter to the load of the bridge, used by \ref HueCommandAPI
+//!
+//! The pacer measures the round trip time of all requests. While the bridge is healthy, the interval is
+//! shrunk by a fixed step for every response. When the bridge is stressed, indicated by connection resets,
+//! timeouts, internal errors or a smoothed latency above the target, the interval is multiplied by the
+//! back-off factor with some random jitter. The interval always stays within the configured bounds.
+class AdaptivePacer
+{
+public:
+    using Clock = RateLimiter::Clock;
+
+    //! \brief Parameters of the adaptive pacing
+    struct Settings
+    {
+        //! \brief Whether the interval is adapted, otherwise only the latency is measured
+        bool enabled = false;
+        //! \brief Shortest interval between requests
+        Clock::duration minDelay = std::chrono::milliseconds(50);
+        //! \brief Longest interval between requests
+        Clock::duration maxDelay = std::chrono::seconds(2);
+        //! \brief Amount by which the interval shrinks for every healthy response
+        Clock::duration step = std::chrono::milliseconds(2);
+        //! \brief Smoothed latency above which the bridge is considered stressed
+        Clock::duration latencyTarget = std::chrono::milliseconds(300);
+        //! \brief Factor by which the interval grows when the bridge is stressed, greater than 1
+        double backoffFactor = 2.0;
+        //! \brief Random fraction of the grown interval that is added, to spread out clients that back off together
+        double jitter = 0.2;
+    };
+
+public:
+    //! \brief Creates a disabled pacer for rateLimiter
+    //! \param rateLimiter Rate limiter whose interval is adapted, must outlive the pacer
+    explicit AdaptivePacer(RateLimiter& rateLimiter);
+
+    //! \brief Returns the current settings
+    Settings getSettings() const;
+    //! \brief Replaces the settings and moves the interval into the new bounds when enabled
+    void setSettings(const Settings& settings);
+
+    //! \brief Reports a response that did not indicate stress
+    //! \param latency Round trip time of the request
+    void onResponse(Clock::duration latency);
+    //! \brief Reports a failed request or a response that indicates stress
+    //!
+    //! Stress is only acted upon once per interval or smoothed latency, whichever is longer,
+    //! so a burst of failures of requests that were already in flight backs off once.
+    void onStress();
+
+    //! \brief Returns the current interval between requests
+    Clock::duration getDelay() const;
+    //! \brief Returns the current request rate in requests per second
+    double getRate() const;
+    //! \brief Returns the smoothed round trip time, zero before the first response
+    Clock::duration getLatency() const;
+
+private:
+    // Grows the interval, lock must be held
+    void backOff();
+
+private:
+    RateLimiter& rateLimiter;
+    mutable std::mutex mutex;
+    Settings settings;
+    Clock::duration smoothedLatency;
+    Clock::time_point lastBackoff;
+    std::minstd_rand random;
+};
+
+#endif
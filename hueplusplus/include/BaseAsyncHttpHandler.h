@@ -0,0 +1,115 @@
+/**
+    \file BaseAsyncHttpHandler.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _BASE_ASYNCHTTPHANDLER_H
+#define _BASE_ASYNCHTTPHANDLER_H
+
+#include <string>
+
+#include "IAsyncHttpHandler.h"
+#include "Trace.h"
+
+#include "json/json.hpp"
+
+//! Base class for classes that handle http requests asynchronously
+//!
+//! Implements all requests on top of \ref send, the requests with a method are traced as http spans
+class BaseAsyncHttpHandler : public IAsyncHttpHandler
+{
+public:
+    //! \brief Virtual dtor
+    virtual ~BaseAsyncHttpHandler() = default;
+
+    using IAsyncHttpHandler::send;
+    using IAsyncHttpHandler::sendHTTPRequest;
+    using IAsyncHttpHandler::GETJson;
+    using IAsyncHttpHandler::POSTJson;
+    using IAsyncHttpHandler::PUTJson;
+    using IAsyncHttpHandler::DELETEJson;
+
+    //! \brief Send a HTTP request with the given method to the specified host and pass the body of the response to a
+    //! callback.
+    //!
+    //! The request asks the host to keep the connection open.
+    //! \param method HTTP method type e.g. GET, HEAD, POST, PUT, DELETE, ...
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \param onBody Called with the body of the response of the host.
+    //! Fails with std::system_error when system or socket operations fail
+    //! and with HueException when the response contained no body.
+    void sendHTTPRequest(const std::string& method, const std::string& uri, const std::string& contentType,
+        const std::string& body, const std::string& adr, int port, ResponseCallback onBody) const override;
+
+    //! \brief Send a HTTP GET request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \param onResponse Called with the parsed body of the response of the host.
+    //! Fails with std::system_error when system or socket operations fail,
+    //! with HueException when the response contained no body
+    //! and with nlohmann::json::parse_error when the body could not be parsed.
+    void GETJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const override;
+
+    //! \brief Send a HTTP POST request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! See \ref GETJson for the parameters and errors.
+    void POSTJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const override;
+
+    //! \brief Send a HTTP PUT request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! See \ref GETJson for the parameters and errors.
+    void PUTJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const override;
+
+    //! \brief Send a HTTP DELETE request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! See \ref GETJson for the parameters and errors.
+    void DELETEJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const override;
+
+    //! \brief Returns the interceptors that receive the http spans of this handler
+    //!
+    //! They are called after the global interceptors of \ref Trace. The spans end on the thread that calls the
+    //! callback of the request.
+    TraceChain& getTraceChain() const { return traceChain; }
+
+private:
+    //! \brief Sends a request with a JSON body and parses the body of the response
+    void sendJsonRequest(const std::string& method, const std::string& uri, const nlohmann::json& body,
+        const std::string& adr, int port, JsonCallback onResponse) const;
+
+private:
+    mutable TraceChain traceChain;
+};
+
+#endif
@@ -1,175 +1,279 @@
-/**
-    \file BaseHttpHandler.h
-    Copyright Notice\n
-    Copyright (C) 2020  Jan Rogall		- developer\n
-    Copyright (C) 2020  Moritz Wirger	- developer\n
-
-    This file is part of hueplusplus.
-
-    hueplusplus is free software: you can redistribute it and/or modify
-    it under the terms of the GNU Lesser General Public License as published by
-    the Free Software Foundation, either version 3 of the License, or
-    (at your option) any later version.
-
-    hueplusplus is distributed in the hope that it will be useful,
-    but WITHOUT ANY WARRANTY; without even the implied warranty of
-    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-    GNU Lesser General Public License for more details.
-
-    You should have received a copy of the GNU Lesser General Public License
-    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
-**/
-
-#ifndef _BASE_HTTPHANDLER_H
-#define _BASE_HTTPHANDLER_H
-
-#include <iostream>
-#include <memory>
-#include <string>
-#include <vector>
-
-#include "IHttpHandler.h"
-
-#include "json/json.hpp"
-
-//! Base class for classes that handle http requests and multicast requests
-class BaseHttpHandler : public IHttpHandler
-{
-public:
-    //! \brief Virtual dtor
-    virtual ~BaseHttpHandler() = default;
-
-    //! \brief Send a message to a specified host and return the body of the response.
-    //!
-    //! \param msg The message that should sent to the specified address
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! \return The body of the response of the host as a string
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    std::string sendGetHTTPBody(const std::string& msg, const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP request with the given method to the specified host and return the body of the response.
-    //!
-    //! \param method HTTP method type e.g. GET, HEAD, POST, PUT, DELETE, ...
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! \return Body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    std::string sendHTTPRequest(const std::string& method, const std::string& uri, const std::string& contentType,
-        const std::string& body, const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP GET request to the specified host and return the body of the response.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! that specifies the port to which the request is sent to. Default is 80
-    //! \return Body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    std::string GETString(const std::string& uri, const std::string& contentType, const std::string& body,
-        const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP POST request to the specified host and return the body of the response.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! that specifies the port to which the request is sent to. Default is 80
-    //! \return Body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    std::string POSTString(const std::string& uri, const std::string& contentType, const std::string& body,
-        const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP PUT request to the specified host and return the body of the response.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! that specifies the port to which the request is sent to. Default is 80
-    //! \return Body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    std::string PUTString(const std::string& uri, const std::string& contentType, const std::string& body,
-        const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP DELETE request to the specified host and return the body of the response.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! that specifies the port to which the request is sent to. Default is 80
-    //! \return Body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    std::string DELETEString(const std::string& uri, const std::string& contentType, const std::string& body,
-        const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP GET request to the specified host and return the body of the response parsed as JSON.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! \return Parsed body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    //! \throws nlohmann::json::parse_error when the body could not be parsed
-    nlohmann::json GETJson(
-        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP POST request to the specified host and return the body of the response parsed as JSON.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! \return Parsed body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    //! \throws nlohmann::json::parse_error when the body could not be parsed
-    nlohmann::json POSTJson(
-        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP PUT request to the specified host and return the body of the response parsed as JSON.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! \return Parsed body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    //! \throws nlohmann::json::parse_error when the body could not be parsed
-    nlohmann::json PUTJson(
-        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
-
-    //! \brief Send a HTTP DELETE request to the specified host and return the body of the response parsed as JSON.
-    //!
-    //! \param uri Uniform Resource Identifier in the request
-    //! \param body Request body, may be empty
-    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
-    //! \param port Optional port the request is sent to, default is 80
-    //! \return Parsed body of the response of the host
-    //! \throws std::system_error when system or socket operations fail
-    //! \throws HueException when response contained no body
-    //! \throws nlohmann::json::parse_error when the body could not be parsed
-    nlohmann::json DELETEJson(
-        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
-};
-
-#endif
+/**
+    \file BaseHttpHandler.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _BASE_HTTPHANDLER_H
+#define _BASE_HTTPHANDLER_H
+
+#include <functional>
+#include <iostream>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HttpRequestWriter.h"
+#include "IHttpHandler.h"
+#include "Trace.h"
+
+#include "json/json.hpp"
+
+//! Base class for classes that handle http requests and multicast requests
+class BaseHttpHandler : public IHttpHandler
+{
+public:
+    //! \brief Virtual dtor
+    virtual ~BaseHttpHandler() = default;
+
+    //! \brief Send a message to a specified host and return the body of the response.
+    //!
+    //! \param msg The message that should sent to the specified address
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return The body of the response of the host as a string
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    std::string sendGetHTTPBody(const std::string& msg, const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a message to a specified host and pass the body of the response to a callback as a stream.
+    //!
+    //! The default implementation waits for the whole response of \ref send and streams the body from it,
+    //! subclasses should override it to stream the body while it is received.
+    //! \param msg The message that should sent to the specified address
+    //! \param onBody Called once with the body of the response, the stream is only valid during the call
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    void sendGetHTTPBody(const std::string& msg, const std::function<void(std::istream&)>& onBody,
+        const std::string& adr, int port = 80) const override;
+
+    using IHttpHandler::sendMulticast;
+
+    //! \brief Send a multicast request and pass each answer to a callback.
+    //!
+    //! The default implementation waits for all answers of \ref sendMulticast and then passes them to onAnswer,
+    //! subclasses should override it to deliver answers as they arrive.
+    //! \param msg The message that should sent to the specified multicast address
+    //! \param onAnswer Called with each received answer. Return false to stop waiting for more answers.
+    //! \param adr Optional ip or hostname in dotted decimal notation, default is "239.255.255.250"
+    //! \param port Optional port the request is sent to, default is 1900
+    //! \param timeout Optional time to wait for responses in seconds, default is 5
+    //! \throws std::system_error when system or socket operations fail
+    void sendMulticast(const std::string& msg, const std::function<bool(const std::string&)>& onAnswer,
+        const std::string& adr = "239.255.255.250", int port = 1900, int timeout = 5) const override;
+
+    //! \brief Send a HTTP request with the given method to the specified host and return the body of the response.
+    //!
+    //! \param method HTTP method type e.g. GET, HEAD, POST, PUT, DELETE, ...
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return Body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    std::string sendHTTPRequest(const std::string& method, const std::string& uri, const std::string& contentType,
+        const std::string& body, const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP GET request to the specified host and return the body of the response.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! that specifies the port to which the request is sent to. Default is 80
+    //! \return Body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    std::string GETString(const std::string& uri, const std::string& contentType, const std::string& body,
+        const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP POST request to the specified host and return the body of the response.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! that specifies the port to which the request is sent to. Default is 80
+    //! \return Body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    std::string POSTString(const std::string& uri, const std::string& contentType, const std::string& body,
+        const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP PUT request to the specified host and return the body of the response.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! that specifies the port to which the request is sent to. Default is 80
+    //! \return Body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    std::string PUTString(const std::string& uri, const std::string& contentType, const std::string& body,
+        const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP DELETE request to the specified host and return the body of the response.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! that specifies the port to which the request is sent to. Default is 80
+    //! \return Body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    std::string DELETEString(const std::string& uri, const std::string& contentType, const std::string& body,
+        const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP GET request to the specified host and return the body of the response parsed as JSON.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return Parsed body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    //! \throws nlohmann::json::parse_error when the body could not be parsed
+    nlohmann::json GETJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP GET request to the specified host and parse the body of the response with a SAX handler.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param handler Receives the SAX events of the body, see nlohmann::json::sax_parse
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return false when the handler stopped parsing, otherwise true
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    //! \throws nlohmann::json::parse_error when the body could not be parsed and the handler throws on errors
+    bool GETJsonSax(const std::string& uri, const nlohmann::json& body, nlohmann::json::json_sax_t& handler,
+        const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP POST request to the specified host and return the body of the response parsed as JSON.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return Parsed body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    //! \throws nlohmann::json::parse_error when the body could not be parsed
+    nlohmann::json POSTJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP PUT request to the specified host and return the body of the response parsed as JSON.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return Parsed body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    //! \throws nlohmann::json::parse_error when the body could not be parsed
+    nlohmann::json PUTJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
+
+    //! \brief Send a HTTP DELETE request to the specified host and return the body of the response parsed as JSON.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return Parsed body of the response of the host
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    //! \throws nlohmann::json::parse_error when the body could not be parsed
+    nlohmann::json DELETEJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const override;
+
+    //! \brief Creates a HTTP request as it is sent by \ref sendHTTPRequest
+    //!
+    //! \param method HTTP method type e.g. GET, HEAD, POST, PUT, DELETE, ...
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname of the host, used for the Host header
+    //! \param port Port of the host, used for the Host header
+    //! \param keepAlive Whether a HTTP/1.1 keep-alive request is created instead of a HTTP/1.0 request
+    //! \return Request line, headers and body
+    static std::string buildRequest(const std::string& method, const std::string& uri, const std::string& contentType,
+        const std::string& body, const std::string& adr, int port, bool keepAlive);
+
+    //! \brief Returns the interceptors that receive the http spans of this handler
+    //!
+    //! They are called after the global interceptors of \ref Trace. Copies of the handler get a copy of the chain.
+    TraceChain& getTraceChain() const { return traceChain; }
+
+protected:
+    //! \brief Whether requests should ask the host to keep the connection open.
+    //!
+    //! Only return true if \ref send can frame responses without waiting for the connection to close.
+    //! \returns false by default, so every request is sent as HTTP/1.0 request, which has no chunked response
+    virtual bool useKeepAlive() const { return false; }
+
+    //! \brief Sends a request and returns the whole response.
+    //!
+    //! Used by \ref sendHTTPRequest. The default implementation passes the concatenated request to \ref send,
+    //! subclasses should override it to send the pieces of the request without concatenating them.
+    //! \param request Request to send
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \return The response of the host
+    //! \throws std::system_error when system or socket operations fail
+    virtual std::string sendRequest(const HttpRequestWriter& request, const std::string& adr, int port) const;
+
+    //! \brief Sends a request and passes the body of the response to a callback as a stream.
+    //!
+    //! Used by the JSON requests. The default implementation passes the concatenated request to
+    //! \ref sendGetHTTPBody, subclasses should override it to send the pieces of the request without concatenating
+    //! them.
+    //! \param request Request to send
+    //! \param onBody Called once with the body of the response, the stream is only valid during the call
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    virtual void sendRequest(const HttpRequestWriter& request, const std::function<void(std::istream&)>& onBody,
+        const std::string& adr, int port) const;
+
+private:
+    //! \brief Sends a request with a JSON body and parses the body of the response while it is received
+    nlohmann::json sendJsonRequest(const std::string& method, const std::string& uri, const nlohmann::json& body,
+        const std::string& adr, int port) const;
+
+private:
+    mutable TraceChain traceChain;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**
+    \file FilteringJsonSax.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _FILTERING_JSON_SAX_H
+#define _FILTERING_JSON_SAX_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "json/json.hpp"
+
+//! SAX handler that only keeps the values at selected paths of a JSON document
+//!
+//! A path is a list of object keys separated by '/', where "*" matches any key. For example "lights/*/state"
+//! keeps only the state of every light from the full state of the bridge. Everything else is skipped
+//! without being stored. Arrays are only kept as a whole, paths cannot select values inside of them.
+//! Pass it to \ref IHttpHandler::GETJsonSax or \ref HueCommandAPI::GETRequest to parse a response.
+class FilteringJsonSax : public nlohmann::json::json_sax_t
+{
+public:
+    //! \brief Creates handler for the given paths
+    //! \param paths Paths of the values that are kept, an empty path keeps the whole document
+    explicit FilteringJsonSax(const std::vector<std::string>& paths);
+
+    //! \brief Dtor
+    ~FilteringJsonSax();
+
+    //! \brief Selected values at their original paths
+    //!
+    //! For example {"lights":{"1":{"state":{...}},"2":{"state":{...}}}}.
+    //! Null when nothing was selected.
+    const nlohmann::json& getResult() const { return result; }
+
+    //! \brief Moves the result out of the handler, see \ref getResult
+    nlohmann::json takeResult() { return std::move(result); }
+
+    bool null() override;
+    bool boolean(bool val) override;
+    bool number_integer(number_integer_t val) override;
+    bool number_unsigned(number_unsigned_t val) override;
+    bool number_float(number_float_t val, const string_t& s) override;
+    bool string(string_t& val) override;
+    bool start_object(std::size_t elements) override;
+    bool key(string_t& val) override;
+    bool end_object() override;
+    bool start_array(std::size_t elements) override;
+    bool end_array() override;
+    //! \throws nlohmann::json::parse_error with the error of the parser
+    bool parse_error(
+        std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& ex) override;
+
+private:
+    using Path = std::vector<std::string>;
+
+    enum class Match
+    {
+        none, //!< Path does not lead to a selected value
+        prefix, //!< Path leads to a selected value
+        full //!< Path is selected
+    };
+
+    //! \brief Matches the current path against all paths
+    Match match() const;
+
+    //! \brief Decides what to do with the value that starts at the current path
+    //! \param container Whether the value is an object or array
+    //! \param object Whether the value is an object
+    //! \returns Whether the value is captured
+    bool beginValue(bool container, bool object);
+
+    //! \brief Stores the captured value at the current path
+    void endCapture();
+
+    //! \brief Handles a value that is not a container
+    //! \param forward Passes the value to \ref capture
+    template <typename F>
+    bool scalar(F forward);
+
+private:
+    std::vector<Path> paths;
+    Path path; //!< Keys of the objects that contain the current value
+    std::size_t skipDepth; //!< Nesting depth of the skipped container, 0 when not skipping
+    std::size_t captureDepth; //!< Nesting depth of the captured container, 0 when not capturing
+    nlohmann::json captured;
+    std::unique_ptr<nlohmann::detail::json_sax_dom_parser<nlohmann::json>> capture;
+    nlohmann::json result;
+};
+
+#endif
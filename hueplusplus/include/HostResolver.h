@@ -0,0 +1,90 @@
+/**
+    \file HostResolver.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _HOST_RESOLVER_H
+#define _HOST_RESOLVER_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+
+//! Thread safe host name resolution with a cache, used by \ref LinHttpHandler
+//!
+//! Numeric IPv4 and IPv6 addresses are converted directly without any lookup.
+//! Host names are resolved with getaddrinfo and kept for a limited time.
+class HostResolver
+{
+public:
+    //! \brief Resolved socket address
+    struct Address
+    {
+        sockaddr_storage address; //!< IPv4 or IPv6 socket address, including the port
+        socklen_t length; //!< Used length of \ref address
+
+        //! \brief Address family, AF_INET or AF_INET6
+        int family() const { return address.ss_family; }
+    };
+
+public:
+    //! \brief Creates resolver
+    //! \param ttl Time that resolved host names are cached
+    explicit HostResolver(std::chrono::steady_clock::duration ttl = std::chrono::minutes(5));
+
+    //! \brief Resolves host and port to socket addresses
+    //!
+    //! \param host Host name or numeric IPv4/IPv6 address like "192.168.2.1" or "fe80::1"
+    //! \param port Port that is set in all addresses
+    //! \return All addresses of the host in the order they should be tried, never empty
+    //! \throws std::system_error when the host could not be resolved
+    std::vector<Address> resolve(const std::string& host, int port);
+
+    //! \brief Sets the time that resolved host names are cached
+    void setTTL(std::chrono::steady_clock::duration ttl);
+
+    //! \brief Removes all cached host names
+    void clear();
+
+    //! \brief Converts a numeric address without any lookup
+    //!
+    //! \param host Numeric IPv4 address like "192.168.2.1" or IPv6 address like "fe80::1" or "[fe80::1]"
+    //! \param port Port that is set in the address
+    //! \param result Address that is set on success
+    //! \return false when host is not a numeric address
+    static bool parseNumeric(const std::string& host, int port, Address& result);
+
+private:
+    struct CacheEntry
+    {
+        std::vector<Address> addresses;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::chrono::steady_clock::duration ttl;
+    std::mutex mutex;
+    std::unordered_map<std::string, CacheEntry> cache;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+    \file HttpRequestWriter.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _HTTP_REQUEST_WRITER_H
+#define _HTTP_REQUEST_WRITER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+//! HTTP request that is kept in pieces instead of being concatenated
+//!
+//! The constant parts of the headers are static strings, the port and content length are formatted
+//! into a small buffer inside the writer and everything else refers to the strings passed to the constructor.
+//! The pieces can be sent with a single scatter-gather call and sent again on another connection.
+//! \note The strings passed to the constructor must outlive the writer.
+class HttpRequestWriter
+{
+public:
+    //! \brief Piece of the request
+    struct Buffer
+    {
+        const char* data;
+        std::size_t size;
+    };
+
+    //! \brief Maximum number of pieces of a request
+    static constexpr std::size_t maxBuffers = 12;
+
+public:
+    //! \brief Creates request
+    //!
+    //! \param method HTTP method type e.g. GET, HEAD, POST, PUT, DELETE, ...
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname of the host, used for the Host header
+    //! \param port Port of the host, used for the Host header
+    //! \param keepAlive Whether the request is sent as HTTP/1.1 keep-alive request with a Host header,
+    //! otherwise it is sent as HTTP/1.0 request that closes the connection
+    HttpRequestWriter(const std::string& method, const std::string& uri, const std::string& contentType,
+        const std::string& body, const std::string& adr, int port, bool keepAlive);
+
+    //! \brief Not copyable, the pieces point into the writer
+    HttpRequestWriter(const HttpRequestWriter&) = delete;
+    //! \brief Not copyable, the pieces point into the writer
+    HttpRequestWriter& operator=(const HttpRequestWriter&) = delete;
+
+    //! \brief Pieces of the request in the order they are sent, none of them is empty
+    const Buffer* getBuffers() const { return buffers; }
+    //! \brief Number of pieces returned by \ref getBuffers
+    std::size_t getBufferCount() const { return count; }
+    //! \brief Total size of the request in bytes
+    std::size_t getSize() const { return size; }
+    //! \brief Whether the request is a HEAD request, which has no response body
+    bool isHeadRequest() const { return headRequest; }
+
+    //! \brief Concatenates all pieces
+    std::string str() const;
+
+private:
+    //! \brief Adds a piece when it is not empty
+    void add(const char* data, std::size_t length);
+    //! \brief Adds the Content-Type and Content-Length headers, the end of the headers and the body
+    void AddContent(const std::string& contentType, const std::string& body);
+
+private:
+    Buffer buffers[maxBuffers];
+    std::size_t count;
+    std::size_t size;
+    bool headRequest;
+    //! \brief "]:port" followed by the content length
+    char numbers[48];
+};
+
+//! \brief Writes all pieces of the request to the stream
+std::ostream& operator<<(std::ostream& stream, const HttpRequestWriter& request);
+
+#endif
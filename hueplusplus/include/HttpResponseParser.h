@@ -0,0 +1,122 @@
+/**
+    \file HttpResponseParser.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _HTTP_RESPONSE_PARSER_H
+#define _HTTP_RESPONSE_PARSER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+//! Incremental parser that finds the end of a HTTP/1.x response
+//!
+//! Received data is passed to \ref feed in arbitrary pieces. The parser determines the end of the
+//! response from Content-Length or chunked transfer encoding, so a persistent connection does not
+//! need to be closed. Headers are only scanned once and the body is reserved up front when its size is known.
+class HttpResponseParser
+{
+public:
+    //! \brief Creates parser for the response to a request
+    //! \param headRequest Whether the request was a HEAD request, which has no response body
+    explicit HttpResponseParser(bool headRequest = false);
+
+    //! \brief Resets the parser for the next response, the body callback is kept
+    //! \param headRequest Whether the request was a HEAD request, which has no response body
+    void reset(bool headRequest = false);
+
+    //! \brief Passes the body to a callback instead of appending it to the response
+    //!
+    //! The data passed to onBody points into the data given to \ref feed, the transfer encoding is already removed.
+    //! \param onBody Called with each piece of the body, or nullptr to append the body to the response
+    void setBodyCallback(std::function<void(const char*, std::size_t)> onBody);
+
+    //! \brief Parses received data
+    //!
+    //! \param data Received bytes
+    //! \param size Number of received bytes
+    //! \return Number of bytes that belong to this response.
+    //! When less than size, the response is complete and the rest belongs to the next response.
+    std::size_t feed(const char* data, std::size_t size);
+
+    //! \brief Signals that the connection was closed by the peer
+    //!
+    //! Completes responses that are terminated by closing the connection.
+    //! \return Whether anything was received at all
+    bool finish();
+
+    //! \brief Whether the complete response was received
+    bool isComplete() const { return state == State::done; }
+
+    //! \brief Whether the connection can be reused after the complete response
+    bool isKeepAlive() const { return keepAlive; }
+
+    //! \brief Status code of the response, 0 when the headers were not received yet
+    int getStatus() const { return status; }
+
+    //! \brief Offset of the body in \ref getResponse, or std::string::npos when the headers were not received yet
+    std::size_t getBodyStart() const { return bodyStart; }
+
+    //! \brief Response headers followed by the body, transfer encoding is already removed
+    //!
+    //! Only contains the headers when a body callback is set.
+    const std::string& getResponse() const { return response; }
+
+    //! \brief Moves the response out of the parser, see \ref getResponse
+    std::string takeResponse() { return std::move(response); }
+
+private:
+    enum class State
+    {
+        headers, //!< Waiting for end of headers
+        body, //!< Body with known length
+        untilClose, //!< Body ends when connection is closed
+        chunkSize, //!< Waiting for chunk size line
+        chunkData, //!< Reading chunk data
+        chunkEnd, //!< Waiting for CRLF after chunk data
+        trailers, //!< Reading trailers after last chunk
+        done
+    };
+
+    //! \brief Parses status line and headers and determines the framing of the body
+    void parseHeaders();
+
+    //! \brief Finds CRLF in the line buffer, appending data until found
+    //! \return Number of bytes consumed from data
+    std::size_t readLine(const char* data, std::size_t size, bool& complete);
+
+    //! \brief Appends a piece of the body to the response or passes it to the body callback
+    void appendBody(const char* data, std::size_t size);
+
+private:
+    State state;
+    bool headRequest;
+    bool keepAlive;
+    int status;
+    std::size_t bodyStart;
+    std::size_t remaining; //!< Remaining bytes of body or current chunk
+    std::size_t scanned; //!< Bytes of the headers that were already searched for the end
+    std::string line; //!< Partial line for chunk sizes and trailers
+    std::string response;
+    std::function<void(const char*, std::size_t)> onBody;
+};
+
+#endif
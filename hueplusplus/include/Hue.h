@@ -23,8 +23,12 @@
 #ifndef _HUE_H
 #define _HUE_H
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -35,6 +39,7 @@
 #include "HueCommandAPI.h"
 #include "HueLight.h"
 #include "IHttpHandler.h"
+#include "StatePoller.h"
 
 #include "json/json.hpp"
 
@@ -68,6 +73,16 @@ public:
     //! \throws HueException when response contained no body
     std::vector<HueIdentification> FindBridges() const;
 
+    //! \brief Finds bridges in the network and passes each one to a callback as soon as it is identified.
+    //!
+    //! Discovery continues in the background while onBridge runs, so work on the first bridge can start
+    //! before all bridges answered.
+    //! \param onBridge Called with ip and mac of every found bridge.
+    //! Return false to stop searching, for example after the expected number of bridges was found.
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    void FindBridges(const std::function<bool(const HueIdentification&)>& onBridge) const;
+
     //! \brief Gets a \ref Hue bridge based on its identification
     //!
     //! \param identification \ref HueIdentification that specifies a bridge
@@ -123,6 +138,15 @@ public:
     Hue(const std::string& ip, const int port, const std::string& username,
         std::shared_ptr<const IHttpHandler> handler);
 
+    //! \brief Copy constructor, the copy gets its own copies of the lights
+    Hue(const Hue& other);
+
+    //! \brief Copy assignment, the lights are replaced with copies of the lights of \p other
+    Hue& operator=(const Hue& other);
+
+    //! \brief Destructor, stops applying polled states to this bridge
+    ~Hue();
+
     //! \brief Function to get the ip address of the hue bridge
     //!
     //! \return string containing ip
@@ -164,6 +188,7 @@ public:
 
     //! \brief Function that returns a \ref HueLight of specified id
     //!
+    //! The reference stays valid until the light is removed with \ref removeLight or by \ref refreshAllLights.
     //! \param id Integer that specifies the ID of a Hue light
     //! \return \ref HueLight that can be controlled
     //! \throws std::system_error when system or socket operations fail
@@ -174,7 +199,8 @@ public:
 
     //! \brief Function to remove a light from the bridge
     //!
-    //! \attention Any use of the light after it was successfully removed results in undefined behavior
+    //! \attention Any use of a reference to the light after it was successfully removed results in undefined
+    //! behavior. Lights returned by \ref findLight stay usable.
     //! \param id Id of the light to remove
     //! \return true on success
     //! \throws std::system_error when system or socket operations fail
@@ -191,13 +217,58 @@ public:
     //! \brief Function that returns all lights that are associated with this
     //! bridge
     //!
-    //! \return A vector containing references to every HueLight
+    //! \return A vector containing references to every HueLight, see \ref getLight for how long they are valid
     //! \throws std::system_error when system or socket operations fail
     //! \throws HueException when response contains no body
     //! \throws HueAPIResponseException when response contains an error
     //! \throws nlohmann::json::parse_error when response could not be parsed
     std::vector<std::reference_wrapper<HueLight>> getAllLights();
 
+    //! \brief Function that refreshes the state of all lights with a single request
+    //!
+    //! All lights are updated from the state of the bridge, lights that are new are added and lights that no longer
+    //! exist are removed. References to removed lights become invalid.
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contains no body or the type of a new light is unknown
+    //! \throws HueAPIResponseException when response contains an error
+    //! \throws nlohmann::json::parse_error when response could not be parsed
+    void refreshAllLights();
+
+    //! \brief Function that sets how old the cached state of lights may be before it is refreshed
+    //!
+    //! Applies to all lights of this bridge, including the ones that already exist.
+    //! Use \ref HueLight::setStateMaxAge afterwards to change it for single lights.
+    //! \param maxAge Maximum age of the cached state, std::chrono::milliseconds::max() to never refresh implicitly
+    void setStateMaxAge(std::chrono::milliseconds maxAge);
+
+    //! \brief Const function that returns how old the cached state of new lights may be
+    //!
+    //! \return Maximum age set by \ref setStateMaxAge, 0 by default
+    std::chrono::milliseconds getStateMaxAge() const;
+
+    //! \brief Function that starts polling the state of all lights in the background
+    //!
+    //! The state of all lights is requested every \p interval with a single request. Lights use newer polled
+    //! states, so with a state max age above the interval (see \ref setStateMaxAge) they send no requests of their
+    //! own. Subscribe to the returned poller to be notified of changes.
+    //! When polling is already running, only the interval is changed.
+    //! \note Each polled state is published to \ref getStateSnapshot and to the snapshots of the lights before
+    //! subscribers are notified, so subscribers and const getters see the changes.
+    //! \note Polling keeps the HttpHandler that was set when it started.
+    //! \param interval Time between two requests
+    //! \return The \ref StatePoller, valid until \ref stopPolling is called
+    StatePoller& startPolling(std::chrono::milliseconds interval);
+
+    //! \brief Function that stops polling started with \ref startPolling
+    //!
+    //! Lights keep their last state.
+    void stopPolling();
+
+    //! \brief Function that returns the poller started with \ref startPolling
+    //!
+    //! \return The \ref StatePoller or nullptr when not polling
+    StatePoller* getPoller() const;
+
     //! \brief Function that tells whether a given light id represents an existing light
     //!
     //! Calls refreshState to update the local bridge state
@@ -218,6 +289,24 @@ public:
     //! when not
     bool lightExists(int id) const;
 
+    //! \brief Const function that returns a light that was already created
+    //!
+    //! Reads the published lights without sending a request, so it can be used on any thread while another thread
+    //! uses the bridge. Only the const functions of the light may be used on other threads.
+    //! \param id Id of the light
+    //! \return The light or nullptr when it was not created by \ref getLight, \ref getAllLights or
+    //! \ref refreshAllLights. The light stays usable after it was removed from the bridge.
+    std::shared_ptr<const HueLight> findLight(int id) const;
+
+    //! \brief Const function that returns the last published state of the bridge
+    //!
+    //! Snapshots are never changed. Each refresh of the bridge state publishes a new one, so a snapshot can be read
+    //! on any thread while another thread uses the bridge. The const functions of this class read from it.
+    //! While polling, each poll publishes a snapshot with the polled "lights" section.
+    //! \note The states of lights are published separately, see \ref HueLight::getStateSnapshot
+    //! \return State of the bridge as it was returned from it, null before the first refresh or poll
+    std::shared_ptr<const nlohmann::json> getStateSnapshot() const;
+
     //! \brief Const function that returns the picture name of a given light id
     //!
     //! \note This will not update the local state of the bridge.
@@ -247,21 +336,64 @@ public:
         commands = HueCommandAPI(ip, port, username, http_handler);
     }
 
+    //! \brief Function that returns the HueCommandAPI used for bridge communication
+    //!
+    //! It can be used to send requests that are not covered by this class, for example from other threads.
+    //! \return \ref HueCommandAPI that is shared by all lights of this bridge
+    const HueCommandAPI& getCommandAPI() const { return commands; }
+
 private:
-    //! \brief Function that refreshes the local \ref state of the Hue bridge
+    //! \brief Maps ids to lights
+    using LightMap = std::map<uint8_t, std::shared_ptr<HueLight>>;
+
+    //! \brief Function that refreshes the local state of the Hue bridge
     //! \throws std::system_error when system or socket operations fail
     //! \throws HueException when response contained no body
     //! \throws HueAPIResponseException when response contains an error
     //! \throws nlohmann::json::parse_error when response could not be parsed
     void refreshState();
 
+    //! \brief Creates a HueLight from its state without sending a request
+    //! \param id Id of the light
+    //! \param lightState Entry of the light in the "lights" section of the bridge state
+    //! \return The new light, which is not added to the lights of the bridge
+    //! \throws HueException when the type of the light is unknown
+    std::shared_ptr<HueLight> CreateLight(int id, const nlohmann::json& lightState);
+
+    //! \brief Returns a map with copies of the lights in \p source
+    static LightMap CopyLights(const LightMap& source);
+
+    //! \brief Publishes a new map of lights for \ref findLight
+    void PublishLights(LightMap next);
+
+    //! \brief Lets \ref poller apply every polled state to this bridge
+    void AddUpdateHandler();
+
+    //! \brief Updates all lights from the "lights" section of the state, adds new ones and removes missing ones
+    //! \throws HueException when the type of a new light is unknown
+    void UpdateLights();
+
 private:
     std::string ip; //!< IP-Address of the hue bridge in dotted decimal notation
                     //!< like "192.168.2.1"
     std::string username; //!< Username that is ussed to access the hue bridge
     int port;
-    nlohmann::json state; //!< The state of the hue bridge as it is returned from it
-    std::map<uint8_t, HueLight> lights; //!< Maps ids to HueLights that are controlled by this bridge
+    //! \brief Snapshots of the bridge that are never changed, but replaced with std::atomic_store
+    //!
+    //! Shared with the update handler of the poller, which replaces them on the poll thread.
+    struct Published
+    {
+        std::mutex mutex; //!< Held while \ref state is replaced, so no update is lost
+        std::shared_ptr<const nlohmann::json> state
+            = std::make_shared<const nlohmann::json>(); //!< The state of the hue bridge as it is returned from it
+        std::shared_ptr<const LightMap> lights
+            = std::make_shared<const LightMap>(); //!< HueLights that are controlled by this bridge, only replaced by
+                                                  //!< the thread that uses the bridge
+    };
+    const std::shared_ptr<Published> published = std::make_shared<Published>(); //!< State and lights of the bridge
+    std::chrono::milliseconds stateMaxAge{0}; //!< Maximum age of the state of lights before they are refreshed
+    std::shared_ptr<StatePoller> poller; //!< Poller started by \ref startPolling, may be nullptr
+    std::uint64_t updateHandler = 0; //!< Id of the update handler of this bridge in \ref poller
 
     std::shared_ptr<BrightnessStrategy> simpleBrightnessStrategy; //!< Strategy that is used for controlling the
                                                                   //!< brightness of lights
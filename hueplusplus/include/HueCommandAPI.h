@@ -23,17 +23,31 @@
 #ifndef _HUECOMMANDAPI_H
 #define _HUECOMMANDAPI_H
 
-#include <atomic>
 #include <chrono>
-#include <mutex>
+#include <cstddef>
+#include <memory>
 
 #include "HueException.h"
+#include "IAsyncHttpHandler.h"
 #include "IHttpHandler.h"
+#include "RequestMetrics.h"
+#include "RequestScheduler.h"
+#include "RetryPolicy.h"
+#include "Trace.h"
 
 //! Handles communication to the bridge via IHttpHandler and enforces a timeout
 //! between each request
 class HueCommandAPI
 {
+public:
+    //! \brief Classes of requests that are paced with independent rate budgets
+    enum class RequestType
+    {
+        lights, //!< PUT and DELETE requests to /lights, 10 per second by default
+        groups, //!< PUT and DELETE requests to /groups, 1 per second by default
+        other //!< All GET requests and writes to other paths, 10 per second by default
+    };
+
 public:
     //! \brief Construct from ip, username and HttpHandler
     //!
@@ -44,6 +58,17 @@ public:
     HueCommandAPI(
         const std::string& ip, int port, const std::string& username, std::shared_ptr<const IHttpHandler> httpHandler);
 
+    //! \brief Construct from ip, username and asynchronous HttpHandler
+    //!
+    //! Requests are sent with the asynchronous handler through a \ref SyncHttpHandler,
+    //! so all copies share its connections.
+    //! \param ip ip address of the Hue bridge in dotted decimal notation like "192.168.2.1"
+    //! \param port of the hue bridge
+    //! \param username username that is used to control the bridge
+    //! \param asyncHandler Asynchronous HttpHandler for communication with the bridge
+    HueCommandAPI(const std::string& ip, int port, const std::string& username,
+        std::shared_ptr<const IAsyncHttpHandler> asyncHandler);
+
     //! \brief Copy construct from other HueCommandAPI
     //! \note All copies refer to the same timeout data, so even calls from different objects will be delayed
     HueCommandAPI(const HueCommandAPI&) = default;
@@ -58,9 +83,93 @@ public:
     //! \note All copies refer to the same timeout data, so even calls from different objects will be delayed
     HueCommandAPI& operator=(HueCommandAPI&&) = default;
 
+    //! \brief Sets the time allowed for each request
+    //!
+    //! The time covers waiting for \ref minDelay, connecting, sending, receiving and retries.
+    //! It is passed to the handler with \ref RequestOptions, so the handler fails requests that take longer
+    //! with std::system_error with std::errc::timed_out. An earlier deadline of the calling thread's
+    //! \ref RequestOptions takes precedence.
+    //! \param timeout Time allowed for each request, zero to use the timeout of the handler (default)
+    //! \note Copies made before the call keep their timeout.
+    void setTimeout(std::chrono::steady_clock::duration timeout);
+
+    //! \brief Sets how many requests of each type can be sent at once after a pause. Default is 1
+    //!
+    //! On average, requests are still sent the delay of their type apart. With a burst of n, up to n requests
+    //! can be started without waiting when no requests of the type were sent for n times the delay.
+    //! \param burst Number of requests that can be started at once, values below 1 are treated as 1
+    //! \note Applies to all copies, because they share the timeout data.
+    void setBurst(std::size_t burst);
+    //! \brief Sets how many requests of one type can be sent at once after a pause
+    //! \see setBurst(std::size_t)
+    void setBurst(RequestType type, std::size_t burst);
+
+    //! \brief Sets the average time between requests of one type
+    //!
+    //! Each type has its own budget, so for example reads do not delay light commands.
+    //! Defaults are \ref minDelay for lights and other requests and \ref groupMinDelay for groups.
+    //! \note Applies to all copies, because they share the timeout data.
+    void setMinDelay(RequestType type, std::chrono::steady_clock::duration delay);
+    //! \brief Returns the average time between requests of one type
+    std::chrono::steady_clock::duration getMinDelay(RequestType type) const;
+
+    //! \brief Adapts the time between requests of one type to the load of the bridge
+    //!
+    //! The delay shrinks while responses are fast and grows when the bridge resets connections,
+    //! times out, answers with internal errors (901) or responds slower than the latency target.
+    //! The current delay is returned by \ref getMinDelay. Disabled by default.
+    //! \param type Request type whose delay is adapted
+    //! \param settings Bounds and parameters of the adaptation, see \ref AdaptivePacer
+    //! \note Applies to all copies, because they share the timeout data.
+    void setAdaptivePacing(RequestType type, const AdaptivePacer::Settings& settings);
+    //! \brief Returns the current rate of requests of one type in requests per second
+    double getRequestRate(RequestType type) const;
+    //! \brief Returns the smoothed round trip time of requests of one type, zero before the first response
+    std::chrono::steady_clock::duration getLatency(RequestType type) const;
+
+    //! \brief Sets the policy that decides whether and when failed requests are sent again
+    //!
+    //! GET and DELETE requests and light state changes without increments or alerts are idempotent,
+    //! other PUT requests are retried when \ref RetryPolicy::Settings::retryPUT is set.
+    //! \param policy Policy used for all requests, nullptr for the default \ref RetryPolicy
+    //! \note Applies to all copies, because they share the timeout data.
+    void setRetryPolicy(std::shared_ptr<const RetryPolicy> policy);
+    //! \brief Returns the policy that decides whether and when failed requests are sent again
+    std::shared_ptr<const RetryPolicy> getRetryPolicy() const;
+
+    //! \brief Returns latencies and outcomes of the requests by method and path
+    //!
+    //! The metrics are recorded without locking and shared by all copies. Use \ref RequestMetrics::snapshot
+    //! and \ref RequestMetrics::toPrometheus to export them.
+    const RequestMetrics& getMetrics() const;
+
+    //! \brief Returns the interceptors that receive the spans of this and all copies
+    //!
+    //! The api spans of the requests are reported to them after the global interceptors of \ref Trace.
+    //! The http spans are reported to the chain of the http handler, see \ref BaseHttpHandler::getTraceChain.
+    TraceChain& getTraceChain() const;
+
+    //! \brief Sets how long waiting requests take to be raised by one priority level. Default is 5 seconds
+    //!
+    //! Requests wait for their turn in the order of the \ref RequestOptions::Priority of the calling thread.
+    //! Waiting requests age, so background requests wait at most about two aging delays longer than
+    //! interactive ones.
+    //! \note Applies to all copies, because they share the timeout data.
+    void setAgingDelay(std::chrono::steady_clock::duration delay);
+
     //! \brief Sends a HTTP PUT request to the bridge and returns the response
     //!
-    //! This function will block until at least \ref minDelay has passed to any previous request
+    //! This function will block until the rate budget of the request type allows it and
+    //! waiting requests with a higher priority were sent.
+    //!
+    //! State changes of a light ("/lights/<id>/state") that wait for their turn are merged with later ones
+    //! of the same priority, the later value of each attribute wins. The latest transitiontime that was set is
+    //! used, or the default when no merged change has one. Changes with "alert" or incremental attributes like
+    //! "bri_inc" are never merged.
+    //! The response then only contains the results for the attributes of request, which report the value
+    //! that was actually set.
+    //! When the merged request fails, all merged callers get the exception.
+    //! A merged caller waits for the response not longer than its own timeout.
     //! \param path API request path (appended after /api/{username})
     //! \param request Request to the api, may be empty
     //! \returns The return value of the underlying \ref IHttpHandler::PUTJson call
@@ -72,7 +181,12 @@ public:
 
     //! \brief Sends a HTTP GET request to the bridge and returns the response
     //!
-    //! This function will block until at least \ref minDelay has passed to any previous request
+    //! This function will block until the rate budget of the request type allows it and
+    //! waiting requests with a higher priority were sent.
+    //!
+    //! When an identical request of the same priority is already waiting or in flight, no new request is sent.
+    //! The caller waits for the response of that request instead, but not longer than its own timeout.
+    //! When the shared request fails, all callers get the exception.
     //! \param path API request path (appended after /api/{username})
     //! \param request Request to the api, may be empty
     //! \returns The return value of the underlying \ref IHttpHandler::GETJson call
@@ -82,9 +196,28 @@ public:
     nlohmann::json GETRequest(const std::string& path, const nlohmann::json& request) const;
     nlohmann::json GETRequest(const std::string& path, const nlohmann::json& request, FileInfo fileInfo) const;
 
+    //! \brief Sends a HTTP GET request to the bridge and parses the response with a SAX handler
+    //!
+    //! This function will block until the rate budget of the request type allows it and
+    //! waiting requests with a higher priority were sent.
+    //! The response is parsed while it is received, so only the values the handler keeps are stored.
+    //! When the connection is lost after the handler received events, the request is not repeated.
+    //! Unlike other GET requests, identical requests are not shared, because each handler needs the events.
+    //! \param path API request path (appended after /api/{username})
+    //! \param request Request to the api, may be empty
+    //! \param handler Receives the SAX events of the response, for example a \ref FilteringJsonSax
+    //! \returns The return value of the underlying \ref IHttpHandler::GETJsonSax call
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contains no body
+    //! \throws HueAPIResponseException when response contains an error
+    bool GETRequest(const std::string& path, const nlohmann::json& request, nlohmann::json::json_sax_t& handler) const;
+    bool GETRequest(const std::string& path, const nlohmann::json& request, nlohmann::json::json_sax_t& handler,
+        FileInfo fileInfo) const;
+
     //! \brief Sends a HTTP DELETE request to the bridge and returns the response
     //!
-    //! This function will block until at least \ref minDelay has passed to any previous request
+    //! This function will block until the rate budget of the request type allows it and
+    //! waiting requests with a higher priority were sent
     //! \param path API request path (appended after /api/{username})
     //! \param request Request to the api, may be empty
     //! \returns The return value of the underlying \ref IHttpHandler::DELETEJson call
@@ -95,12 +228,36 @@ public:
     nlohmann::json DELETERequest(const std::string& path, const nlohmann::json& request, FileInfo fileInfo) const;
 
 private:
-    struct TimeoutData
+    //! \brief Rate budgets and waiting requests of all request types and the retry policy, shared by all copies
+    struct Schedulers
     {
-        std::chrono::steady_clock::time_point timeout;
-        std::mutex mutex;
+        RequestScheduler lights {minDelay};
+        RequestScheduler groups {groupMinDelay};
+        RequestScheduler other {minDelay};
+        std::shared_ptr<const RetryPolicy> retryPolicy = std::make_shared<RetryPolicy>();
     };
 
+    //! \brief Light state changes that were not sent yet, shared by all copies
+    struct PendingWrites;
+    //! \brief GET requests that are waiting or in flight, shared by all copies
+    struct PendingReads;
+
+    //! \brief Sends request merged with other pending changes of the same light state
+    //! \returns The response to the merged request, filtered to the attributes of request
+    nlohmann::json CoalescedPUTRequest(const std::string& path, const nlohmann::json& request) const;
+
+    //! \brief Sends request or waits for the response of an identical request that is already pending
+    //! \returns The response, which may be shared with other callers
+    nlohmann::json SharedGETRequest(const std::string& path, const nlohmann::json& request) const;
+
+    //! \brief Returns the type of a request to path
+    //! \param write Whether the request changes the bridge state (PUT or DELETE)
+    //! \param path API request path (appended after /api/{username})
+    static RequestType GetRequestType(bool write, const std::string& path);
+
+    //! \brief Returns the scheduler of a request type
+    RequestScheduler& GetScheduler(RequestType type) const;
+
     //! \brief Throws an exception if response contains an error, passes though value
     //! \throws HueAPIResponseException when response contains an error
     //! \returns \ref response if there is no error
@@ -111,13 +268,21 @@ private:
     std::string CombinedPath(const std::string& path) const;
 
 public:
+    //! \brief Default time between requests to lights and other paths
     static constexpr std::chrono::steady_clock::duration minDelay = std::chrono::milliseconds(100);
+    //! \brief Default time between requests to groups
+    static constexpr std::chrono::steady_clock::duration groupMinDelay = std::chrono::seconds(1);
 private:
     std::string ip;
     int port;
     std::string username;
     std::shared_ptr<const IHttpHandler> httpHandler;
-    std::shared_ptr<TimeoutData> timeout;
+    std::shared_ptr<Schedulers> schedulers;
+    std::shared_ptr<PendingWrites> pendingWrites;
+    std::shared_ptr<PendingReads> pendingReads;
+    std::shared_ptr<RequestMetrics> metrics;
+    std::shared_ptr<TraceChain> traceChain;
+    std::chrono::steady_clock::duration requestTimeout;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+/**
+    \file HueFleet.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _HUEFLEET_H
+#define _HUEFLEET_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Hue.h"
+#include "RequestOptions.h"
+
+#include "json/json.hpp"
+
+//! Dispatches commands to many bridges with a shared pool of worker threads
+//!
+//! Every bridge has its own queue and its own \ref HueCommandAPI rate budget. Each queue is served by at most
+//! one worker at a time, so the \ref Hue of a bridge is never used concurrently, while different bridges
+//! proceed in parallel. Workers take the queues in turns, so a slow bridge does not hold up the others.
+//! \code
+//! HueFleet fleet;
+//! fleet.addBridge("floor1", finder.GetBridge(floor1));
+//! fleet.addBridge("floor2", finder.GetBridge(floor2));
+//! for (std::future<nlohmann::json>& result : fleet.setLightStates({{"floor1", 1}, {"floor2", 3}}, {{"on", false}}))
+//! {
+//!     result.get();
+//! }
+//! \endcode
+class HueFleet
+{
+public:
+    //! \brief Identifies a light of one bridge in the fleet
+    struct LightId
+    {
+        std::string bridge; //!< Name of the bridge given to \ref addBridge
+        int id; //!< Id of the light on the bridge
+    };
+
+public:
+    //! \brief Constructs a fleet without bridges
+    //! \param threads Number of worker threads shared by all bridges, values below 1 are treated as 1
+    explicit HueFleet(std::size_t threads = 16);
+
+    //! \brief Stops the workers
+    //!
+    //! Running tasks are completed, the futures of tasks that did not start yet get std::future_error
+    //! with std::future_errc::broken_promise.
+    ~HueFleet();
+
+    HueFleet(const HueFleet&) = delete;
+    HueFleet& operator=(const HueFleet&) = delete;
+
+    //! \brief Adds a bridge to the fleet
+    //! \param name Name that is used to address the bridge, replaces a previous bridge with the same name
+    //! once its queued tasks are done
+    //! \param bridge Bridge that is only used by the workers from now on
+    //! \returns The bridge, which must not be used while tasks for it are queued
+    Hue& addBridge(const std::string& name, Hue bridge);
+
+    //! \brief Returns the bridge with a name
+    //!
+    //! The bridge must not be used while tasks for it are queued.
+    //! \throws HueException when there is no bridge with the name
+    Hue& getBridge(const std::string& name);
+
+    //! \brief Returns the names of all bridges
+    std::vector<std::string> getBridgeNames() const;
+
+    //! \brief Runs a task with a bridge on a worker thread
+    //!
+    //! Tasks of one bridge run one after another in the order they were submitted.
+    //! The \ref RequestOptions of the calling thread apply to the requests of the task.
+    //! \param bridge Name of the bridge
+    //! \param task Function that is called with the \ref Hue of the bridge
+    //! \returns Future for the result or exception of task
+    //! \throws HueException when there is no bridge with the name
+    template <typename Task>
+    std::future<typename std::result_of<Task(Hue&)>::type> submit(const std::string& bridge, Task task)
+    {
+        using Result = typename std::result_of<Task(Hue&)>::type;
+        auto packaged = std::make_shared<std::packaged_task<Result(Hue&)>>(std::move(task));
+        std::future<Result> result = packaged->get_future();
+        Enqueue(bridge, [packaged](Hue& hue) { (*packaged)(hue); });
+        return result;
+    }
+
+    //! \brief Sends a state change to many lights of all bridges in parallel
+    //!
+    //! Sends a PUT request to "/lights/<id>/state" of every light. The requests of different bridges run in
+    //! parallel, so the changes take about as long as the ones of the bridge with the most lights.
+    //! \param lights Lights to change
+    //! \param state Light state attributes like {"on": true, "bri": 254}
+    //! \returns Futures for the responses of the lights in the order of lights.
+    //! They throw the exceptions of \ref HueCommandAPI::PUTRequest.
+    //! \throws HueException when a light refers to a bridge that is not in the fleet, nothing is sent then
+    std::vector<std::future<nlohmann::json>> setLightStates(
+        const std::vector<LightId>& lights, const nlohmann::json& state);
+
+private:
+    //! \brief A bridge with the tasks that wait for it
+    struct Bridge
+    {
+        explicit Bridge(Hue hue) : hue(std::move(hue)) {}
+
+        Hue hue;
+        std::deque<std::function<void()>> tasks;
+        bool running = false; //!< Whether a worker runs a task of the bridge
+    };
+
+    //! \brief Adds a task to the queue of a bridge
+    //! \throws HueException when there is no bridge with the name
+    void Enqueue(const std::string& bridge, std::function<void(Hue&)> task);
+
+    //! \brief Runs tasks of ready bridges until the fleet is destroyed
+    void Work();
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::map<std::string, std::shared_ptr<Bridge>> bridges;
+    std::deque<std::shared_ptr<Bridge>> ready; //!< Bridges with tasks that no worker runs, in turn order
+    bool stopped = false;
+    std::vector<std::thread> workers;
+};
+
+#endif
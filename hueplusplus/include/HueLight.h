@@ -23,6 +23,7 @@
 #ifndef _HUE_LIGHT_H
 #define _HUE_LIGHT_H
 
+#include <chrono>
 #include <memory>
 
 #include "BrightnessStrategy.h"
@@ -32,6 +33,9 @@
 
 #include "json/json.hpp"
 
+// forward declarations
+class StatePoller;
+
 /*enum ModelType
 {
 UNDEFINED,	// undefined model
@@ -104,6 +108,14 @@ public:
     //! \brief std dtor
     ~HueLight() = default;
 
+    //! \brief Copy constructor
+    //!
+    //! The copy publishes its own snapshot of the state, see \ref getStateSnapshot.
+    HueLight(const HueLight& other);
+
+    //! \brief Copy assignment operator, publishes a snapshot of the copied state
+    HueLight& operator=(const HueLight& other);
+
     //! \brief Function that turns the light on.
     //!
     //! \param transition Optional parameter to set the transition from current state to new, standard is 4 = 400ms
@@ -672,6 +684,31 @@ public:
         return false;
     };
 
+    //! \brief Const function that returns the last published state of the light
+    //!
+    //! Snapshots are never changed. Whenever the state of the light changes, a new snapshot is published,
+    //! so a snapshot can be read on any thread while another thread uses or refreshes the light.
+    //! All const getters read from the current snapshot.
+    //! \return State of the light like an entry in the "lights" section of the bridge state
+    std::shared_ptr<const nlohmann::json> getStateSnapshot() const;
+
+    //! \brief Function that sets how old the cached state may be before it is refreshed
+    //!
+    //! Functions that read or change the light, like \ref setBrightness or \ref getName, only request the state
+    //! from the bridge when it is at least \p maxAge old. The default of 0 refreshes on every call.
+    //! Pass std::chrono::milliseconds::max() to never refresh implicitly, for example when the state is kept
+    //! up to date with \ref Hue::refreshAllLights.
+    //! \note Values that the bridge confirms when changing the light are written to the cached state, which then
+    //! counts as received with the reply. When a change fails, the state is refreshed on the next call regardless
+    //! of \p maxAge.
+    //! \param maxAge Maximum age of the cached state
+    void setStateMaxAge(std::chrono::milliseconds maxAge);
+
+    //! \brief Const function that returns how old the cached state may be before it is refreshed
+    //!
+    //! \return Maximum age set by \ref setStateMaxAge or \ref Hue::setStateMaxAge
+    std::chrono::milliseconds getStateMaxAge() const;
+
 protected:
     //! \brief Protected ctor that is used by \ref Hue class.
     //!
@@ -697,6 +734,19 @@ protected:
         std::shared_ptr<const ColorTemperatureStrategy> colorTempStrategy,
         std::shared_ptr<const ColorHueStrategy> colorHueStrategy);
 
+    //! \brief Protected ctor that is used by \ref Hue class, sets strategies and
+    //! the state without sending a request.
+    //!
+    //! \param id Integer that specifies the id of this light
+    //! \param commands HueCommandAPI for communication with the bridge
+    //! \param brightnessStrategy Strategy for brightness. May be nullptr.
+    //! \param colorTempStrategy Strategy for color temperature. May be nullptr.
+    //! \param colorHueStrategy Strategy for color hue/saturation. May be nullptr.
+    //! \param state State of the light like an entry in the "lights" section of the bridge state
+    HueLight(int id, const HueCommandAPI& commands, std::shared_ptr<const BrightnessStrategy> brightnessStrategy,
+        std::shared_ptr<const ColorTemperatureStrategy> colorTempStrategy,
+        std::shared_ptr<const ColorHueStrategy> colorHueStrategy, const nlohmann::json& state);
+
     //! \brief Protected function that sets the brightness strategy.
     //!
     //! The strategy defines how specific commands that deal with brightness
@@ -765,7 +815,13 @@ protected:
     //! \throws nlohmann::json::parse_error when response could not be parsed
     virtual nlohmann::json SendPutRequest(const nlohmann::json& request, const std::string& subPath, FileInfo fileInfo);
 
+    //! \brief Protected function that publishes a copy of \ref state as the new snapshot
+    void PublishState();
+
     //! \brief Virtual function that refreshes the \ref state of the light.
+    //!
+    //! Uses the state of \ref poller when it is newer. Does nothing when the state is younger than \ref stateMaxAge
+    //! and not marked as outdated by \ref stateOutdated.
     //! \throws std::system_error when system or socket operations fail
     //! \throws HueException when response contained no body
     //! \throws HueAPIResponseException when response contains an error
@@ -774,7 +830,16 @@ protected:
 
 protected:
     int id; //!< holds the id of the light
-    nlohmann::json state; //!< holds the current state of the light updated by \ref refreshState
+    nlohmann::json state; //!< holds the current state of the light updated by \ref refreshState, only used by the
+                          //!< thread that uses the non-const functions
+    std::chrono::steady_clock::time_point lastStateUpdate; //!< time \ref state was received
+    bool stateOutdated = false; //!< whether \ref state may differ from the bridge regardless of its age, because a
+                                //!< change was sent without a reply or was confirmed without its new value
+    std::chrono::milliseconds stateMaxAge{0}; //!< maximum age of \ref state before \ref refreshState requests it
+    std::shared_ptr<const StatePoller> poller; //!< newer states of the poller replace \ref state, may be nullptr
+    std::shared_ptr<const nlohmann::json> snapshot
+        = std::make_shared<const nlohmann::json>(); //!< last published copy of \ref state, only accessed with
+                                                    //!< std::atomic_load and std::atomic_store
     ColorType colorType; //!< holds the \ref ColorType of the light
 
     std::shared_ptr<const BrightnessStrategy>
@@ -0,0 +1,191 @@
+/**
+    \file IAsyncHttpHandler.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _IASYNCHTTPHANDLER_H
+#define _IASYNCHTTPHANDLER_H
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "json/json.hpp"
+
+//! Abstract class for classes that handle http requests asynchronously
+//!
+//! Requests return immediately and the result is passed to a completion callback. Each callback is called
+//! exactly once, either with the result or with the exception that made the request fail.
+//! Implementations may call it on another thread or before the request function returns,
+//! so callbacks must not block. The overloads without callback return a std::future instead.
+class IAsyncHttpHandler
+{
+public:
+    //! \brief Called with the response, or with an empty string and the exception when the request failed
+    using ResponseCallback = std::function<void(std::string response, std::exception_ptr error)>;
+    //! \brief Called with the parsed response, or with null and the exception when the request failed
+    using JsonCallback = std::function<void(nlohmann::json response, std::exception_ptr error)>;
+
+    //! \brief Virtual dtor
+    virtual ~IAsyncHttpHandler() = default;
+
+    //! \brief Send a message to a specified host and pass the response to a callback.
+    //!
+    //! \param msg The message that should be sent to the specified address
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \param onResponse Called with the whole response of the host.
+    //! Fails with std::system_error when system or socket operations fail.
+    virtual void send(const std::string& msg, const std::string& adr, int port, ResponseCallback onResponse) const = 0;
+
+    //! \brief Send a HTTP request with the given method to the specified host and pass the body of the response to a
+    //! callback.
+    //!
+    //! \param method HTTP method type e.g. GET, HEAD, POST, PUT, DELETE, ...
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param contentType MIME type of the body data e.g. "text/html", "application/json", ...
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \param onBody Called with the body of the response of the host.
+    //! Fails with std::system_error when system or socket operations fail
+    //! and with HueException when the response contained no body.
+    virtual void sendHTTPRequest(const std::string& method, const std::string& uri, const std::string& contentType,
+        const std::string& body, const std::string& adr, int port, ResponseCallback onBody) const = 0;
+
+    //! \brief Send a HTTP GET request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \param onResponse Called with the parsed body of the response of the host.
+    //! Fails with std::system_error when system or socket operations fail,
+    //! with HueException when the response contained no body
+    //! and with nlohmann::json::parse_error when the body could not be parsed.
+    virtual void GETJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const = 0;
+
+    //! \brief Send a HTTP POST request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! See \ref GETJson for the parameters and errors.
+    virtual void POSTJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const = 0;
+
+    //! \brief Send a HTTP PUT request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! See \ref GETJson for the parameters and errors.
+    virtual void PUTJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const = 0;
+
+    //! \brief Send a HTTP DELETE request to the specified host and pass the body of the response parsed as JSON to a
+    //! callback.
+    //!
+    //! See \ref GETJson for the parameters and errors.
+    virtual void DELETEJson(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port,
+        JsonCallback onResponse) const = 0;
+
+    //! \brief Send a message to a specified host.
+    //!
+    //! \param msg The message that should be sent to the specified address
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return Future of the whole response of the host
+    std::future<std::string> send(const std::string& msg, const std::string& adr, int port = 80) const
+    {
+        return toFuture<std::string>([&](ResponseCallback callback) { send(msg, adr, port, std::move(callback)); });
+    }
+
+    //! \brief Send a HTTP request with the given method to the specified host.
+    //!
+    //! See \ref sendHTTPRequest(const std::string&, const std::string&, const std::string&, const std::string&,
+    //! const std::string&, int, ResponseCallback) const for the parameters.
+    //! \return Future of the body of the response of the host
+    std::future<std::string> sendHTTPRequest(const std::string& method, const std::string& uri,
+        const std::string& contentType, const std::string& body, const std::string& adr, int port = 80) const
+    {
+        return toFuture<std::string>([&](ResponseCallback callback) {
+            sendHTTPRequest(method, uri, contentType, body, adr, port, std::move(callback));
+        });
+    }
+
+    //! \brief Send a HTTP GET request to the specified host.
+    //! \return Future of the parsed body of the response of the host
+    std::future<nlohmann::json> GETJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const
+    {
+        return toFuture<nlohmann::json>(
+            [&](JsonCallback callback) { GETJson(uri, body, adr, port, std::move(callback)); });
+    }
+
+    //! \brief Send a HTTP POST request to the specified host.
+    //! \return Future of the parsed body of the response of the host
+    std::future<nlohmann::json> POSTJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const
+    {
+        return toFuture<nlohmann::json>(
+            [&](JsonCallback callback) { POSTJson(uri, body, adr, port, std::move(callback)); });
+    }
+
+    //! \brief Send a HTTP PUT request to the specified host.
+    //! \return Future of the parsed body of the response of the host
+    std::future<nlohmann::json> PUTJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const
+    {
+        return toFuture<nlohmann::json>(
+            [&](JsonCallback callback) { PUTJson(uri, body, adr, port, std::move(callback)); });
+    }
+
+    //! \brief Send a HTTP DELETE request to the specified host.
+    //! \return Future of the parsed body of the response of the host
+    std::future<nlohmann::json> DELETEJson(
+        const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const
+    {
+        return toFuture<nlohmann::json>(
+            [&](JsonCallback callback) { DELETEJson(uri, body, adr, port, std::move(callback)); });
+    }
+
+private:
+    //! \brief Passes a callback that fulfills a promise to start and returns the future of the promise
+    template <typename T, typename F>
+    static std::future<T> toFuture(F start)
+    {
+        std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+        std::future<T> result = promise->get_future();
+        start([promise](T value, std::exception_ptr error) {
+            if (error)
+            {
+                promise->set_exception(error);
+            }
+            else
+            {
+                promise->set_value(std::move(value));
+            }
+        });
+        return result;
+    }
+};
+
+#endif
@@ -23,7 +23,9 @@
 #ifndef _IHTTPHANDLER_H
 #define _IHTTPHANDLER_H
 
+#include <functional>
 #include <iostream>
+#include <istream>
 #include <memory>
 #include <string>
 #include <vector>
@@ -56,6 +58,19 @@ public:
     //! \throws HueException when response contained no body
     virtual std::string sendGetHTTPBody(const std::string& msg, const std::string& adr, int port = 80) const = 0;
 
+    //! \brief Send a message to a specified host and pass the body of the response to a callback as a stream.
+    //!
+    //! The stream reads the body while it is received, so it can be parsed without storing all of it.
+    //! \param msg The message that should sent to the specified address
+    //! \param onBody Called once with the body of the response, the stream is only valid during the call.
+    //! It does not need to read the whole body.
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    virtual void sendGetHTTPBody(const std::string& msg, const std::function<void(std::istream&)>& onBody,
+        const std::string& adr, int port = 80) const = 0;
+
     //! \brief Send a multicast request with a specified message.
     //!
     //! \param msg The message that should sent to the specified multicast address
@@ -70,6 +85,20 @@ public:
     virtual std::vector<std::string> sendMulticast(
         const std::string& msg, const std::string& adr = "239.255.255.250", int port = 1900, int timeout = 5) const = 0;
 
+    //! \brief Send a multicast request and pass each answer to a callback as soon as it is received.
+    //!
+    //! \param msg The message that should sent to the specified multicast address
+    //! \param onAnswer Called with each received answer. Return false to stop waiting for more answers.
+    //! \param adr Optional ip or hostname in dotted decimal notation, default is "239.255.255.250"
+    //! \param port Optional port the request is sent to, default is 1900
+    //! \param timeout Optional time to wait for responses in seconds, default is 5
+    //!
+    //! Blocks until the timeout ran out or onAnswer returned false.
+    //!
+    //! \throws std::system_error when system or socket operations fail
+    virtual void sendMulticast(const std::string& msg, const std::function<bool(const std::string&)>& onAnswer,
+        const std::string& adr = "239.255.255.250", int port = 1900, int timeout = 5) const = 0;
+
     //! \brief Send a HTTP request with the given method to the specified host and return the body of the response.
     //!
     //! \param method HTTP method type e.g. GET, HEAD, POST, PUT, DELETE, ...
@@ -153,6 +182,22 @@ public:
     virtual nlohmann::json GETJson(
         const std::string& uri, const nlohmann::json& body, const std::string& adr, int port = 80) const = 0;
 
+    //! \brief Send a HTTP GET request to the specified host and parse the body of the response with a SAX handler.
+    //!
+    //! The body is parsed while it is received and is never stored as a whole,
+    //! so the handler can pick out the values it needs without building the entire document.
+    //! \param uri Uniform Resource Identifier in the request
+    //! \param body Request body, may be empty
+    //! \param handler Receives the SAX events of the body, see nlohmann::json::sax_parse
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return false when the handler stopped parsing, otherwise true
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when response contained no body
+    //! \throws nlohmann::json::parse_error when the body could not be parsed and the handler throws on errors
+    virtual bool GETJsonSax(const std::string& uri, const nlohmann::json& body, nlohmann::json::json_sax_t& handler,
+        const std::string& adr, int port = 80) const = 0;
+
     //! \brief Send a HTTP POST request to the specified host and return the body of the response parsed as JSON.
     //!
     //! \param uri Uniform Resource Identifier in the request
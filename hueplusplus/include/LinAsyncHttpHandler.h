@@ -0,0 +1,105 @@
+/**
+    \file LinAsyncHttpHandler.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _LINASYNCHTTPHANDLER_H
+#define _LINASYNCHTTPHANDLER_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "BaseAsyncHttpHandler.h"
+#include "HostResolver.h"
+
+//! Class to handle http requests asynchronously on linux systems
+//!
+//! All sockets are non-blocking and driven by a single epoll event loop on a background thread,
+//! so many requests can be in flight without a thread per request. Connections are kept alive and
+//! reused, the number of connections per address and port is limited and further requests wait in a queue.
+//! Completion callbacks are called on the event loop thread and must not block.
+class LinAsyncHttpHandler : public BaseAsyncHttpHandler
+{
+public:
+    //! \brief Ctor, starts the event loop thread
+    //! \throws std::system_error when the event loop could not be created
+    LinAsyncHttpHandler();
+
+    //! \brief Dtor, stops the event loop and closes all connections
+    //!
+    //! Requests that are not completed yet fail with std::errc::operation_canceled.
+    ~LinAsyncHttpHandler();
+
+    //! \brief Sets the maximum number of connections per address and port. Default is 4
+    //!
+    //! Requests are queued while all connections are busy. Applies to connections opened afterwards.
+    void setMaxConnections(std::size_t count);
+
+    //! \brief Enables pipelining of requests on keep-alive connections
+    //!
+    //! When all connections to a host are busy, further requests are sent on them without waiting for the
+    //! previous responses, which are matched to the requests in order. This removes the round trip time
+    //! between requests. POST requests are never queued behind others, because they are never retried.
+    //! When a connection is lost, requests that were sent completely but not answered fail with ECONNRESET,
+    //! because the host may have applied them. The RetryPolicy of HueCommandAPI decides whether they are sent
+    //! again. Requests that were not sent completely, or that the host did not process because it closed the
+    //! connection after a response, are sent again on another connection.
+    //! \param depth Maximum number of requests sent on a connection before their responses are received.
+    //! Default is 1, which disables pipelining.
+    void setPipelining(std::size_t depth);
+
+    //! \brief Sets the time allowed for each request. Default is 10 seconds
+    //!
+    //! The time starts when the request is passed to \ref send and covers waiting for a connection,
+    //! connecting, sending and receiving the response. Requests that take longer fail with std::system_error
+    //! with std::errc::timed_out. An earlier deadline of the \ref RequestOptions of the calling thread takes
+    //! precedence.
+    //! \note Must not be called while requests are sent.
+    //! \param timeout Time allowed for each request, zero to only use the deadline of the \ref RequestOptions
+    void setTimeout(std::chrono::steady_clock::duration timeout);
+
+    //! \brief Sets how long resolved host names are cached. Default is 5 minutes
+    //!
+    //! Numeric IPv4 and IPv6 addresses are never looked up.
+    void setHostCacheTTL(std::chrono::steady_clock::duration ttl);
+
+    using BaseAsyncHttpHandler::send;
+
+    //! \brief Sends a message to the specified host and passes the response to a callback.
+    //!
+    //! Host names are resolved on the calling thread before the request is queued,
+    //! so a failed lookup calls onResponse before this function returns.
+    //! \param msg The message that should be sent to the specified address
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Port the request is sent to
+    //! \param onResponse Called on the event loop thread with the whole response of the host.
+    //! Fails with std::system_error when system or socket operations fail.
+    void send(const std::string& msg, const std::string& adr, int port, ResponseCallback onResponse) const override;
+
+private:
+    class EventLoop;
+
+    std::chrono::steady_clock::duration timeout;
+    mutable HostResolver resolver;
+    std::unique_ptr<EventLoop> loop;
+};
+
+#endif
@@ -23,10 +23,12 @@
 #ifndef _LINHTTPHANDLER_H
 #define _LINHTTPHANDLER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "BaseHttpHandler.h"
+#include "HostResolver.h"
 
 #include "json/json.hpp"
 
@@ -34,6 +36,38 @@
 class LinHttpHandler : public BaseHttpHandler
 {
 public:
+    //! \brief Ctor, keep-alive connections are enabled by default
+    LinHttpHandler();
+
+    //! \brief Dtor, closes all idle connections
+    ~LinHttpHandler();
+
+    //! \brief Enables or disables persistent connections.
+    //!
+    //! When enabled, requests are sent as HTTP/1.1 keep-alive requests and idle sockets are kept
+    //! in a pool per address and port to be reused by the next request.
+    //! When disabled, every request is sent as HTTP/1.0 request on a new connection which is closed afterwards.
+    //! \note Must not be called while requests are in progress.
+    //! \param enable Whether connections are kept alive
+    void setKeepAlive(bool enable);
+
+    //! \brief Sets the maximum number of idle connections kept per address and port. Default is 4
+    //! \note Must not be called while requests are in progress.
+    void setMaxIdleConnections(std::size_t count);
+
+    //! \brief Sets the time allowed for each request. Default is 10 seconds
+    //!
+    //! The time covers connecting, sending and receiving the response. Requests that take longer fail with
+    //! std::system_error with std::errc::timed_out. An earlier deadline of the \ref RequestOptions of the
+    //! calling thread takes precedence.
+    //! \param timeout Time allowed for each request, zero to only use the deadline of the \ref RequestOptions
+    void setTimeout(std::chrono::steady_clock::duration timeout);
+
+    //! \brief Sets how long resolved host names are cached. Default is 5 minutes
+    //!
+    //! Numeric IPv4 and IPv6 addresses are never looked up.
+    void setHostCacheTTL(std::chrono::steady_clock::duration ttl);
+
     //! \brief Function that sends a given message to the specified host and
     //! returns the response.
     //!
@@ -44,6 +78,19 @@ public:
     //! String containing the response of the host
     virtual std::string send(const std::string& msg, const std::string& adr, int port = 80) const;
 
+    using BaseHttpHandler::sendGetHTTPBody;
+
+    //! \brief Sends a message and passes the body of the response to a callback as a stream.
+    //!
+    //! The body is read from the socket while the callback reads from the stream and is not stored as a whole.
+    //! When the body was not received completely by the time the callback returns, the connection is closed.
+    //! \param msg String that contains the message that is sent to the specified address
+    //! \param onBody Called once with the body of the response, the stream is only valid during the call
+    //! \param adr String that contains an ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional integer that specifies the port to which the request is sent to. Default is 80
+    void sendGetHTTPBody(const std::string& msg, const std::function<void(std::istream&)>& onBody,
+        const std::string& adr, int port = 80) const override;
+
     //! \brief Function that sends a multicast request with the specified message.
     //!
     //! \param msg String that contains the request that is sent to the specified
@@ -55,6 +102,37 @@ public:
     //! answer received
     virtual std::vector<std::string> sendMulticast(
         const std::string& msg, const std::string& adr = "239.255.255.250", int port = 1900, int timeout = 5) const;
+
+    //! \brief Sends a multicast request and passes each answer to a callback as soon as it arrives.
+    //!
+    //! Waits for answers with poll, so no cpu time is used while waiting.
+    //! \param msg String that contains the request that is sent to the specified address
+    //! \param onAnswer Called with each received answer. Return false to stop waiting for more answers.
+    //! \param adr Optional String that contains an ip or hostname in dotted decimal notation, default is
+    //! "239.255.255.250"
+    //! \param port Optional integer that specifies the port to which the request is sent. Default is 1900
+    //! \param timeout Optional Integer that specifies the timeout of the request in seconds. Default is 5
+    void sendMulticast(const std::string& msg, const std::function<bool(const std::string&)>& onAnswer,
+        const std::string& adr = "239.255.255.250", int port = 1900, int timeout = 5) const override;
+
+protected:
+    //! \brief Whether persistent connections are enabled, see \ref setKeepAlive
+    bool useKeepAlive() const override;
+
+    //! \brief Sends the pieces of the request with one scatter-gather call and returns the whole response
+    std::string sendRequest(const HttpRequestWriter& request, const std::string& adr, int port) const override;
+
+    //! \brief Sends the pieces of the request with one scatter-gather call and streams the body of the response
+    void sendRequest(const HttpRequestWriter& request, const std::function<void(std::istream&)>& onBody,
+        const std::string& adr, int port) const override;
+
+private:
+    class ConnectionPool;
+
+    bool keepAlive;
+    std::chrono::steady_clock::duration timeout;
+    std::unique_ptr<ConnectionPool> pool;
+    mutable HostResolver resolver;
 };
 
 #endif
@@ -0,0 +1,107 @@
+/**
+    \file Log.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _HUE_LOG_H
+#define _HUE_LOG_H
+
+#include <atomic>
+#include <functional>
+#include <sstream>
+#include <string>
+
+//! \brief Severity of a log message
+enum class LogLevel
+{
+    debug = 0, //!< Details for debugging, like requests and responses
+    info = 1, //!< Normal operation, like instructions for the user
+    warning = 2, //!< Unexpected answers that are ignored
+    error = 3, //!< Failures that are also reported with an exception
+    off = 4 //!< Disables all messages
+};
+
+//! \brief Lowest level that is compiled into the library, 0 (debug) to 4 (off)
+//!
+//! Messages below this level are removed at compile time, so they cost nothing.
+//! Set with the cmake variable hueplusplus_LOG_LEVEL.
+#ifndef HUEPLUSPLUS_LOG_LEVEL
+#define HUEPLUSPLUS_LOG_LEVEL 0
+#endif
+
+//! \brief Logging facade used for all messages of the library
+//!
+//! By default, messages of level info and above are written to std::cerr.
+//! Use \ref HUE_LOG to write messages, so disabled messages are not formatted.
+class Log
+{
+public:
+    //! \brief Receives messages that pass the level, without trailing newline
+    //!
+    //! Calls are serialized, so the sink does not need to be thread safe.
+    using Sink = std::function<void(LogLevel level, const std::string& message)>;
+
+public:
+    //! \brief Sets the sink that receives all messages
+    //! \param sink New sink, nullptr to discard all messages
+    static void setSink(Sink sink);
+    //! \brief Restores the default sink, which writes to std::cerr
+    static void resetSink();
+
+    //! \brief Sets the lowest level that is passed to the sink. Default is info
+    //!
+    //! Levels below \ref HUEPLUSPLUS_LOG_LEVEL are never passed to the sink.
+    static void setLevel(LogLevel level);
+    //! \brief Returns the lowest level that is passed to the sink
+    static LogLevel getLevel();
+
+    //! \brief Returns whether messages of level are passed to the sink
+    static bool isEnabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= HUEPLUSPLUS_LOG_LEVEL
+            && static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed);
+    }
+
+    //! \brief Passes message to the sink without checking the level
+    static void write(LogLevel level, const std::string& message);
+
+private:
+    static std::atomic<int> minLevel;
+};
+
+//! \brief Writes a message to the \ref Log when level is enabled
+//!
+//! message can be a chain of stream insertions, which are only evaluated when level is enabled:
+//! \code
+//! HUE_LOG(LogLevel::error, "Failed to connect to " << ip);
+//! \endcode
+#define HUE_LOG(level, message)                                                                                        \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (Log::isEnabled(level))                                                                                     \
+        {                                                                                                              \
+            std::ostringstream hueLogStream;                                                                           \
+            hueLogStream << message;                                                                                   \
+            Log::write(level, hueLogStream.str());                                                                     \
+        }                                                                                                              \
+    } while (false)
+
+#endif
@@ -0,0 +1,74 @@
+/**
+    \file RateLimiter.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _RATE_LIMITER_H
+#define _RATE_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+//! Thread safe token bucket that paces requests, used by \ref HueCommandAPI
+//!
+//! Each request reserves a start time with \ref tryReserve without holding any lock and otherwise waits
+//! until the returned time, so the wait of one request overlaps with the network I/O of the previous ones.
+//! On average, requests are started one interval apart. After a pause, up to burst requests
+//! can be started at once.
+class RateLimiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+public:
+    //! \brief Creates a rate limiter with a full bucket
+    //! \param interval Average time between requests
+    //! \param burst Number of requests that can be started at once, at least 1
+    explicit RateLimiter(Clock::duration interval, std::size_t burst = 1);
+
+    //! \brief Reserves a start time only if the request can be started now
+    //! \param next Set to the earliest start time when the request cannot be started now
+    //! \returns whether the request was reserved and can be started
+    bool tryReserve(Clock::time_point& next);
+
+    //! \brief Returns the average time between requests
+    Clock::duration getInterval() const;
+    //! \brief Sets the average time between requests
+    //!
+    //! Requests that already reserved a time are not affected.
+    void setInterval(Clock::duration interval);
+
+    //! \brief Returns the number of requests that can be started at once
+    std::size_t getBurst() const;
+    //! \brief Sets the number of requests that can be started at once
+    //! \param burst Size of the bucket, values below 1 are treated as 1
+    void setBurst(std::size_t burst);
+
+private:
+    std::atomic<Clock::rep> interval;
+    std::atomic<std::size_t> burst;
+    // Time at which the bucket is empty again after all reservations, as ticks of Clock.
+    // The bucket is full when this is at or before now.
+    std::atomic<Clock::rep> emptyUntil;
+};
+
+#endif
@@ -0,0 +1,209 @@
+/**
+    \file RequestMetrics.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _REQUEST_METRICS_H
+#define _REQUEST_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+//! Lock-free histogram of durations with logarithmic buckets
+//!
+//! Durations are recorded in microseconds. Below 8 us every value has its own bucket, above each power of two
+//! is divided into 8 buckets, so quantiles have a relative error of at most 12.5%. Durations above 2^40 us
+//! are counted in the last bucket.
+class LatencyHistogram
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! \brief Number of buckets
+    static constexpr std::size_t bucketCount = 8 + 38 * 8;
+
+    //! \brief Counts of a histogram at one point in time
+    struct Snapshot
+    {
+        //! \brief Count of every bucket
+        std::vector<std::uint64_t> buckets;
+        //! \brief Number of recorded durations
+        std::uint64_t count = 0;
+        //! \brief Sum of all recorded durations
+        Clock::duration sum = Clock::duration::zero();
+
+        //! \brief Returns the duration below which fraction q of all durations are, zero when empty
+        //! \param q Fraction between 0 and 1, like 0.99 for the 99th percentile
+        Clock::duration quantile(double q) const;
+        //! \brief Returns the number of durations in buckets whose upper bound is at most limit
+        std::uint64_t countAtMost(Clock::duration limit) const;
+    };
+
+public:
+    //! \brief Creates an empty histogram
+    LatencyHistogram();
+
+    //! \brief Adds a duration, negative durations are counted as zero
+    void record(Clock::duration duration);
+    //! \brief Returns the current counts
+    Snapshot snapshot() const;
+
+    //! \brief Returns the bucket of a duration in microseconds
+    static std::size_t bucketOf(std::uint64_t micros);
+    //! \brief Returns the largest duration in microseconds that is counted in a bucket
+    static std::uint64_t upperBound(std::size_t bucket);
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets;
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sumMicros;
+};
+
+//! Latencies and outcomes of the requests of a \ref HueCommandAPI by method and path
+//!
+//! Recording does not lock. Paths are normalized by \ref normalizePath, so all lights share one endpoint.
+//! Up to \ref maxEndpoints endpoints are tracked separately, further ones are combined with the path "*".
+class RequestMetrics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! \brief Maximum number of endpoints that are tracked separately
+    static constexpr std::size_t maxEndpoints = 128;
+
+    //! \brief Metrics of one endpoint at one point in time
+    struct EndpointSnapshot
+    {
+        std::string method; //!< HTTP method like "PUT"
+        std::string path; //!< Normalized path like "/lights/{id}/state"
+        LatencyHistogram::Snapshot queueWait; //!< Time waiting for the rate budget, per attempt
+        LatencyHistogram::Snapshot network; //!< Round trip time of the handler without parsing, per attempt
+        LatencyHistogram::Snapshot parse; //!< Time the handler spent parsing the response, per attempt
+        LatencyHistogram::Snapshot total; //!< Time of the whole call including retries
+        std::uint64_t successes = 0; //!< Calls that got a response without error
+        std::uint64_t failures = 0; //!< Calls that failed with an exception, like a connection error
+        std::uint64_t retries = 0; //!< Attempts that were repeated
+        std::uint64_t coalesced = 0; //!< Calls that shared the request of another call instead of sending one
+        std::map<int, std::uint64_t> apiErrors; //!< Calls that got an error from the bridge by error type
+    };
+
+    //! \brief Recorder for one method and path
+    class Endpoint
+    {
+    public:
+        //! \brief Creates an endpoint without recorded requests
+        Endpoint(const std::string& method, const std::string& path);
+
+        //! \brief Returns the HTTP method
+        const std::string& getMethod() const { return method; }
+        //! \brief Returns the normalized path
+        const std::string& getPath() const { return path; }
+
+        //! \brief Records the time an attempt waited for the rate budget
+        void recordQueueWait(Clock::duration duration) { queueWait.record(duration); }
+        //! \brief Records the round trip time of an attempt
+        void recordNetwork(Clock::duration duration) { network.record(duration); }
+        //! \brief Records the time an attempt spent parsing the response
+        void recordParse(Clock::duration duration) { parse.record(duration); }
+        //! \brief Records the time of a whole call
+        void recordTotal(Clock::duration duration) { total.record(duration); }
+        //! \brief Counts a call that got a response without error
+        void recordSuccess() { successes.fetch_add(1, std::memory_order_relaxed); }
+        //! \brief Counts a call that failed with an exception
+        void recordFailure() { failures.fetch_add(1, std::memory_order_relaxed); }
+        //! \brief Counts a repeated attempt
+        void recordRetry() { retries.fetch_add(1, std::memory_order_relaxed); }
+        //! \brief Counts a call that shared the request of another call
+        void recordCoalesced() { coalesced.fetch_add(1, std::memory_order_relaxed); }
+        //! \brief Counts a call that got an error from the bridge
+        //! \param type Error type of the bridge, like 901
+        void recordAPIError(int type);
+
+        //! \brief Returns the current metrics
+        EndpointSnapshot snapshot() const;
+
+    private:
+        //! \brief Number of error types that are counted separately, others are counted as type 0
+        static constexpr std::size_t errorSlots = 16;
+
+        std::string method;
+        std::string path;
+        LatencyHistogram queueWait;
+        LatencyHistogram network;
+        LatencyHistogram parse;
+        LatencyHistogram total;
+        std::atomic<std::uint64_t> successes;
+        std::atomic<std::uint64_t> failures;
+        std::atomic<std::uint64_t> retries;
+        std::atomic<std::uint64_t> coalesced;
+        std::array<std::atomic<int>, errorSlots> errorTypes; //!< Error type of each slot, 0 for free slots
+        std::array<std::atomic<std::uint64_t>, errorSlots + 1> errorCounts; //!< Last one for other types
+    };
+
+public:
+    //! \brief Creates metrics without endpoints
+    RequestMetrics();
+    //! \brief Destroys all endpoints
+    ~RequestMetrics();
+
+    RequestMetrics(const RequestMetrics&) = delete;
+    RequestMetrics& operator=(const RequestMetrics&) = delete;
+
+    //! \brief Returns the recorder for a method and path, which is created when needed
+    //! \param method HTTP method like "PUT"
+    //! \param path API request path (after /api/{username}), is normalized
+    Endpoint& getEndpoint(const std::string& method, const std::string& path);
+
+    //! \brief Returns the current metrics of all endpoints, sorted by path and method
+    std::vector<EndpointSnapshot> snapshot() const;
+
+    //! \brief Replaces path segments that contain digits, like ids, by "{id}" and adds a leading '/'
+    //! \returns Normalized path like "/lights/{id}/state"
+    static std::string normalizePath(const std::string& path);
+
+    //! \brief Adds time the current thread spent parsing a response
+    //!
+    //! Handlers report the time of their JSON parsing here, so \ref HueCommandAPI can record it separately
+    //! from the network time of the attempt.
+    static void addParseTime(Clock::duration duration);
+    //! \brief Returns the parse time added by the current thread and resets it to zero
+    static Clock::duration takeParseTime();
+
+    //! \brief Formats metrics in the Prometheus text exposition format
+    //!
+    //! Latencies are exported as histograms named hueplusplus_request_<phase>_seconds, with the phases
+    //! queue_wait, network, parse and total, and counters hueplusplus_requests_total{outcome=...},
+    //! hueplusplus_request_retries_total, hueplusplus_request_coalesced_total and
+    //! hueplusplus_request_api_errors_total{type=...}. All have the labels method and path.
+    static std::string toPrometheus(const std::vector<EndpointSnapshot>& endpoints);
+
+private:
+    std::array<std::atomic<Endpoint*>, maxEndpoints> endpoints;
+    Endpoint overflow; //!< Combines endpoints after maxEndpoints
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+    \file RequestOptions.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _REQUEST_OPTIONS_H
+#define _REQUEST_OPTIONS_H
+
+#include <chrono>
+#include <cstdint>
+
+//! Options for the http requests that the current thread makes within a scope
+//!
+//! Http handlers read the options of the calling thread when a request is started, so they also apply to
+//! requests that \ref HueCommandAPI, \ref HueLight or \ref Hue send on behalf of the caller:
+//! \code
+//! RequestOptions::Scope scope(RequestOptions::withTimeout(std::chrono::milliseconds(500)));
+//! light.setBrightness(100);
+//! \endcode
+class RequestOptions
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    class Scope;
+
+    //! \brief Order in which waiting requests are sent
+    //!
+    //! Requests of a lower priority age while they wait, so they are not starved, see \ref RequestScheduler.
+    enum class Priority
+    {
+        interactive = 0, //!< Requests a user is waiting for, like pressing a switch
+        normal = 1, //!< Default priority
+        background = 2 //!< Requests nobody is waiting for, like polling or synchronization
+    };
+
+public:
+    //! \brief Returns the options of the current thread, which has no deadline outside of any \ref Scope
+    static const RequestOptions& current();
+
+    //! \brief Returns the current options with a deadline of at most timeout from now
+    //!
+    //! An earlier deadline of the current options is kept, so nested scopes can only shorten it.
+    static RequestOptions withTimeout(Clock::duration timeout);
+    //! \brief Returns the current options with another priority
+    static RequestOptions withPriority(Priority priority);
+
+    //! \brief Returns the earlier of the deadline and timeout from now, or the deadline when timeout is zero
+    Clock::time_point deadlineWithin(Clock::duration timeout) const;
+
+public:
+    //! \brief Time by which requests must be completed, including connecting, sending and receiving.
+    //!
+    //! Requests that are not completed in time fail with std::errc::timed_out.
+    //! Clock::time_point::max() when there is no deadline.
+    Clock::time_point deadline = Clock::time_point::max();
+    //! \brief Priority of requests waiting for their turn in \ref HueCommandAPI
+    Priority priority = Priority::normal;
+    //! \brief Trace of the current \ref Trace::Span, 0 outside of any span
+    std::uint64_t traceId = 0;
+    //! \brief Id of the current \ref Trace::Span, which is the parent of spans started by the thread
+    std::uint64_t spanId = 0;
+};
+
+//! \brief Sets the options of the current thread until it is destroyed
+class RequestOptions::Scope
+{
+public:
+    //! \brief Makes options the current options of the thread
+    explicit Scope(const RequestOptions& options);
+    //! \brief Restores the previous options
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    RequestOptions previous;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/**
+    \file RequestScheduler.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _REQUEST_SCHEDULER_H
+#define _REQUEST_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <utility>
+
+#include "AdaptivePacer.h"
+#include "RateLimiter.h"
+#include "RequestOptions.h"
+
+//! Lets waiting requests start in the order of their priority, used by \ref HueCommandAPI
+//!
+//! Requests are paced by a \ref RateLimiter. When several requests wait for a start time, the one with
+//! the highest priority gets the next one. To avoid starvation, a waiting request is treated as if it had
+//! a higher priority for every aging delay it waited, so a background request waits at most about two aging
+//! delays longer than an interactive one. The lock is never held while requests wait or run, and requests that
+//! can start immediately while nobody waits only reserve their start time with the lock-free \ref RateLimiter.
+class RequestScheduler
+{
+public:
+    using Clock = RateLimiter::Clock;
+
+public:
+    //! \brief Creates a scheduler with a full bucket
+    //! \param interval Average time between requests
+    explicit RequestScheduler(Clock::duration interval);
+
+    //! \brief Waits until the request may be started
+    //! \param priority Priority of the request
+    //! \param deadline Time by which the request must be started
+    //! \throws std::system_error with std::errc::timed_out when the deadline passes first
+    void wait(RequestOptions::Priority priority, Clock::time_point deadline);
+
+    //! \brief Returns the rate limiter that paces the requests
+    RateLimiter& getRateLimiter();
+    //! \brief Returns the pacer that adapts the interval of the rate limiter
+    AdaptivePacer& getPacer();
+
+    //! \brief Returns how long requests wait for each priority level they are raised
+    Clock::duration getAgingDelay() const;
+    //! \brief Sets how long requests wait for each priority level they are raised. Default is 5 seconds
+    //!
+    //! Requests that are already waiting keep their position.
+    void setAgingDelay(Clock::duration delay);
+
+private:
+    // Waiting requests ordered by the time at which they would have been submitted as interactive,
+    // then by the order of submission
+    using Ticket = std::pair<Clock::time_point, std::uint64_t>;
+
+private:
+    RateLimiter rateLimiter;
+    AdaptivePacer pacer;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::set<Ticket> waiting;
+    std::atomic<std::size_t> waitingCount; //!< size of \ref waiting, read without the lock by the fast path
+    std::uint64_t nextSequence;
+    Clock::duration agingDelay;
+};
+
+#endif
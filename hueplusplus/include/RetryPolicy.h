@@ -0,0 +1,122 @@
+/**
+    \file RetryPolicy.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _RETRY_POLICY_H
+#define _RETRY_POLICY_H
+
+#include <chrono>
+#include <system_error>
+
+//! Decides whether and when failed requests of \ref HueCommandAPI are sent again
+//!
+//! The default settings retry a request once when the connection was reset or timed out, after waiting for
+//! the current delay of its request type. Subclasses can override \ref shouldRetry for other strategies.
+//! Retries never go past the deadline of the calling thread's \ref RequestOptions.
+class RetryPolicy
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! \brief Cause of a failed attempt
+    enum class ErrorType
+    {
+        transport, //!< Connecting, sending or receiving failed with std::system_error
+        http, //!< The response could not be read, for example because it had no body or invalid json
+        api //!< The bridge answered with an error
+    };
+
+    //! \brief Failed attempt of a request
+    struct Failure
+    {
+        //! \brief Cause of the failure
+        ErrorType type = ErrorType::transport;
+        //! \brief Error code of transport errors
+        std::error_code code;
+        //! \brief Error type reported by the bridge for api errors, like 901 for an internal error
+        int apiError = 0;
+        //! \brief Number of the failed attempt, 1 for the first one
+        unsigned int attempt = 1;
+        //! \brief Whether sending the request again has no other effect than sending it once.
+        //!
+        //! True for GET and DELETE requests and for light state changes without increments or alerts.
+        bool idempotent = true;
+        //! \brief Time since the first attempt was started
+        Clock::duration elapsed = Clock::duration::zero();
+        //! \brief Current delay between requests of the request type
+        Clock::duration interval = Clock::duration::zero();
+    };
+
+    //! \brief Parameters of the default policy
+    struct Settings
+    {
+        //! \brief Maximum number of attempts including the first one
+        unsigned int maxAttempts = 2;
+        //! \brief Wait before the second attempt, the delay of the request type is waited at least
+        Clock::duration initialBackoff = Clock::duration::zero();
+        //! \brief Factor by which the wait grows for every further attempt
+        double backoffFactor = 2.0;
+        //! \brief Longest wait between attempts, unless the delay of the request type is longer
+        Clock::duration maxBackoff = std::chrono::seconds(2);
+        //! \brief Random fraction of the wait that is added, to spread out clients that retry together
+        double jitter = 0.2;
+        //! \brief Time after the first attempt after which no attempt is started, zero for no limit
+        Clock::duration budget = Clock::duration::zero();
+        //! \brief Whether PUT requests that are not idempotent are retried, like changes of "bri_inc"
+        bool retryPUT = true;
+        //! \brief Whether internal errors (901) of an overloaded bridge are retried
+        bool retryInternalErrors = false;
+        //! \brief Whether responses that could not be read are retried
+        bool retryHttpErrors = false;
+    };
+
+public:
+    //! \brief Creates a policy with the default settings
+    RetryPolicy();
+    //! \brief Creates a policy with settings
+    explicit RetryPolicy(const Settings& settings);
+    virtual ~RetryPolicy() = default;
+
+    //! \brief Returns the settings
+    const Settings& getSettings() const;
+
+    //! \brief Decides whether a failed request is sent again
+    //! \param failure Failed attempt
+    //! \param delay Set to the time to wait before the next attempt, when true is returned.
+    //! The next attempt also waits for its turn in the rate budget of its request type.
+    //! \returns Whether the request is sent again
+    virtual bool shouldRetry(const Failure& failure, Clock::duration& delay) const;
+
+    //! \brief Returns whether the cause of a failure is temporary and the request may be repeated
+    //!
+    //! Connection resets and timeouts are temporary. Internal errors of the bridge and unreadable responses
+    //! are temporary when enabled in the settings. Requests that are not idempotent are only repeated
+    //! when \ref Settings::retryPUT is set.
+    bool isRetryable(const Failure& failure) const;
+    //! \brief Returns the time to wait after a failed attempt, growing exponentially with random jitter
+    Clock::duration getBackoff(const Failure& failure) const;
+
+private:
+    Settings settings;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/**
+    \file StatePoller.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _STATEPOLLER_H
+#define _STATEPOLLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HueCommandAPI.h"
+
+#include "json/json.hpp"
+
+//! \brief Polls the state of all lights of a bridge in the background and reports changes
+//!
+//! Every interval the "lights" section of the full bridge state is requested, which is one request for all
+//! lights. The new state is compared with the previous one and the differences are passed to the subscribers
+//! on a separate dispatch thread, so slow subscribers do not delay polling.
+//! Usually started with \ref Hue::startPolling, which applies every polled state to the bridge and its lights
+//! before the changes are passed to subscribers.
+class StatePoller
+{
+public:
+    //! \brief A change of one light between two polls
+    struct LightChange
+    {
+        enum class Type
+        {
+            added, //!< Light is new, \ref newValue contains its full state
+            removed, //!< Light was deleted, \ref oldValue contains its last full state
+            changed //!< Value at \ref attribute changed
+        };
+
+        Type type;
+        int id; //!< Id of the light
+        std::string attribute; //!< JSON pointer to the value in the light like "/state/bri", empty if not changed
+        nlohmann::json oldValue; //!< Value before the change, null when added
+        nlohmann::json newValue; //!< Value after the change, null when removed
+    };
+
+    //! \brief Called on the dispatch thread for every change
+    using Subscriber = std::function<void(const LightChange&)>;
+
+    //! \brief Called on the poll thread with the "lights" section of every successful poll
+    using UpdateHandler = std::function<void(const nlohmann::json&)>;
+
+public:
+    //! \brief Starts polling
+    //! \param commands HueCommandAPI for communication with the bridge
+    //! \param interval Time between the end of a request and the start of the next
+    StatePoller(const HueCommandAPI& commands, std::chrono::milliseconds interval);
+
+    //! \brief Stops polling, see \ref stop
+    ~StatePoller();
+
+    StatePoller(const StatePoller&) = delete;
+    StatePoller& operator=(const StatePoller&) = delete;
+
+    //! \brief Stops polling and the dispatch thread
+    //!
+    //! Changes that were not passed to subscribers yet are dropped.
+    //! Must not be called from a subscriber.
+    void stop();
+
+    //! \brief Returns whether the poller was not stopped
+    bool isRunning() const;
+
+    //! \brief Sets the time between two requests, applies after the next request
+    void setInterval(std::chrono::milliseconds interval);
+
+    //! \brief Returns the time between two requests
+    std::chrono::milliseconds getInterval() const;
+
+    //! \brief Adds a subscriber
+    //! \param subscriber Called for every change after the first poll, must not be empty
+    //! \returns Id for \ref unsubscribe
+    std::uint64_t subscribe(Subscriber subscriber);
+
+    //! \brief Removes a subscriber
+    //!
+    //! The subscriber may still be called once if the dispatch thread is currently calling subscribers.
+    //! \param id Id returned by \ref subscribe
+    void unsubscribe(std::uint64_t id);
+
+    //! \brief Adds a handler that is called for every poll before its changes are passed to subscribers
+    //! \param handler Called with the state of all lights, must not be empty. It delays polling, so it should
+    //! only store the state.
+    //! \returns Id for \ref removeUpdateHandler
+    std::uint64_t addUpdateHandler(UpdateHandler handler);
+
+    //! \brief Removes a handler
+    //!
+    //! The handler may still be called once if the poll thread is currently calling handlers.
+    //! \param id Id returned by \ref addUpdateHandler
+    void removeUpdateHandler(std::uint64_t id);
+
+    //! \brief Returns when the last successful poll received the state
+    //!
+    //! The epoch of the clock when no poll was successful yet.
+    std::chrono::steady_clock::time_point getUpdateTime() const;
+
+    //! \brief Returns the state of a light from the last successful poll
+    //! \param id Id of the light
+    //! \param time Set to the time the state was received
+    //! \returns State of the light like an entry in the "lights" section of the bridge state,
+    //! or null when the light is unknown
+    nlohmann::json getLightState(int id, std::chrono::steady_clock::time_point& time) const;
+
+    //! \brief Returns the changes between two "lights" sections of the bridge state
+    //!
+    //! Objects are compared member by member, all other values as a whole.
+    //! \param oldLights Previous state of all lights
+    //! \param newLights Current state of all lights
+    //! \returns Changes grouped by light
+    static std::vector<LightChange> diff(const nlohmann::json& oldLights, const nlohmann::json& newLights);
+
+private:
+    //! \brief Requests the state, passes it to the update handlers and queues the changes
+    //! \throws std::exception when the request fails or the state is invalid
+    void Poll();
+
+    //! \brief Polls until stopped
+    void RunPoll();
+
+    //! \brief Passes queued changes to the subscribers until stopped
+    void RunDispatch();
+
+    //! \brief Adds the changes of two values of one light to changes
+    static void DiffValue(int id, const std::string& attribute, const nlohmann::json& oldValue,
+        const nlohmann::json& newValue, std::vector<LightChange>& changes);
+
+private:
+    HueCommandAPI commands;
+
+    mutable std::mutex mutex;
+    std::condition_variable pollWakeup;
+    std::condition_variable dispatchWakeup;
+    bool stopped = false;
+    std::chrono::milliseconds interval;
+    std::shared_ptr<const nlohmann::json> lights; //!< "lights" section of the last poll, nullptr before
+    std::chrono::steady_clock::time_point updateTime; //!< Time \ref lights was received
+    std::deque<LightChange> pending; //!< Changes that were not passed to subscribers yet
+    std::map<std::uint64_t, Subscriber> subscribers;
+    std::map<std::uint64_t, UpdateHandler> updateHandlers;
+    std::uint64_t nextSubscriberId = 1; //!< Next id of a subscriber or update handler
+
+    std::thread pollThread;
+    std::thread dispatchThread;
+};
+
+#endif
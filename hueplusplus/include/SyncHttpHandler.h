@@ -0,0 +1,80 @@
+/**
+    \file SyncHttpHandler.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _SYNCHTTPHANDLER_H
+#define _SYNCHTTPHANDLER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BaseHttpHandler.h"
+#include "IAsyncHttpHandler.h"
+
+//! Adapter that implements the blocking IHttpHandler on top of an IAsyncHttpHandler
+//!
+//! Each request is sent with the asynchronous handler and the calling thread waits for its completion,
+//! so the calls of several threads share the connections and the event loop of the asynchronous handler.
+class SyncHttpHandler : public BaseHttpHandler
+{
+public:
+    //! \brief Creates adapter
+    //!
+    //! \param asyncHandler Handler that sends all http requests
+    //! \param multicastHandler Handler for multicast requests, which the asynchronous handler does not support.
+    //! May be nullptr, then multicast requests throw HueException.
+    explicit SyncHttpHandler(std::shared_ptr<const IAsyncHttpHandler> asyncHandler,
+        std::shared_ptr<const IHttpHandler> multicastHandler = nullptr);
+
+    //! \brief Sends a message with the asynchronous handler and waits for the response.
+    //!
+    //! \param msg The message that should be sent to the specified address
+    //! \param adr Ip or hostname in dotted decimal notation like "192.168.2.1"
+    //! \param port Optional port the request is sent to, default is 80
+    //! \return The response of the host
+    //! \throws std::system_error when system or socket operations fail
+    std::string send(const std::string& msg, const std::string& adr, int port = 80) const override;
+
+    using BaseHttpHandler::sendMulticast;
+
+    //! \brief Sends a multicast request with the multicast handler.
+    //!
+    //! \param msg The message that should be sent to the specified multicast address
+    //! \param adr Optional ip or hostname in dotted decimal notation, default is "239.255.255.250"
+    //! \param port Optional port the request is sent to, default is 1900
+    //! \param timeout Optional time to wait for responses in seconds, default is 5
+    //! \return Vector containing strings of each answer received
+    //! \throws std::system_error when system or socket operations fail
+    //! \throws HueException when there is no multicast handler
+    std::vector<std::string> sendMulticast(const std::string& msg, const std::string& adr = "239.255.255.250",
+        int port = 1900, int timeout = 5) const override;
+
+protected:
+    //! \brief Returns true, the asynchronous handler keeps connections open
+    bool useKeepAlive() const override { return true; }
+
+private:
+    std::shared_ptr<const IAsyncHttpHandler> asyncHandler;
+    std::shared_ptr<const IHttpHandler> multicastHandler;
+};
+
+#endif
@@ -0,0 +1,260 @@
+/**
+    \file Trace.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#ifndef _HUE_TRACE_H
+#define _HUE_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "RequestOptions.h"
+
+//! \brief Layer of the library that a \ref TraceSpan describes
+enum class SpanKind
+{
+    user, //!< Span started by the application, like a user action
+    api, //!< Call of \ref HueCommandAPI, including waiting for the rate budget and retries
+    http //!< Http request sent by a \ref BaseHttpHandler
+};
+
+//! \brief Description of a traced operation that is passed to \ref TraceInterceptor
+struct TraceSpan
+{
+    //! \brief Id shared by all spans of one trace, which is the id of its root span
+    std::uint64_t traceId = 0;
+    //! \brief Random id of the span, never 0
+    std::uint64_t spanId = 0;
+    //! \brief Id of the enclosing span, 0 for root spans
+    std::uint64_t parentId = 0;
+    SpanKind kind = SpanKind::user;
+    //! \brief Http method like "PUT" or the name of a user span
+    std::string method;
+    //! \brief Path of the api request or uri of the http request
+    std::string path;
+    //! \brief Size of the body of the http request, 0 for other kinds
+    std::size_t requestBytes = 0;
+    //! \brief Size of the body of the http response that was read, 0 for other kinds
+    std::size_t responseBytes = 0;
+    std::chrono::steady_clock::time_point start;
+    //! \brief End of the span, equal to start in \ref TraceInterceptor::onStart
+    std::chrono::steady_clock::time_point end;
+    //! \brief Whether the operation failed with an exception
+    bool failed = false;
+    //! \brief Message of the exception when failed
+    std::string error;
+};
+
+//! \brief Receives the start and end of all spans, for example to export them to a tracing system
+//!
+//! Interceptors are called on the thread that runs the operation, so they must be thread safe.
+//! They must not throw.
+class TraceInterceptor
+{
+public:
+    virtual ~TraceInterceptor() = default;
+
+    //! \brief Called when a span starts
+    virtual void onStart(const TraceSpan& span) { (void)span; }
+    //! \brief Called when a span ends
+    virtual void onEnd(const TraceSpan& span) = 0;
+};
+
+//! \brief Ordered list of interceptors, which can be changed while spans use it
+//!
+//! Changes replace the list, so every span reports its start and end to the same interceptors.
+//! Copies have the interceptors of the original at the time of the copy.
+class TraceChain
+{
+public:
+    using Interceptors = std::vector<std::shared_ptr<TraceInterceptor>>;
+
+public:
+    //! \brief Creates an empty chain
+    TraceChain();
+    //! \brief Copies the interceptors of other
+    TraceChain(const TraceChain& other);
+    //! \brief Replaces the interceptors by the ones of other
+    TraceChain& operator=(const TraceChain& other);
+
+    //! \brief Adds an interceptor to the end of the chain
+    void add(std::shared_ptr<TraceInterceptor> interceptor);
+    //! \brief Removes an interceptor from the chain
+    void remove(const std::shared_ptr<TraceInterceptor>& interceptor);
+    //! \brief Removes all interceptors
+    void clear();
+
+    //! \brief Returns whether any interceptor is in the chain
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    //! \brief Returns the current interceptors, which do not change anymore
+    std::shared_ptr<const Interceptors> get() const;
+
+private:
+    //! \brief Replaces the interceptors, mutex must be locked
+    void set(std::shared_ptr<const Interceptors> changed);
+
+private:
+    std::mutex mutex;
+    std::shared_ptr<const Interceptors> interceptors;
+    std::atomic<bool> enabled;
+};
+
+//! \brief Tracing facade that reports spans around every bridge call to the registered interceptors
+//!
+//! \ref HueCommandAPI calls and the http requests of \ref BaseHttpHandler and \ref BaseAsyncHttpHandler are
+//! traced. Spans are reported to the global interceptors of this class followed by the interceptors of the
+//! \ref TraceChain of the instance that sends them, see \ref HueCommandAPI::getTraceChain. Spans started by a thread
+//! are children of the current span of the thread, which can be set by the application:
+//! \code
+//! Trace::Span action(SpanKind::user, "setColorRGB");
+//! light.setColorRGB(255, 0, 0);
+//! \endcode
+//! Without interceptors, spans are not created and tracing costs one atomic load per call.
+class Trace
+{
+public:
+    class Span;
+
+public:
+    //! \brief Adds a global interceptor to the end of the chain
+    //!
+    //! Interceptors are called in the order they were added when spans start and in reverse order when they end.
+    static void addInterceptor(std::shared_ptr<TraceInterceptor> interceptor);
+    //! \brief Removes a global interceptor from the chain
+    static void removeInterceptor(const std::shared_ptr<TraceInterceptor>& interceptor);
+    //! \brief Removes all global interceptors
+    static void clearInterceptors();
+
+    //! \brief Returns whether any global interceptor is registered
+    static bool isEnabled() { return global.isEnabled(); }
+    //! \brief Returns whether any global interceptor or any interceptor of chain is registered
+    static bool isEnabled(const TraceChain* chain) { return isEnabled() || (chain && chain->isEnabled()); }
+
+    //! \brief Runs fun in a span, which is marked as failed when fun throws
+    //! \returns The result of fun
+    template <typename Fun>
+    static auto inSpan(SpanKind kind, const char* method, const std::string& path, Fun fun) -> decltype(fun());
+    //! \brief Runs fun in a span that is also reported to chain
+    //! \returns The result of fun
+    template <typename Fun>
+    static auto inSpan(const TraceChain* chain, SpanKind kind, const char* method, const std::string& path, Fun fun)
+        -> decltype(fun());
+
+private:
+    static TraceChain global;
+};
+
+//! \brief Reports an operation to the interceptors of \ref Trace while it exists
+//!
+//! The span is the current span of the thread during its lifetime, so spans and requests started meanwhile
+//! are its children. Does nothing when no interceptor is registered at construction. The end is reported to the
+//! interceptors that were registered at construction.
+class Trace::Span
+{
+public:
+    //! \brief Starts a span as child of the current span of the thread
+    //! \param kind Layer of the operation
+    //! \param method Http method or name of the operation
+    //! \param path Path of the operation, may be empty
+    //! \param chain Interceptors of the instance that runs the operation, which are called after the global
+    //! interceptors, may be nullptr
+    explicit Span(
+        SpanKind kind, const std::string& method, const std::string& path = "", const TraceChain* chain = nullptr);
+    //! \brief Ends the span
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    //! \brief Returns whether the span is reported to interceptors
+    bool isActive() const { return active != nullptr; }
+    //! \brief Returns the span data, nullptr when not active
+    const TraceSpan* get() const { return active ? &active->span : nullptr; }
+
+    //! \brief Sets the size of the request
+    void setRequestBytes(std::size_t bytes);
+    //! \brief Sets the size of the response
+    void setResponseBytes(std::size_t bytes);
+    //! \brief Marks the span as failed
+    //! \param error Description of the failure
+    void fail(const std::string& error);
+    //! \brief Marks the span as failed with the message of an exception
+    void fail(std::exception_ptr error);
+
+    //! \brief Restores the previous current span of the thread, so the span can end on another thread
+    //!
+    //! Used for asynchronous operations, whose span ends in their callback.
+    void detach();
+
+private:
+    struct Active
+    {
+        explicit Active(const RequestOptions& options) : scope(new RequestOptions::Scope(options)) {}
+
+        TraceSpan span;
+        std::shared_ptr<const TraceChain::Interceptors> interceptors;
+        std::unique_ptr<RequestOptions::Scope> scope;
+    };
+
+    std::unique_ptr<Active> active;
+};
+
+template <typename Fun>
+auto Trace::inSpan(SpanKind kind, const char* method, const std::string& path, Fun fun) -> decltype(fun())
+{
+    return inSpan(nullptr, kind, method, path, std::move(fun));
+}
+
+template <typename Fun>
+auto Trace::inSpan(const TraceChain* chain, SpanKind kind, const char* method, const std::string& path, Fun fun)
+    -> decltype(fun())
+{
+    if (!isEnabled(chain))
+    {
+        return fun();
+    }
+    Span span(kind, method, path, chain);
+    try
+    {
+        return fun();
+    }
+    catch (const std::exception& e)
+    {
+        span.fail(e.what());
+        throw;
+    }
+    catch (...)
+    {
+        span.fail("Unknown exception");
+        throw;
+    }
+}
+
+#endif
@@ -23,6 +23,7 @@
 #ifndef _UPNP_H
 #define _UPNP_H
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -41,6 +42,15 @@ public:
     //! \return A vector containing pairs of address and name of all found devices
     //! \throws std::system_error when system or socket operations fail
     std::vector<std::pair<std::string, std::string>> getDevices(std::shared_ptr<const IHttpHandler> handler);
+
+    //! \brief Searches for UPnP devices and passes each one to a callback as soon as it answers.
+    //!
+    //! Duplicate answers are filtered, so onDevice is called only once per device.
+    //! \param handler HttpHandler for communication
+    //! \param onDevice Called with address and name of every found device. Return false to stop searching.
+    //! \throws std::system_error when system or socket operations fail
+    void getDevices(std::shared_ptr<const IHttpHandler> handler,
+        const std::function<bool(const std::pair<std::string, std::string>&)>& onDevice);
 };
 
 #endif
@@ -23,6 +23,9 @@
 #ifndef _UTILS_H
 #define _UTILS_H
 
+#include <string>
+#include <vector>
+
 #include "json/json.hpp"
 
 namespace utils
@@ -67,6 +70,19 @@ namespace utils
     //! \return True if request was executed correctly
     bool validateReplyForLight(const nlohmann::json& request, const nlohmann::json& reply, int lightId);
 
+    //! \brief Function for applying the values confirmed by a reply to a cached state
+    //!
+    //! Every success entry like {"/lights/1/state/bri": 200} that starts with \p path is written to \p state at the
+    //! remaining path ("/state/bri"). Only members that already exist in \p state are changed.
+    //! \param reply The reply that was received
+    //! \param path Path of the changed resource without trailing slash, like "/lights/1"
+    //! \param state Cached state of the resource
+    //! \param unapplied Optional output for the confirmed paths of the resource that could not be written to
+    //! \p state, relative to \p state, like "/state/bri_inc"
+    //! \return Paths of the members that were changed, relative to \p state
+    std::vector<std::string> applyReplyToState(const nlohmann::json& reply, const std::string& path,
+        nlohmann::json& state, std::vector<std::string>* unapplied = nullptr);
+
     //! \brief Returns the object/array member or null if it does not exist
     //!
     //! \param json The base json value
@@ -62,6 +62,8 @@ public:
     std::vector<std::string> sendMulticast(const std::string& msg, const std::string& adr = "239.255.255.250",
         int port = 1900, int timeout = 5) const override;
 
+    using BaseHttpHandler::sendMulticast;
+
 private:
     WSADATA wsaData;
 };
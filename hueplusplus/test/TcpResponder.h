@@ -0,0 +1,146 @@
+/**
+    \file TcpResponder.h
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef _TCP_RESPONDER_H
+#define _TCP_RESPONDER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//! Answers every request on all accepted connections of a loopback tcp socket with the same response
+//!
+//! Each connection is served by its own thread. Requests of the tests always have a body of "null".
+class TcpResponder
+{
+public:
+    explicit TcpResponder(std::string response, std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+        : response(std::move(response)), delay(delay), connections(0), active(0), maxActive(0), maxBatch(0)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd, (sockaddr*)&addr, sizeof(addr));
+        listen(fd, 64);
+        socklen_t len = sizeof(addr);
+        getsockname(fd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        worker = std::thread([this] { run(); });
+    }
+    ~TcpResponder()
+    {
+        shutdown(fd, SHUT_RDWR);
+        worker.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int client : clients)
+            {
+                shutdown(client, SHUT_RDWR);
+            }
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        close(fd);
+    }
+
+    int getPort() const { return port; }
+    //! \brief Number of accepted connections
+    int getConnections() const { return connections; }
+    //! \brief Maximum number of connections that were open at the same time
+    int getMaxActive() const { return maxActive; }
+    //! \brief Maximum number of requests that were received at once on a connection
+    int getMaxBatch()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return maxBatch;
+    }
+
+private:
+    void run()
+    {
+        int client;
+        while ((client = accept(fd, nullptr, nullptr)) >= 0)
+        {
+            ++connections;
+            std::lock_guard<std::mutex> lock(mutex);
+            clients.push_back(client);
+            threads.emplace_back([this, client] { serve(client); });
+        }
+    }
+
+    void serve(int client)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            maxActive = std::max<int>(maxActive, ++active);
+        }
+        std::string request;
+        char buffer[1024];
+        ssize_t bytes;
+        while ((bytes = read(client, buffer, sizeof(buffer))) > 0)
+        {
+            request.append(buffer, bytes);
+            std::size_t end;
+            int batch = 0;
+            while ((end = request.find("\r\n\r\nnull")) != std::string::npos)
+            {
+                request.erase(0, end + 8);
+                ++batch;
+                std::this_thread::sleep_for(delay);
+                ::send(client, response.data(), response.size(), MSG_NOSIGNAL);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            maxBatch = std::max(maxBatch, batch);
+        }
+        --active;
+        std::lock_guard<std::mutex> lock(mutex);
+        clients.erase(std::find(clients.begin(), clients.end(), client));
+        close(client);
+    }
+
+private:
+    std::string response;
+    std::chrono::milliseconds delay;
+    int fd;
+    int port;
+    std::atomic<int> connections;
+    std::atomic<int> active;
+    std::atomic<int> maxActive;
+    std::mutex mutex;
+    int maxBatch;
+    std::vector<int> clients;
+    std::vector<std::thread> threads;
+    std::thread worker;
+};
+
+#endif
@@ -39,6 +39,8 @@ public:
 
     MOCK_CONST_METHOD4(
         sendMulticast, std::vector<std::string>(const std::string& msg, const std::string& adr, int port, int timeout));
+
+    using BaseHttpHandler::sendMulticast;
 };
 
 #endif
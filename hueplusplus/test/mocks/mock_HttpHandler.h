@@ -23,6 +23,7 @@
 #ifndef _MOCK_HTTPHANDLER_H
 #define _MOCK_HTTPHANDLER_H
 
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -39,9 +40,30 @@ public:
 
     MOCK_CONST_METHOD3(sendGetHTTPBody, std::string(const std::string& msg, const std::string& adr, int port));
 
+    // Streams the body returned by the mocked sendGetHTTPBody
+    void sendGetHTTPBody(const std::string& msg, const std::function<void(std::istream&)>& onBody,
+        const std::string& adr, int port) const override
+    {
+        std::istringstream body(sendGetHTTPBody(msg, adr, port));
+        onBody(body);
+    }
+
     MOCK_CONST_METHOD4(
         sendMulticast, std::vector<std::string>(const std::string& msg, const std::string& adr, int port, int timeout));
 
+    // Forwards to the mocked sendMulticast, so tests only need expectations on that one
+    void sendMulticast(const std::string& msg, const std::function<bool(const std::string&)>& onAnswer,
+        const std::string& adr, int port, int timeout) const override
+    {
+        for (const std::string& answer : sendMulticast(msg, adr, port, timeout))
+        {
+            if (!onAnswer(answer))
+            {
+                break;
+            }
+        }
+    }
+
     MOCK_CONST_METHOD6(sendHTTPRequest,
         std::string(const std::string& method, const std::string& uri, const std::string& content_type,
             const std::string& body, const std::string& adr, int port));
@@ -65,6 +87,10 @@ public:
     MOCK_CONST_METHOD4(
         GETJson, nlohmann::json(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port));
 
+    MOCK_CONST_METHOD5(GETJsonSax,
+        bool(const std::string& uri, const nlohmann::json& body, nlohmann::json::json_sax_t& handler,
+            const std::string& adr, int port));
+
     MOCK_CONST_METHOD4(
         POSTJson, nlohmann::json(const std::string& uri, const nlohmann::json& body, const std::string& adr, int port));
 
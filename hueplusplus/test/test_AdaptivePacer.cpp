@@ -0,0 +1,101 @@
+/**
+    \file test_AdaptivePacer.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "../include/AdaptivePacer.h"
+
+namespace
+{
+    AdaptivePacer::Settings EnabledSettings()
+    {
+        AdaptivePacer::Settings settings;
+        settings.enabled = true;
+        settings.minDelay = std::chrono::milliseconds(50);
+        settings.maxDelay = std::chrono::milliseconds(1000);
+        settings.step = std::chrono::milliseconds(10);
+        settings.latencyTarget = std::chrono::milliseconds(200);
+        settings.backoffFactor = 2.0;
+        settings.jitter = 0.2;
+        return settings;
+    }
+} // namespace
+
+TEST(AdaptivePacer, disabled)
+{
+    RateLimiter limiter(std::chrono::milliseconds(100));
+    AdaptivePacer pacer(limiter);
+    EXPECT_FALSE(pacer.getSettings().enabled);
+    EXPECT_EQ(std::chrono::milliseconds(0), pacer.getLatency());
+    pacer.onResponse(std::chrono::milliseconds(40));
+    pacer.onStress();
+    // Only measures
+    EXPECT_EQ(std::chrono::milliseconds(100), pacer.getDelay());
+    EXPECT_EQ(std::chrono::milliseconds(40), pacer.getLatency());
+    EXPECT_DOUBLE_EQ(10.0, pacer.getRate());
+}
+
+TEST(AdaptivePacer, additiveDecrease)
+{
+    RateLimiter limiter(std::chrono::milliseconds(100));
+    AdaptivePacer pacer(limiter);
+    pacer.setSettings(EnabledSettings());
+    pacer.onResponse(std::chrono::milliseconds(40));
+    EXPECT_EQ(std::chrono::milliseconds(90), pacer.getDelay());
+    for (int i = 0; i < 10; ++i)
+    {
+        pacer.onResponse(std::chrono::milliseconds(40));
+    }
+    // Stays within the bounds
+    EXPECT_EQ(std::chrono::milliseconds(50), limiter.getInterval());
+}
+
+TEST(AdaptivePacer, multiplicativeIncrease)
+{
+    RateLimiter limiter(std::chrono::milliseconds(100));
+    AdaptivePacer pacer(limiter);
+    pacer.setSettings(EnabledSettings());
+    pacer.onStress();
+    // Doubled with up to 20% jitter
+    EXPECT_LE(std::chrono::milliseconds(200), pacer.getDelay());
+    EXPECT_GE(std::chrono::milliseconds(240), pacer.getDelay());
+    const AdaptivePacer::Clock::duration delay = pacer.getDelay();
+    // Failures of requests that were already in flight do not back off again
+    pacer.onStress();
+    EXPECT_EQ(delay, pacer.getDelay());
+    std::this_thread::sleep_for(delay);
+    pacer.onStress();
+    EXPECT_LE(2 * delay, pacer.getDelay());
+
+    // Slow responses are stress as well
+    for (int i = 0; i < 5; ++i)
+    {
+        std::this_thread::sleep_for(pacer.getDelay());
+        pacer.onResponse(std::chrono::seconds(1));
+    }
+    EXPECT_EQ(std::chrono::milliseconds(1000), pacer.getDelay());
+    EXPECT_DOUBLE_EQ(1.0, pacer.getRate());
+}
@@ -20,6 +20,7 @@
     along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
+#include <iterator>
 #include <memory>
 #include <string>
 
@@ -30,6 +31,7 @@
 
 #include "../include/json/json.hpp"
 #include "mocks/mock_BaseHttpHandler.h"
+#include "../include/FilteringJsonSax.h"
 #include "../include/HueException.h"
 
 TEST(BaseHttpHandler, sendGetHTTPBody)
@@ -46,6 +48,23 @@ TEST(BaseHttpHandler, sendGetHTTPBody)
     EXPECT_EQ("testreply", handler.sendGetHTTPBody("testmsg", "192.168.2.1", 90));
 }
 
+TEST(BaseHttpHandler, sendGetHTTPBodyStream)
+{
+    using namespace ::testing;
+    MockBaseHttpHandler handler;
+
+    EXPECT_CALL(handler, send("testmsg", "192.168.2.1", 90))
+        .Times(AtLeast(2))
+        .WillOnce(Return(""))
+        .WillRepeatedly(Return("Header: 1\r\n\r\ntestreply"));
+
+    std::string body;
+    auto onBody = [&](std::istream& stream) { body.assign(std::istreambuf_iterator<char>(stream), {}); };
+    EXPECT_THROW(handler.sendGetHTTPBody("testmsg", onBody, "192.168.2.1", 90), HueException);
+    handler.sendGetHTTPBody("testmsg", onBody, "192.168.2.1", 90);
+    EXPECT_EQ("testreply", body);
+}
+
 TEST(BaseHttpHandler, sendHTTPRequest)
 {
     using namespace ::testing;
@@ -157,6 +176,45 @@ TEST(BaseHttpHandler, GETJson)
     EXPECT_EQ(expected, handler.GETJson("UrI", testval, "192.168.2.1", 90));
 }
 
+TEST(BaseHttpHandler, GETJsonSax)
+{
+    using namespace ::testing;
+    MockBaseHttpHandler handler;
+
+    nlohmann::json testval;
+    testval["test"] = 100;
+    std::string expected_call = "GET UrI HTTP/1.0\r\nContent-Type: application/json\r\nContent-Length: ";
+    expected_call.append(std::to_string(testval.dump().size()));
+    expected_call.append("\r\n\r\n");
+    expected_call.append(testval.dump());
+    expected_call.append("\r\n\r\n");
+
+    EXPECT_CALL(handler, send(expected_call, "192.168.2.1", 90))
+        .Times(AtLeast(2))
+        .WillOnce(Return(""))
+        .WillOnce(Return("\r\n\r\n{\"test\" : "))
+        .WillRepeatedly(Return("\r\n\r\n{\"test\" : \"whatever\"}"));
+    nlohmann::json expected;
+    expected["test"] = "whatever";
+
+    {
+        // Empty path keeps the whole document
+        FilteringJsonSax sax({""});
+        EXPECT_THROW(handler.GETJsonSax("UrI", testval, sax, "192.168.2.1", 90), HueException);
+    }
+    {
+        // Empty path keeps the whole document
+        FilteringJsonSax sax({""});
+        EXPECT_THROW(handler.GETJsonSax("UrI", testval, sax, "192.168.2.1", 90), nlohmann::json::parse_error);
+    }
+    {
+        // Empty path keeps the whole document
+        FilteringJsonSax sax({""});
+        EXPECT_TRUE(handler.GETJsonSax("UrI", testval, sax, "192.168.2.1", 90));
+        EXPECT_EQ(expected, sax.getResult());
+    }
+}
+
 TEST(BaseHttpHandler, POSTJson)
 {
     using namespace ::testing;
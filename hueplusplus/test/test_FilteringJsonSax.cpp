@@ -0,0 +1,82 @@
+/**
+    \file test_FilteringJsonSax.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/FilteringJsonSax.h"
+#include "../include/json/json.hpp"
+
+namespace
+{
+    nlohmann::json Filter(const std::string& document, const std::vector<std::string>& paths)
+    {
+        FilteringJsonSax sax(paths);
+        EXPECT_TRUE(nlohmann::json::sax_parse(document, &sax));
+        return sax.takeResult();
+    }
+} // namespace
+
+TEST(FilteringJsonSax, wholeDocument)
+{
+    const nlohmann::json document = {{"a", {1, 2, {{"b", nullptr}}}}, {"c", 1.5}, {"d", "text"}, {"e", -3}};
+    EXPECT_EQ(document, Filter(document.dump(), {""}));
+}
+
+TEST(FilteringJsonSax, lightStates)
+{
+    const nlohmann::json state1 = {{"on", true}, {"bri", 254}, {"xy", {0.1, 0.2}}};
+    const nlohmann::json state2 = {{"on", false}, {"bri", 1}, {"xy", {0.3, 0.4}}};
+    const nlohmann::json document = {
+        {"lights",
+            {{"1", {{"state", state1}, {"name", "Light 1"}, {"capabilities", {"state/unused"}}}},
+                {"2", {{"name", "Light 2"}, {"state", state2}}}, {"3", {"name/No state"}}}},
+        {"groups", {{"1", {{"state", {{"all_on", true}}}}}}}, {"config", {"name/Bridge"}}};
+
+    const nlohmann::json expected = {{"lights", {{"1", {{"state", state1}}}, {"2", {{"state", state2}}}}}};
+    EXPECT_EQ(expected, Filter(document.dump(), {"lights/*/state"}));
+}
+
+TEST(FilteringJsonSax, multiplePaths)
+{
+    const nlohmann::json document = {{"lights", {{"1", {{"name", "Light 1"}, {"type", "Color light"}}}}},
+        {"config", {{"name", "Bridge"}, {"whitelist", {{"user", {"name/app"}}}}}}};
+
+    const nlohmann::json expected = {{"lights", {{"1", {{"name", "Light 1"}}}}}, {"config", {{"name", "Bridge"}}}};
+    EXPECT_EQ(expected, Filter(document.dump(), {"lights/*/name", "config/name"}));
+}
+
+TEST(FilteringJsonSax, skipsArrays)
+{
+    const nlohmann::json document = {{"list", {{{"a", 1}}, {{"a", 2}}}}, {"value", {1, 2}}};
+
+    EXPECT_EQ(nullptr, Filter(document.dump(), {"list/*/a"}));
+    EXPECT_EQ(nlohmann::json({{"value", {1, 2}}}), Filter(document.dump(), {"value"}));
+    EXPECT_EQ(nullptr, Filter("[1, 2, 3]", {"value"}));
+}
+
+TEST(FilteringJsonSax, parseError)
+{
+    FilteringJsonSax sax({"a"});
+    EXPECT_THROW(nlohmann::json::sax_parse("{\"a\": [1, 2}", &sax), nlohmann::json::parse_error);
+}
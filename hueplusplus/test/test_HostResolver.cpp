@@ -0,0 +1,93 @@
+/**
+    \file test_HostResolver.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <gtest/gtest.h>
+
+#include "../include/HostResolver.h"
+
+TEST(HostResolver, parseNumeric)
+{
+    HostResolver::Address address;
+
+    ASSERT_TRUE(HostResolver::parseNumeric("192.168.2.116", 90, address));
+    EXPECT_EQ(AF_INET, address.family());
+    EXPECT_EQ(sizeof(sockaddr_in), address.length);
+    const sockaddr_in& v4 = reinterpret_cast<const sockaddr_in&>(address.address);
+    EXPECT_EQ(htons(90), v4.sin_port);
+    char buffer[INET6_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &v4.sin_addr, buffer, sizeof(buffer));
+    EXPECT_EQ(std::string("192.168.2.116"), buffer);
+
+    ASSERT_TRUE(HostResolver::parseNumeric("fe80::1", 80, address));
+    EXPECT_EQ(AF_INET6, address.family());
+    EXPECT_EQ(sizeof(sockaddr_in6), address.length);
+    const sockaddr_in6& v6 = reinterpret_cast<const sockaddr_in6&>(address.address);
+    EXPECT_EQ(htons(80), v6.sin6_port);
+    inet_ntop(AF_INET6, &v6.sin6_addr, buffer, sizeof(buffer));
+    EXPECT_EQ(std::string("fe80::1"), buffer);
+
+    ASSERT_TRUE(HostResolver::parseNumeric("[::1]", 80, address));
+    EXPECT_EQ(AF_INET6, address.family());
+
+    EXPECT_FALSE(HostResolver::parseNumeric("localhost", 80, address));
+    EXPECT_FALSE(HostResolver::parseNumeric("192.168.2", 80, address));
+    EXPECT_FALSE(HostResolver::parseNumeric("", 80, address));
+}
+
+TEST(HostResolver, resolve)
+{
+    HostResolver resolver;
+
+    std::vector<HostResolver::Address> numeric = resolver.resolve("192.168.2.116", 80);
+    ASSERT_EQ(1u, numeric.size());
+    EXPECT_EQ(AF_INET, numeric[0].family());
+
+    // localhost is resolved from the hosts file, so this works without network
+    std::vector<HostResolver::Address> first = resolver.resolve("localhost", 90);
+    ASSERT_FALSE(first.empty());
+    for (const HostResolver::Address& address : first)
+    {
+        if (address.family() == AF_INET)
+        {
+            EXPECT_EQ(htons(90), reinterpret_cast<const sockaddr_in&>(address.address).sin_port);
+        }
+        else
+        {
+            ASSERT_EQ(AF_INET6, address.family());
+            EXPECT_EQ(htons(90), reinterpret_cast<const sockaddr_in6&>(address.address).sin6_port);
+        }
+    }
+    // Cached result uses the new port
+    std::vector<HostResolver::Address> second = resolver.resolve("localhost", 91);
+    ASSERT_EQ(first.size(), second.size());
+    EXPECT_EQ(first[0].family(), second[0].family());
+    if (second[0].family() == AF_INET)
+    {
+        EXPECT_EQ(htons(91), reinterpret_cast<const sockaddr_in&>(second[0].address).sin_port);
+    }
+
+    resolver.clear();
+    EXPECT_FALSE(resolver.resolve("localhost", 80).empty());
+}
@@ -0,0 +1,132 @@
+/**
+    \file test_HttpRequestWriter.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/HttpRequestWriter.h"
+
+TEST(HttpRequestWriter, str)
+{
+    const std::string method = "PUT";
+    const std::string uri = "/api/user/lights/1/state";
+    const std::string contentType = "application/json";
+    const std::string body = "{\"on\":true}";
+    const std::string adr = "192.168.2.1";
+
+    HttpRequestWriter request(method, uri, contentType, body, adr, 80, true);
+    const std::string expected = "PUT /api/user/lights/1/state HTTP/1.1\r\n"
+                                 "Host: 192.168.2.1\r\n"
+                                 "Connection: keep-alive\r\n"
+                                 "Content-Type: application/json\r\n"
+                                 "Content-Length: 11\r\n\r\n"
+                                 "{\"on\":true}";
+    EXPECT_EQ(expected, request.str());
+    EXPECT_EQ(expected.size(), request.getSize());
+    EXPECT_FALSE(request.isHeadRequest());
+    // The body is not copied
+    EXPECT_EQ(body.data(), request.getBuffers()[request.getBufferCount() - 1].data);
+
+    std::ostringstream stream;
+    stream << request;
+    EXPECT_EQ(expected, stream.str());
+}
+
+TEST(HttpRequestWriter, portAndEmptyBody)
+{
+    const std::string method = "HEAD";
+    const std::string uri = "/";
+    const std::string contentType = "text/html";
+    const std::string body;
+    const std::string adr = "localhost";
+
+    HttpRequestWriter request(method, uri, contentType, body, adr, 12345, true);
+    EXPECT_EQ("HEAD / HTTP/1.1\r\n"
+              "Host: localhost:12345\r\n"
+              "Connection: keep-alive\r\n"
+              "Content-Type: text/html\r\n"
+              "Content-Length: 0\r\n\r\n",
+        request.str());
+    EXPECT_TRUE(request.isHeadRequest());
+    for (std::size_t i = 0; i < request.getBufferCount(); ++i)
+    {
+        EXPECT_NE(0, request.getBuffers()[i].size);
+    }
+}
+
+TEST(HttpRequestWriter, ipv6Host)
+{
+    const std::string method = "GET";
+    const std::string uri = "/api/user";
+    const std::string contentType = "application/json";
+    const std::string body = "{}";
+    const std::string adr = "::1";
+    const std::string linkLocalAdr = "fe80::1";
+    const std::string bracketedAdr = "[::1]";
+
+    HttpRequestWriter request(method, uri, contentType, body, adr, 8080, true);
+    EXPECT_EQ("GET /api/user HTTP/1.1\r\n"
+              "Host: [::1]:8080\r\n"
+              "Connection: keep-alive\r\n"
+              "Content-Type: application/json\r\n"
+              "Content-Length: 2\r\n\r\n"
+              "{}",
+        request.str());
+
+    HttpRequestWriter defaultPort(method, uri, contentType, body, linkLocalAdr, 80, true);
+    EXPECT_EQ("GET /api/user HTTP/1.1\r\n"
+              "Host: [fe80::1]\r\n"
+              "Connection: keep-alive\r\n"
+              "Content-Type: application/json\r\n"
+              "Content-Length: 2\r\n\r\n"
+              "{}",
+        defaultPort.str());
+
+    // Brackets are not added twice
+    HttpRequestWriter bracketed(method, uri, contentType, body, bracketedAdr, 8080, true);
+    EXPECT_EQ("GET /api/user HTTP/1.1\r\n"
+              "Host: [::1]:8080\r\n"
+              "Connection: keep-alive\r\n"
+              "Content-Type: application/json\r\n"
+              "Content-Length: 2\r\n\r\n"
+              "{}",
+        bracketed.str());
+}
+
+TEST(HttpRequestWriter, closeConnection)
+{
+    const std::string method = "PUT";
+    const std::string uri = "/api/user/lights/1/state";
+    const std::string contentType = "application/json";
+    const std::string body = "{\"on\":true}";
+    const std::string adr = "192.168.2.1";
+
+    // Requests that close the connection are sent as HTTP/1.0, so the response is not chunked
+    HttpRequestWriter request(method, uri, contentType, body, adr, 8080, false);
+    EXPECT_EQ("PUT /api/user/lights/1/state HTTP/1.0\r\n"
+              "Content-Type: application/json\r\n"
+              "Content-Length: 11\r\n\r\n"
+              "{\"on\":true}\r\n\r\n",
+        request.str());
+}
@@ -0,0 +1,166 @@
+/**
+    \file test_HttpResponseParser.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/HttpResponseParser.h"
+
+namespace
+{
+    std::size_t Feed(HttpResponseParser& parser, const std::string& data)
+    {
+        return parser.feed(data.data(), data.size());
+    }
+} // namespace
+
+TEST(HttpResponseParser, contentLength)
+{
+    const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nHello";
+    HttpResponseParser parser;
+    EXPECT_EQ(response.size(), Feed(parser, response));
+    EXPECT_TRUE(parser.isComplete());
+    EXPECT_TRUE(parser.isKeepAlive());
+    EXPECT_EQ(200, parser.getStatus());
+    EXPECT_EQ(response.size() - 5, parser.getBodyStart());
+    EXPECT_EQ(response, parser.getResponse());
+    EXPECT_EQ(response, parser.takeResponse());
+}
+
+TEST(HttpResponseParser, byteByByte)
+{
+    const std::string response = "HTTP/1.1 200 OK\r\ncontent-length: 11\r\n\r\n{\"a\": true}";
+    HttpResponseParser parser;
+    for (std::size_t i = 0; i < response.size(); ++i)
+    {
+        EXPECT_FALSE(parser.isComplete());
+        EXPECT_EQ(1, parser.feed(response.data() + i, 1));
+    }
+    EXPECT_TRUE(parser.isComplete());
+    EXPECT_EQ(response, parser.getResponse());
+}
+
+TEST(HttpResponseParser, trailingData)
+{
+    const std::string first = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n[]";
+    const std::string second = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    HttpResponseParser parser;
+    EXPECT_EQ(first.size(), Feed(parser, first + second));
+    EXPECT_TRUE(parser.isComplete());
+    EXPECT_EQ(first, parser.getResponse());
+
+    parser.reset();
+    EXPECT_FALSE(parser.isComplete());
+    EXPECT_EQ(second.size(), Feed(parser, second));
+    EXPECT_TRUE(parser.isComplete());
+    EXPECT_EQ(second, parser.getResponse());
+}
+
+TEST(HttpResponseParser, connectionHeader)
+{
+    {
+        HttpResponseParser parser;
+        Feed(parser, "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+        EXPECT_TRUE(parser.isComplete());
+        EXPECT_FALSE(parser.isKeepAlive());
+    }
+    {
+        HttpResponseParser parser;
+        Feed(parser, "HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n");
+        EXPECT_TRUE(parser.isComplete());
+        EXPECT_FALSE(parser.isKeepAlive());
+    }
+    {
+        HttpResponseParser parser;
+        Feed(parser, "HTTP/1.0 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 0\r\n\r\n");
+        EXPECT_TRUE(parser.isComplete());
+        EXPECT_TRUE(parser.isKeepAlive());
+    }
+}
+
+TEST(HttpResponseParser, chunked)
+{
+    const std::string headers = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+    const std::string response = headers + "5;name=value\r\nHello\r\n1\r\n \r\n5\r\nWorld\r\n0\r\nX-Trailer: a\r\n\r\n";
+    HttpResponseParser parser;
+    EXPECT_EQ(response.size(), Feed(parser, response));
+    EXPECT_TRUE(parser.isComplete());
+    EXPECT_TRUE(parser.isKeepAlive());
+    EXPECT_EQ(headers + "Hello World", parser.getResponse());
+
+    parser.reset();
+    for (std::size_t i = 0; i < response.size(); ++i)
+    {
+        EXPECT_FALSE(parser.isComplete());
+        EXPECT_EQ(1, parser.feed(response.data() + i, 1));
+    }
+    EXPECT_TRUE(parser.isComplete());
+    EXPECT_EQ(headers + "Hello World", parser.getResponse());
+}
+
+TEST(HttpResponseParser, noBody)
+{
+    {
+        HttpResponseParser parser(true);
+        const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n";
+        EXPECT_EQ(response.size(), Feed(parser, response));
+        EXPECT_TRUE(parser.isComplete());
+        EXPECT_TRUE(parser.isKeepAlive());
+    }
+    {
+        HttpResponseParser parser;
+        const std::string response = "HTTP/1.1 204 No Content\r\n\r\n";
+        EXPECT_EQ(response.size(), Feed(parser, response + "HTTP/1.1"));
+        EXPECT_TRUE(parser.isComplete());
+        EXPECT_EQ(204, parser.getStatus());
+    }
+}
+
+TEST(HttpResponseParser, untilClose)
+{
+    HttpResponseParser parser;
+    Feed(parser, "HTTP/1.1 200 OK\r\n\r\nabc");
+    Feed(parser, "def");
+    EXPECT_FALSE(parser.isComplete());
+    EXPECT_TRUE(parser.finish());
+    EXPECT_TRUE(parser.isComplete());
+    EXPECT_FALSE(parser.isKeepAlive());
+    EXPECT_EQ("HTTP/1.1 200 OK\r\n\r\nabcdef", parser.getResponse());
+}
+
+TEST(HttpResponseParser, finish)
+{
+    {
+        HttpResponseParser parser;
+        EXPECT_FALSE(parser.finish());
+    }
+    {
+        // Truncated response
+        HttpResponseParser parser;
+        Feed(parser, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc");
+        EXPECT_TRUE(parser.finish());
+        EXPECT_TRUE(parser.isComplete());
+        EXPECT_FALSE(parser.isKeepAlive());
+        EXPECT_EQ("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc", parser.getResponse());
+    }
+}
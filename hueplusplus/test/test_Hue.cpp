@@ -1,523 +1,895 @@
-/**
-    \file test_Hue.cpp
-    Copyright Notice\n
-    Copyright (C) 2017  Jan Rogall		- developer\n
-    Copyright (C) 2017  Moritz Wirger	- developer\n
-
-    This file is part of hueplusplus.
-
-    hueplusplus is free software: you can redistribute it and/or modify
-    it under the terms of the GNU Lesser General Public License as published by
-    the Free Software Foundation, either version 3 of the License, or
-    (at your option) any later version.
-
-    hueplusplus is distributed in the hope that it will be useful,
-    but WITHOUT ANY WARRANTY; without even the implied warranty of
-    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
-    GNU Lesser General Public License for more details.
-
-    You should have received a copy of the GNU Lesser General Public License
-    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
-**/
-
-#include <atomic>
-#include <iostream>
-#include <memory>
-#include <string>
-
-#include <gmock/gmock.h>
-#include <gtest/gtest.h>
-
-#include "testhelper.h"
-
-#include "../include/Hue.h"
-#include "../include/json/json.hpp"
-#include "mocks/mock_HttpHandler.h"
-
-class HueFinderTest : public ::testing::Test
-{
-protected:
-    std::shared_ptr<MockHttpHandler> handler;
-
-protected:
-    HueFinderTest() : handler(std::make_shared<MockHttpHandler>())
-    {
-        using namespace ::testing;
-
-        EXPECT_CALL(*handler,
-            sendMulticast("M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: "
-                          "\"ssdp:discover\"\r\nMX: 5\r\nST: ssdp:all\r\n\r\n",
-                "239.255.255.250", 1900, 5))
-            .Times(AtLeast(1))
-            .WillRepeatedly(Return(getMulticastReply()));
-
-        EXPECT_CALL(*handler, GETString("/description.xml", "application/xml", "", "192.168.2.1", getBridgePort()))
-            .Times(0);
-
-        EXPECT_CALL(*handler, GETString("/description.xml", "application/xml", "", getBridgeIp(), getBridgePort()))
-            .Times(AtLeast(1))
-            .WillRepeatedly(Return(getBridgeXml()));
-    }
-    ~HueFinderTest(){};
-};
-
-TEST_F(HueFinderTest, FindBridges)
-{
-    HueFinder finder(handler);
-    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
-
-    HueFinder::HueIdentification bridge_to_comp;
-    bridge_to_comp.ip = getBridgeIp();
-    bridge_to_comp.port = getBridgePort();
-    bridge_to_comp.mac = getBridgeMac();
-
-    EXPECT_EQ(bridges.size(), 1) << "HueFinder found more than one Bridge";
-    EXPECT_EQ(bridges[0].ip, bridge_to_comp.ip) << "HueIdentification ip does not match";
-    EXPECT_EQ(bridges[0].port, bridge_to_comp.port) << "HueIdentification port does not match";
-    EXPECT_EQ(bridges[0].mac, bridge_to_comp.mac) << "HueIdentification mac does not match";
-
-    // Test invalid description
-    EXPECT_CALL(*handler, GETString("/description.xml", "application/xml", "", getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(::testing::Return("invalid stuff"));
-    bridges = finder.FindBridges();
-    EXPECT_TRUE(bridges.empty());
-}
-
-TEST_F(HueFinderTest, GetBridge)
-{
-    using namespace ::testing;
-    nlohmann::json request{{"devicetype", "HuePlusPlus#User"}};
-
-    nlohmann::json errorResponse
-        = {{{"error", {{"type", 101}, {"address", ""}, {"description", "link button not pressed"}}}}};
-
-    EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(errorResponse));
-
-    HueFinder finder(handler);
-    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
-
-    ASSERT_THROW(finder.GetBridge(bridges[0]), HueException);
-
-    nlohmann::json successResponse = {{{"success", {{"username", getBridgeUsername()}}}}};
-
-    EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(successResponse));
-
-    finder = HueFinder(handler);
-    bridges = finder.FindBridges();
-
-    Hue test_bridge = finder.GetBridge(bridges[0]);
-
-    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
-    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching";
-    EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
-
-    // Verify that username is correctly set in api requests
-    nlohmann::json hue_bridge_state{{"lights", {}}};
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-
-    test_bridge.getAllLights();
-
-    Mock::VerifyAndClearExpectations(handler.get());
-}
-
-TEST_F(HueFinderTest, AddUsername)
-{
-    HueFinder finder(handler);
-    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
-
-    finder.AddUsername(bridges[0].mac, getBridgeUsername());
-    Hue test_bridge = finder.GetBridge(bridges[0]);
-
-    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
-    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching";
-    EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
-}
-
-TEST_F(HueFinderTest, GetAllUsernames)
-{
-    HueFinder finder(handler);
-    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
-
-    finder.AddUsername(bridges[0].mac, getBridgeUsername());
-
-    std::map<std::string, std::string> users = finder.GetAllUsernames();
-    EXPECT_EQ(users[getBridgeMac()], getBridgeUsername()) << "Username of MAC:" << getBridgeMac() << "not matching";
-}
-
-TEST(Hue, Constructor)
-{
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
-    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching";
-    EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
-}
-
-TEST(Hue, requestUsername)
-{
-    using namespace ::testing;
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    nlohmann::json request{{"devicetype", "HuePlusPlus#User"}};
-
-    {
-        nlohmann::json errorResponse
-            = {{{"error", {{"type", 101}, {"address", ""}, {"description", "link button not pressed"}}}}};
-
-        EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
-            .Times(AtLeast(1))
-            .WillRepeatedly(Return(errorResponse));
-
-        Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler);
-
-        std::string username = test_bridge.requestUsername();
-        EXPECT_EQ(username, "") << "Returned username not matching";
-        EXPECT_EQ(test_bridge.getUsername(), "") << "Bridge username not matching";
-    }
-
-    {
-        // Other error code causes exception
-        int otherError = 1;
-        nlohmann::json exceptionResponse
-            = {{{"error", {{"type", otherError}, {"address", ""}, {"description", "some error"}}}}};
-        Hue testBridge(getBridgeIp(), getBridgePort(), "", handler);
-
-        EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
-            .WillOnce(Return(exceptionResponse));
-
-        try
-        {
-            testBridge.requestUsername();
-            FAIL() << "requestUsername did not throw";
-        }
-        catch (const HueAPIResponseException& e)
-        {
-            EXPECT_EQ(e.GetErrorNumber(), otherError);
-        }
-        catch (const std::exception& e)
-        {
-            FAIL() << "wrong exception: " << e.what();
-        }
-    }
-
-    {
-        nlohmann::json successResponse = {{{"success", {{"username", getBridgeUsername()}}}}};
-        EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
-            .Times(1)
-            .WillRepeatedly(Return(successResponse));
-
-        Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler);
-
-        std::string username = test_bridge.requestUsername();
-
-        EXPECT_EQ(username, test_bridge.getUsername()) << "Returned username not matching";
-        EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
-        EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
-
-        // Verify that username is correctly set in api requests
-        nlohmann::json hue_bridge_state{{"lights", {}}};
-        EXPECT_CALL(
-            *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-            .Times(1)
-            .WillOnce(Return(hue_bridge_state));
-
-        test_bridge.getAllLights();
-    }
-}
-
-TEST(Hue, setIP)
-{
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler);
-    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching after initialization";
-    test_bridge.setIP("192.168.2.112");
-    EXPECT_EQ(test_bridge.getBridgeIP(), "192.168.2.112") << "Bridge IP not matching after setting it";
-}
-
-TEST(Hue, setPort)
-{
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    Hue test_bridge = Hue(getBridgeIp(), getBridgePort(), "", handler);
-    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching after initialization";
-    test_bridge.setPort(81);
-    EXPECT_EQ(test_bridge.getBridgePort(), 81) << "Bridge Port not matching after setting it";
-}
-
-TEST(Hue, getLight)
-{
-    using namespace ::testing;
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1);
-
-    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    // Test exception
-    ASSERT_THROW(test_bridge.getLight(1), HueException);
-
-    nlohmann::json hue_bridge_state{{"lights",
-        {{"1",
-            {{"state",
-                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
-                     {"reachable", true}}},
-                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
-                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
-                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}}};
-
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-
-    // Test when correct data is sent
-    HueLight test_light_1 = test_bridge.getLight(1);
-    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
-    EXPECT_EQ(test_light_1.getColorType(), ColorType::TEMPERATURE);
-
-    // Test again to check whether light is returned directly -> interesting for
-    // code coverage test
-    test_light_1 = test_bridge.getLight(1);
-    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
-    EXPECT_EQ(test_light_1.getColorType(), ColorType::TEMPERATURE);
-
-    // more coverage stuff
-    hue_bridge_state["lights"]["1"]["modelid"] = "LCT001";
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    // Test when correct data is sent
-    test_light_1 = test_bridge.getLight(1);
-    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
-    EXPECT_EQ(test_light_1.getColorType(), ColorType::GAMUT_B);
-
-    hue_bridge_state["lights"]["1"]["modelid"] = "LCT010";
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    // Test when correct data is sent
-    test_light_1 = test_bridge.getLight(1);
-    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
-    EXPECT_EQ(test_light_1.getColorType(), ColorType::GAMUT_C);
-
-    hue_bridge_state["lights"]["1"]["modelid"] = "LST001";
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    // Test when correct data is sent
-    test_light_1 = test_bridge.getLight(1);
-    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
-    EXPECT_EQ(test_light_1.getColorType(), ColorType::GAMUT_A);
-
-    hue_bridge_state["lights"]["1"]["modelid"] = "LWB004";
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    // Test when correct data is sent
-    test_light_1 = test_bridge.getLight(1);
-    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
-    EXPECT_EQ(test_light_1.getColorType(), ColorType::NONE);
-
-    hue_bridge_state["lights"]["1"]["modelid"] = "ABC000";
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-    ASSERT_THROW(test_bridge.getLight(1), HueException);
-}
-
-TEST(Hue, removeLight)
-{
-    using namespace ::testing;
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    nlohmann::json hue_bridge_state{ {"lights",
-        {{"1",
-            {{"state",
-                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
-                     {"reachable", true}}},
-                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
-                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
-                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillOnce(Return(hue_bridge_state));
-
-    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(1)
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-
-    nlohmann::json return_answer;
-    return_answer = nlohmann::json::array();
-    return_answer[0] = nlohmann::json::object();
-    return_answer[0]["success"] = "/lights/1 deleted";
-    EXPECT_CALL(*handler,
-        DELETEJson(
-            "/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(2)
-        .WillOnce(Return(return_answer))
-        .WillOnce(Return(nlohmann::json()));
-
-    // Test when correct data is sent
-    HueLight test_light_1 = test_bridge.getLight(1);
-
-    EXPECT_EQ(test_bridge.removeLight(1), true);
-
-    EXPECT_EQ(test_bridge.removeLight(1), false);
-}
-
-TEST(Hue, getAllLights)
-{
-    using namespace ::testing;
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    nlohmann::json hue_bridge_state{ {"lights",
-        {{"1",
-            {{"state",
-                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
-                     {"reachable", true}}},
-                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
-                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
-                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
-
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(2)
-        .WillRepeatedly(Return(hue_bridge_state));
-
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(2)
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-
-    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    std::vector<std::reference_wrapper<HueLight>> test_lights = test_bridge.getAllLights();
-    ASSERT_EQ(1, test_lights.size());
-    EXPECT_EQ(test_lights[0].get().getName(), "Hue ambiance lamp 1");
-    EXPECT_EQ(test_lights[0].get().getColorType(), ColorType::TEMPERATURE);
-}
-
-TEST(Hue, lightExists)
-{
-    using namespace ::testing;
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    nlohmann::json hue_bridge_state{ {"lights",
-        {{"1",
-            {{"state",
-                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
-                     {"reachable", true}}},
-                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
-                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
-                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(2))
-        .WillRepeatedly(Return(hue_bridge_state));
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-
-    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    EXPECT_EQ(true, test_bridge.lightExists(1));
-    EXPECT_EQ(false, test_bridge.lightExists(2));
-
-    const Hue const_test_bridge1 = test_bridge;
-    EXPECT_EQ(true, const_test_bridge1.lightExists(1));
-    EXPECT_EQ(false, const_test_bridge1.lightExists(2));
-
-    test_bridge.getLight(1);
-    const Hue const_test_bridge2 = test_bridge;
-    EXPECT_EQ(true, test_bridge.lightExists(1));
-    EXPECT_EQ(true, const_test_bridge2.lightExists(1));
-}
-
-TEST(Hue, getPictureOfLight)
-{
-    using namespace ::testing;
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    nlohmann::json hue_bridge_state{ {"lights",
-        {{"1",
-            {{"state",
-                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
-                     {"reachable", true}}},
-                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
-                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
-                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
-
-    EXPECT_CALL(
-        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state));
-    EXPECT_CALL(*handler,
-        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
-        .Times(AtLeast(1))
-        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-
-    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
-
-    test_bridge.getLight(1);
-
-    EXPECT_EQ("", test_bridge.getPictureOfLight(2));
-
-    EXPECT_EQ("e27_waca", test_bridge.getPictureOfLight(1));
-}
-
-TEST(Hue, refreshState)
-{
-    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
-    Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler); // NULL as username leads to segfault
-
-    std::vector<std::reference_wrapper<HueLight>> test_lights = test_bridge.getAllLights();
-    EXPECT_EQ(test_lights.size(), 0);
-}
+/**
+    \file test_Hue.cpp
+    Copyright Notice\n
+    Copyright (C) 2017  Jan Rogall		- developer\n
+    Copyright (C) 2017  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "testhelper.h"
+
+#include "../include/Hue.h"
+#include "../include/json/json.hpp"
+#include "mocks/mock_HttpHandler.h"
+
+class HueFinderTest : public ::testing::Test
+{
+protected:
+    std::shared_ptr<MockHttpHandler> handler;
+
+protected:
+    HueFinderTest() : handler(std::make_shared<MockHttpHandler>())
+    {
+        using namespace ::testing;
+
+        EXPECT_CALL(*handler,
+            sendMulticast("M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: "
+                          "\"ssdp:discover\"\r\nMX: 5\r\nST: ssdp:all\r\n\r\n",
+                "239.255.255.250", 1900, 5))
+            .Times(AtLeast(1))
+            .WillRepeatedly(Return(getMulticastReply()));
+
+        EXPECT_CALL(*handler, GETString("/description.xml", "application/xml", "", "192.168.2.1", getBridgePort()))
+            .Times(0);
+
+        EXPECT_CALL(*handler, GETString("/description.xml", "application/xml", "", getBridgeIp(), getBridgePort()))
+            .Times(AtLeast(1))
+            .WillRepeatedly(Return(getBridgeXml()));
+    }
+    ~HueFinderTest(){};
+};
+
+TEST_F(HueFinderTest, FindBridges)
+{
+    HueFinder finder(handler);
+    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
+
+    HueFinder::HueIdentification bridge_to_comp;
+    bridge_to_comp.ip = getBridgeIp();
+    bridge_to_comp.port = getBridgePort();
+    bridge_to_comp.mac = getBridgeMac();
+
+    EXPECT_EQ(bridges.size(), 1) << "HueFinder found more than one Bridge";
+    EXPECT_EQ(bridges[0].ip, bridge_to_comp.ip) << "HueIdentification ip does not match";
+    EXPECT_EQ(bridges[0].port, bridge_to_comp.port) << "HueIdentification port does not match";
+    EXPECT_EQ(bridges[0].mac, bridge_to_comp.mac) << "HueIdentification mac does not match";
+
+    // Test invalid description
+    EXPECT_CALL(*handler, GETString("/description.xml", "application/xml", "", getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(::testing::Return("invalid stuff"));
+    bridges = finder.FindBridges();
+    EXPECT_TRUE(bridges.empty());
+}
+
+TEST_F(HueFinderTest, FindBridgesCallback)
+{
+    HueFinder finder(handler);
+    std::vector<HueFinder::HueIdentification> bridges;
+    finder.FindBridges([&](const HueFinder::HueIdentification& bridge) {
+        bridges.push_back(bridge);
+        return false;
+    });
+
+    ASSERT_EQ(bridges.size(), 1);
+    EXPECT_EQ(bridges[0].ip, getBridgeIp());
+    EXPECT_EQ(bridges[0].port, getBridgePort());
+    EXPECT_EQ(bridges[0].mac, getBridgeMac());
+}
+
+TEST_F(HueFinderTest, GetBridge)
+{
+    using namespace ::testing;
+    nlohmann::json request{{"devicetype", "HuePlusPlus#User"}};
+
+    nlohmann::json errorResponse
+        = {{{"error", {{"type", 101}, {"address", ""}, {"description", "link button not pressed"}}}}};
+
+    EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(errorResponse));
+
+    HueFinder finder(handler);
+    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
+
+    ASSERT_THROW(finder.GetBridge(bridges[0]), HueException);
+
+    nlohmann::json successResponse = {{{"success", {{"username", getBridgeUsername()}}}}};
+
+    EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(successResponse));
+
+    finder = HueFinder(handler);
+    bridges = finder.FindBridges();
+
+    Hue test_bridge = finder.GetBridge(bridges[0]);
+
+    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
+    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching";
+    EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
+
+    // Verify that username is correctly set in api requests
+    nlohmann::json hue_bridge_state{{"lights", {}}};
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    test_bridge.getAllLights();
+
+    Mock::VerifyAndClearExpectations(handler.get());
+}
+
+TEST_F(HueFinderTest, AddUsername)
+{
+    HueFinder finder(handler);
+    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
+
+    finder.AddUsername(bridges[0].mac, getBridgeUsername());
+    Hue test_bridge = finder.GetBridge(bridges[0]);
+
+    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
+    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching";
+    EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
+}
+
+TEST_F(HueFinderTest, GetAllUsernames)
+{
+    HueFinder finder(handler);
+    std::vector<HueFinder::HueIdentification> bridges = finder.FindBridges();
+
+    finder.AddUsername(bridges[0].mac, getBridgeUsername());
+
+    std::map<std::string, std::string> users = finder.GetAllUsernames();
+    EXPECT_EQ(users[getBridgeMac()], getBridgeUsername()) << "Username of MAC:" << getBridgeMac() << "not matching";
+}
+
+TEST(Hue, Constructor)
+{
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
+    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching";
+    EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
+}
+
+TEST(Hue, requestUsername)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json request{{"devicetype", "HuePlusPlus#User"}};
+
+    {
+        nlohmann::json errorResponse
+            = {{{"error", {{"type", 101}, {"address", ""}, {"description", "link button not pressed"}}}}};
+
+        EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
+            .Times(AtLeast(1))
+            .WillRepeatedly(Return(errorResponse));
+
+        Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler);
+
+        std::string username = test_bridge.requestUsername();
+        EXPECT_EQ(username, "") << "Returned username not matching";
+        EXPECT_EQ(test_bridge.getUsername(), "") << "Bridge username not matching";
+    }
+
+    {
+        // Other error code causes exception
+        int otherError = 1;
+        nlohmann::json exceptionResponse
+            = {{{"error", {{"type", otherError}, {"address", ""}, {"description", "some error"}}}}};
+        Hue testBridge(getBridgeIp(), getBridgePort(), "", handler);
+
+        EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
+            .WillOnce(Return(exceptionResponse));
+
+        try
+        {
+            testBridge.requestUsername();
+            FAIL() << "requestUsername did not throw";
+        }
+        catch (const HueAPIResponseException& e)
+        {
+            EXPECT_EQ(e.GetErrorNumber(), otherError);
+        }
+        catch (const std::exception& e)
+        {
+            FAIL() << "wrong exception: " << e.what();
+        }
+    }
+
+    {
+        nlohmann::json successResponse = {{{"success", {{"username", getBridgeUsername()}}}}};
+        EXPECT_CALL(*handler, POSTJson("/api", request, getBridgeIp(), getBridgePort()))
+            .Times(1)
+            .WillRepeatedly(Return(successResponse));
+
+        Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler);
+
+        std::string username = test_bridge.requestUsername();
+
+        EXPECT_EQ(username, test_bridge.getUsername()) << "Returned username not matching";
+        EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching";
+        EXPECT_EQ(test_bridge.getUsername(), getBridgeUsername()) << "Bridge username not matching";
+
+        // Verify that username is correctly set in api requests
+        nlohmann::json hue_bridge_state{{"lights", {}}};
+        EXPECT_CALL(
+            *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+            .Times(1)
+            .WillOnce(Return(hue_bridge_state));
+
+        test_bridge.getAllLights();
+    }
+}
+
+TEST(Hue, setIP)
+{
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler);
+    EXPECT_EQ(test_bridge.getBridgeIP(), getBridgeIp()) << "Bridge IP not matching after initialization";
+    test_bridge.setIP("192.168.2.112");
+    EXPECT_EQ(test_bridge.getBridgeIP(), "192.168.2.112") << "Bridge IP not matching after setting it";
+}
+
+TEST(Hue, setPort)
+{
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    Hue test_bridge = Hue(getBridgeIp(), getBridgePort(), "", handler);
+    EXPECT_EQ(test_bridge.getBridgePort(), getBridgePort()) << "Bridge Port not matching after initialization";
+    test_bridge.setPort(81);
+    EXPECT_EQ(test_bridge.getBridgePort(), 81) << "Bridge Port not matching after setting it";
+}
+
+TEST(Hue, getLight)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1);
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    // Test exception
+    ASSERT_THROW(test_bridge.getLight(1), HueException);
+
+    nlohmann::json hue_bridge_state{{"lights",
+        {{"1",
+            {{"state",
+                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                     {"reachable", true}}},
+                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
+                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
+                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}}};
+
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
+
+    // Test when correct data is sent
+    HueLight test_light_1 = test_bridge.getLight(1);
+    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
+    EXPECT_EQ(test_light_1.getColorType(), ColorType::TEMPERATURE);
+
+    // Test again to check whether light is returned directly -> interesting for
+    // code coverage test
+    test_light_1 = test_bridge.getLight(1);
+    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
+    EXPECT_EQ(test_light_1.getColorType(), ColorType::TEMPERATURE);
+
+    // more coverage stuff
+    hue_bridge_state["lights"]["1"]["modelid"] = "LCT001";
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
+    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    // Test when correct data is sent
+    test_light_1 = test_bridge.getLight(1);
+    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
+    EXPECT_EQ(test_light_1.getColorType(), ColorType::GAMUT_B);
+
+    hue_bridge_state["lights"]["1"]["modelid"] = "LCT010";
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
+    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    // Test when correct data is sent
+    test_light_1 = test_bridge.getLight(1);
+    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
+    EXPECT_EQ(test_light_1.getColorType(), ColorType::GAMUT_C);
+
+    hue_bridge_state["lights"]["1"]["modelid"] = "LST001";
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
+    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    // Test when correct data is sent
+    test_light_1 = test_bridge.getLight(1);
+    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
+    EXPECT_EQ(test_light_1.getColorType(), ColorType::GAMUT_A);
+
+    hue_bridge_state["lights"]["1"]["modelid"] = "LWB004";
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
+    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    // Test when correct data is sent
+    test_light_1 = test_bridge.getLight(1);
+    EXPECT_EQ(test_light_1.getName(), "Hue ambiance lamp 1");
+    EXPECT_EQ(test_light_1.getColorType(), ColorType::NONE);
+
+    hue_bridge_state["lights"]["1"]["modelid"] = "ABC000";
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+    test_bridge = Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    ASSERT_THROW(test_bridge.getLight(1), HueException);
+}
+
+TEST(Hue, removeLight)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json hue_bridge_state{ {"lights",
+        {{"1",
+            {{"state",
+                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                     {"reachable", true}}},
+                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
+                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
+                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(0);
+
+    nlohmann::json return_answer;
+    return_answer = nlohmann::json::array();
+    return_answer[0] = nlohmann::json::object();
+    return_answer[0]["success"] = "/lights/1 deleted";
+    EXPECT_CALL(*handler,
+        DELETEJson(
+            "/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(2)
+        .WillOnce(Return(return_answer))
+        .WillOnce(Return(nlohmann::json()));
+
+    // Test when correct data is sent
+    HueLight test_light_1 = test_bridge.getLight(1);
+    std::shared_ptr<const HueLight> found = test_bridge.findLight(1);
+    ASSERT_NE(nullptr, found);
+    // Copies of the bridge have their own lights
+    const Hue copy = test_bridge;
+    EXPECT_NE(found, copy.findLight(1));
+
+    EXPECT_EQ(test_bridge.removeLight(1), true);
+    EXPECT_EQ(nullptr, test_bridge.findLight(1));
+    EXPECT_NE(nullptr, copy.findLight(1));
+    // The removed light can still be read
+    EXPECT_TRUE(found->isOn());
+
+    EXPECT_EQ(test_bridge.removeLight(1), false);
+}
+
+TEST(Hue, getAllLights)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json hue_bridge_state{ {"lights",
+        {{"1",
+            {{"state",
+                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                     {"reachable", true}}},
+                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
+                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
+                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
+
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillRepeatedly(Return(hue_bridge_state));
+
+    // Only getName refreshes the light, getAllLights uses the state of the bridge
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    std::vector<std::reference_wrapper<HueLight>> test_lights = test_bridge.getAllLights();
+    ASSERT_EQ(1, test_lights.size());
+    EXPECT_EQ(test_lights[0].get().getName(), "Hue ambiance lamp 1");
+    EXPECT_EQ(test_lights[0].get().getColorType(), ColorType::TEMPERATURE);
+}
+
+TEST(Hue, refreshAllLights)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json light_state{{"state",
+                                   {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                                       {"reachable", true}}},
+        {"type", "Color temperature light"}, {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"},
+        {"manufacturername", "Philips"}, {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}};
+    nlohmann::json hue_bridge_state{{"lights", {{"1", light_state}, {"2", light_state}}}};
+    hue_bridge_state["lights"]["2"]["modelid"] = "LCT001";
+    hue_bridge_state["lights"]["2"]["name"] = "Hue lamp 2";
+    nlohmann::json changed_state = hue_bridge_state;
+    changed_state["lights"]["1"]["state"]["on"] = false;
+    changed_state["lights"]["2"]["name"] = "Hue lamp 2 renamed";
+    changed_state["lights"]["3"] = light_state;
+
+    // No requests for single lights
+    EXPECT_CALL(*handler, GETJson(Ne("/api/" + getBridgeUsername()), _, _, _)).Times(0);
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(4)
+        .WillOnce(Return(hue_bridge_state))
+        .WillRepeatedly(ReturnPointee(&changed_state));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    std::vector<std::reference_wrapper<HueLight>> test_lights = test_bridge.getAllLights();
+    ASSERT_EQ(2, test_lights.size());
+    const HueLight& light1 = test_lights[0].get();
+    const HueLight& light2 = test_lights[1].get();
+    EXPECT_TRUE(light1.isOn());
+    EXPECT_EQ(ColorType::TEMPERATURE, light1.getColorType());
+    EXPECT_EQ("Hue lamp 2", light2.getName());
+    EXPECT_EQ(ColorType::GAMUT_B, light2.getColorType());
+
+    test_bridge.refreshAllLights();
+    // Existing lights are updated in place
+    EXPECT_FALSE(light1.isOn());
+    EXPECT_EQ("Hue lamp 2 renamed", light2.getName());
+    // New lights are added
+    test_lights = test_bridge.getAllLights();
+    ASSERT_EQ(3, test_lights.size());
+    EXPECT_EQ(&light1, &test_lights[0].get());
+    EXPECT_EQ(3, test_lights[2].get().getId());
+
+    // Deleted lights are removed
+    changed_state["lights"].erase("2");
+    test_lights = test_bridge.getAllLights();
+    ASSERT_EQ(2, test_lights.size());
+    EXPECT_EQ(1, test_lights[0].get().getId());
+    EXPECT_EQ(3, test_lights[1].get().getId());
+}
+
+TEST(Hue, setStateMaxAge)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json light_state{{"state",
+                                   {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                                       {"reachable", true}}},
+        {"type", "Color temperature light"}, {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"},
+        {"manufacturername", "Philips"}, {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}};
+    nlohmann::json hue_bridge_state{{"lights", {{"1", light_state}}}};
+    const std::string light_path = "/api/" + getBridgeUsername() + "/lights/1";
+
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    EXPECT_EQ(std::chrono::milliseconds(0), test_bridge.getStateMaxAge());
+    test_bridge.setStateMaxAge(std::chrono::hours(1));
+    EXPECT_EQ(std::chrono::hours(1), test_bridge.getStateMaxAge());
+
+    HueLight& light = test_bridge.getLight(1);
+    EXPECT_EQ(std::chrono::hours(1), light.getStateMaxAge());
+    Mock::VerifyAndClearExpectations(handler.get());
+
+    // Cached state is used for the unchanged values
+    EXPECT_CALL(*handler, GETJson(light_path, _, _, _)).Times(0);
+    EXPECT_CALL(*handler, PUTJson(_, _, _, _)).Times(0);
+    EXPECT_TRUE(light.On());
+    EXPECT_TRUE(light.setBrightness(254));
+    EXPECT_EQ("Hue ambiance lamp 1", light.getName());
+    Mock::VerifyAndClearExpectations(handler.get());
+
+    // Values confirmed by the reply are written to the cached state
+    nlohmann::json off_reply{{{"success", {{"/lights/1/state/on", false}}}}};
+    EXPECT_CALL(*handler, GETJson(light_path, _, _, _)).Times(0);
+    EXPECT_CALL(*handler, PUTJson(light_path + "/state", _, getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(off_reply));
+    EXPECT_TRUE(light.Off());
+    EXPECT_FALSE(light.isOn());
+    EXPECT_TRUE(light.Off());
+    Mock::VerifyAndClearExpectations(handler.get());
+    light_state["state"]["on"] = false;
+
+    // Failed requests leave the cached state outdated
+    EXPECT_CALL(*handler, PUTJson(light_path + "/state", _, getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Throw(std::system_error(std::make_error_code(std::errc::connection_refused))));
+    EXPECT_THROW(light.On(), std::system_error);
+    EXPECT_CALL(*handler, GETJson(light_path, nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(light_state));
+    EXPECT_FALSE(light.isOn());
+    EXPECT_FALSE(light.isOn());
+    Mock::VerifyAndClearExpectations(handler.get());
+
+    // Never refresh implicitly
+    light.setStateMaxAge(std::chrono::milliseconds::max());
+    EXPECT_EQ(std::chrono::hours(1), test_bridge.getStateMaxAge());
+    EXPECT_CALL(*handler, GETJson(light_path, _, _, _)).Times(0);
+    EXPECT_CALL(*handler, PUTJson(light_path + "/state", _, getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(nlohmann::json{{{"success", {{"/lights/1/state/on", true}}}}}));
+    EXPECT_TRUE(light.On());
+    EXPECT_EQ("Hue ambiance lamp 1", light.getName());
+    Mock::VerifyAndClearExpectations(handler.get());
+
+    // Refresh every time
+    test_bridge.setStateMaxAge(std::chrono::milliseconds(0));
+    EXPECT_EQ(std::chrono::milliseconds(0), light.getStateMaxAge());
+    EXPECT_CALL(*handler, GETJson(light_path, nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(2)
+        .WillRepeatedly(Return(light_state));
+    EXPECT_FALSE(light.isOn());
+    EXPECT_FALSE(light.isOn());
+}
+
+TEST(Hue, setStateMaxAgeAfterPut)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json light_state{{"state",
+                                   {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                                       {"reachable", true}}},
+        {"type", "Color temperature light"}, {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"},
+        {"manufacturername", "Philips"}, {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}};
+    nlohmann::json hue_bridge_state{{"lights", {{"1", light_state}}}};
+    const std::string light_path = "/api/" + getBridgeUsername() + "/lights/1";
+
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    HueLight& light = test_bridge.getLight(1);
+    Mock::VerifyAndClearExpectations(handler.get());
+
+    // A failed request refreshes the state even if it never expires
+    light.setStateMaxAge(std::chrono::milliseconds::max());
+    EXPECT_CALL(*handler, PUTJson(light_path + "/state", _, getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Throw(std::system_error(std::make_error_code(std::errc::connection_refused))));
+    EXPECT_THROW(light.Off(), std::system_error);
+    EXPECT_CALL(*handler, GETJson(light_path, nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(light_state));
+    EXPECT_TRUE(light.isOn());
+    EXPECT_TRUE(light.isOn());
+    Mock::VerifyAndClearExpectations(handler.get());
+
+    // Values confirmed by the reply are as old as the reply
+    light.setStateMaxAge(std::chrono::milliseconds(1000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    EXPECT_CALL(*handler, GETJson(light_path, _, _, _)).Times(0);
+    EXPECT_CALL(*handler, PUTJson(light_path + "/state", _, getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(nlohmann::json{{{"success", {{"/lights/1/state/on", false}}}}}));
+    EXPECT_TRUE(light.Off());
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_FALSE(light.isOn());
+}
+
+TEST(Hue, startPolling)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json light_state{{"state",
+                                   {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                                       {"reachable", true}}},
+        {"type", "Color temperature light"}, {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"},
+        {"manufacturername", "Philips"}, {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}};
+    nlohmann::json hue_bridge_state{{"lights", {{"1", light_state}}}};
+    nlohmann::json polled_state = hue_bridge_state;
+    polled_state["lights"]["1"]["state"]["on"] = false;
+
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(hue_bridge_state));
+    EXPECT_CALL(*handler, GETJson("/api/" + getBridgeUsername() + "/lights/1", _, _, _)).Times(0);
+    EXPECT_CALL(*handler,
+        GETJsonSax("/api/" + getBridgeUsername(), nlohmann::json::object(), _, getBridgeIp(), getBridgePort()))
+        .WillRepeatedly(Invoke([&](const std::string&, const nlohmann::json&, nlohmann::json::json_sax_t& sax,
+                                   const std::string&,
+                                   int) { return nlohmann::json::sax_parse(polled_state.dump(), &sax); }));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    EXPECT_EQ(nullptr, test_bridge.getPoller());
+    test_bridge.setStateMaxAge(std::chrono::milliseconds::max());
+    HueLight& light = test_bridge.getLight(1);
+    EXPECT_TRUE(light.isOn());
+
+    StatePoller& poller = test_bridge.startPolling(std::chrono::milliseconds(5));
+    EXPECT_EQ(&poller, test_bridge.getPoller());
+    EXPECT_EQ(&poller, &test_bridge.startPolling(std::chrono::milliseconds(10)));
+    EXPECT_EQ(std::chrono::milliseconds(10), poller.getInterval());
+    const std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (poller.getUpdateTime() == std::chrono::steady_clock::time_point()
+        && std::chrono::steady_clock::now() < timeout)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // The light uses the polled state instead of its own request
+    EXPECT_FALSE(light.isOn());
+
+    test_bridge.stopPolling();
+    EXPECT_EQ(nullptr, test_bridge.getPoller());
+    EXPECT_FALSE(light.isOn());
+}
+
+TEST(Hue, startPollingPublishesState)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json light_state{{"state", {{"on", true}, {"bri", 254}, {"colormode", "ct"}, {"reachable", true}}},
+        {"type", "Dimmable light"}, {"name", "Hue lamp 1"}, {"modelid", "LWB010"}};
+    nlohmann::json on_state{{"lights", {{"1", light_state}}}};
+    nlohmann::json off_state = on_state;
+    off_state["lights"]["1"]["state"]["on"] = false;
+    std::promise<void> subscribed;
+    std::shared_future<void> ready = subscribed.get_future().share();
+    auto respond = [](const nlohmann::json& state) {
+        return [state](const std::string&, const nlohmann::json&, nlohmann::json::json_sax_t& sax, const std::string&,
+                   int) { return nlohmann::json::sax_parse(state.dump(), &sax); };
+    };
+
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(1)
+        .WillOnce(Return(on_state));
+    EXPECT_CALL(*handler, GETJson("/api/" + getBridgeUsername() + "/lights/1", _, _, _)).Times(0);
+    // The light is switched off after the subscribers were added
+    EXPECT_CALL(*handler,
+        GETJsonSax("/api/" + getBridgeUsername(), nlohmann::json::object(), _, getBridgeIp(), getBridgePort()))
+        .WillOnce(Invoke(respond(on_state)))
+        .WillRepeatedly(DoAll(InvokeWithoutArgs([ready] { ready.wait(); }), Invoke(respond(off_state))));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    test_bridge.setStateMaxAge(std::chrono::milliseconds::max());
+    const HueLight& light = test_bridge.getLight(1);
+    StatePoller& poller = test_bridge.startPolling(std::chrono::milliseconds(5));
+    // Copies apply polled states to their own lights
+    const Hue copy = test_bridge;
+    std::shared_ptr<const HueLight> copied_light = copy.findLight(1);
+    ASSERT_NE(nullptr, copied_light);
+    EXPECT_NE(&light, copied_light.get());
+
+    std::atomic<bool> done{false};
+    std::promise<std::vector<bool>> notified;
+    poller.subscribe([&](const StatePoller::LightChange& change) {
+        if (change.attribute == "/state/on" && !done.exchange(true))
+        {
+            // Subscribers see the polled state in all snapshots
+            notified.set_value({(*light.getStateSnapshot())["state"]["on"].get<bool>(),
+                (*test_bridge.getStateSnapshot())["lights"]["1"]["state"]["on"].get<bool>(),
+                (*copied_light->getStateSnapshot())["state"]["on"].get<bool>(),
+                (*copy.getStateSnapshot())["lights"]["1"]["state"]["on"].get<bool>()});
+        }
+    });
+    subscribed.set_value();
+
+    std::future<std::vector<bool>> result = notified.get_future();
+    ASSERT_EQ(std::future_status::ready, result.wait_for(std::chrono::seconds(5)));
+    EXPECT_EQ(std::vector<bool>(4, false), result.get());
+    EXPECT_FALSE(light.isOn());
+    test_bridge.stopPolling();
+}
+
+TEST(Hue, getStateSnapshot)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json light_state{{"state", {{"on", true}, {"bri", 254}, {"colormode", "ct"}, {"reachable", true}}},
+        {"type", "Dimmable light"}, {"name", "Hue lamp 1"}, {"modelid", "LWB010"}};
+    nlohmann::json on_state{{"lights", {{"1", light_state}}}};
+    nlohmann::json off_state = on_state;
+    off_state["lights"]["1"]["state"]["on"] = false;
+    off_state["lights"]["1"]["state"]["bri"] = 1;
+
+    std::atomic<int> refreshes{0};
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .WillRepeatedly(InvokeWithoutArgs([&] { return (refreshes++ % 2) ? off_state : on_state; }));
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    // Copies share the rate limit, so this removes the delay between the refreshes
+    HueCommandAPI(test_bridge.getCommandAPI()).setMinDelay(HueCommandAPI::RequestType::other, std::chrono::seconds(0));
+    EXPECT_TRUE(test_bridge.getStateSnapshot()->is_null());
+    EXPECT_EQ(nullptr, test_bridge.findLight(1));
+    const HueLight& light = test_bridge.getAllLights()[0].get();
+    EXPECT_EQ(&light, test_bridge.findLight(1).get());
+    std::shared_ptr<const nlohmann::json> first = test_bridge.getStateSnapshot();
+    EXPECT_EQ(on_state, *first);
+    EXPECT_EQ(light_state, *light.getStateSnapshot());
+
+    // Readers on other threads always see a complete state
+    const Hue& const_bridge = test_bridge;
+    std::atomic<bool> done{false};
+    std::atomic<int> inconsistent{0};
+    std::thread reader([&] {
+        while (!done)
+        {
+            std::shared_ptr<const nlohmann::json> current = light.getStateSnapshot();
+            if ((*current)["state"]["on"].get<bool>() != ((*current)["state"]["bri"] == 254))
+            {
+                ++inconsistent;
+            }
+            const_bridge.lightExists(1);
+            std::shared_ptr<const HueLight> found = const_bridge.findLight(1);
+            if (found.get() != &light)
+            {
+                ++inconsistent;
+            }
+            light.isOn();
+        }
+    });
+    for (int i = 0; i < 200; ++i)
+    {
+        test_bridge.refreshAllLights();
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(0, inconsistent);
+
+    // Old snapshots are not changed
+    EXPECT_EQ(on_state, *first);
+    EXPECT_NE(first, test_bridge.getStateSnapshot());
+}
+
+TEST(Hue, lightExists)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json hue_bridge_state{ {"lights",
+        {{"1",
+            {{"state",
+                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                     {"reachable", true}}},
+                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
+                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
+                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(2))
+        .WillRepeatedly(Return(hue_bridge_state));
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(0);
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    EXPECT_EQ(true, test_bridge.lightExists(1));
+    EXPECT_EQ(false, test_bridge.lightExists(2));
+
+    const Hue const_test_bridge1 = test_bridge;
+    EXPECT_EQ(true, const_test_bridge1.lightExists(1));
+    EXPECT_EQ(false, const_test_bridge1.lightExists(2));
+
+    test_bridge.getLight(1);
+    const Hue const_test_bridge2 = test_bridge;
+    EXPECT_EQ(true, test_bridge.lightExists(1));
+    EXPECT_EQ(true, const_test_bridge2.lightExists(1));
+}
+
+TEST(Hue, getPictureOfLight)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    nlohmann::json hue_bridge_state{ {"lights",
+        {{"1",
+            {{"state",
+                 {{"on", true}, {"bri", 254}, {"ct", 366}, {"alert", "none"}, {"colormode", "ct"},
+                     {"reachable", true}}},
+                {"swupdate", {{"state", "noupdates"}, {"lastinstall", nullptr}}}, {"type", "Color temperature light"},
+                {"name", "Hue ambiance lamp 1"}, {"modelid", "LTW001"}, {"manufacturername", "Philips"},
+                {"uniqueid", "00:00:00:00:00:00:00:00-00"}, {"swversion", "5.50.1.19085"}}}}} };
+
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(hue_bridge_state));
+    EXPECT_CALL(*handler,
+        GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), getBridgePort()))
+        .Times(0);
+
+    Hue test_bridge(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+
+    test_bridge.getLight(1);
+
+    EXPECT_EQ("", test_bridge.getPictureOfLight(2));
+
+    EXPECT_EQ("e27_waca", test_bridge.getPictureOfLight(1));
+}
+
+TEST(Hue, refreshState)
+{
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    Hue test_bridge(getBridgeIp(), getBridgePort(), "", handler); // NULL as username leads to segfault
+
+    std::vector<std::reference_wrapper<HueLight>> test_lights = test_bridge.getAllLights();
+    EXPECT_EQ(test_lights.size(), 0);
+}
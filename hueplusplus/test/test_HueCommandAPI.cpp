@@ -20,12 +20,18 @@
     along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
+#include <chrono>
+#include <future>
+#include <thread>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "testhelper.h"
 
+#include "../include/FilteringJsonSax.h"
 #include "../include/Hue.h"
+#include "../include/RequestOptions.h"
 #include "../include/json/json.hpp"
 #include "mocks/mock_HttpHandler.h"
 
@@ -169,6 +175,76 @@ TEST(HueCommandAPI, GETRequest)
     }
 }
 
+TEST(HueCommandAPI, GETRequestSax)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    nlohmann::json request;
+    const std::string path = "/test";
+    auto respond = [](const std::string& response) {
+        return [response](const std::string&, const nlohmann::json&, nlohmann::json::json_sax_t& handler,
+                   const std::string&, int) { return nlohmann::json::sax_parse(response, &handler); };
+    };
+
+    // success
+    {
+        EXPECT_CALL(*httpHandler, GETJsonSax("/api/" + getBridgeUsername() + path, request, _, getBridgeIp(), 80))
+            .WillOnce(Invoke(respond("{\"a\": {\"b\": 1, \"error\": 2}, \"c\": [{\"error\": 3}]}")));
+        FilteringJsonSax sax({"a/b"});
+        EXPECT_TRUE(api.GETRequest(path, request, sax));
+        EXPECT_EQ(nlohmann::json({{"a", {{"b", 1}}}}), sax.getResult());
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    // recoverable error before any data
+    {
+        EXPECT_CALL(*httpHandler, GETJsonSax("/api/" + getBridgeUsername() + path, request, _, getBridgeIp(), 80))
+            .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_reset))))
+            .WillOnce(Invoke(respond("{\"a\": 1}")));
+        FilteringJsonSax sax({"a"});
+        EXPECT_TRUE(api.GETRequest(path, request, sax));
+        EXPECT_EQ(nlohmann::json({{"a", 1}}), sax.getResult());
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    // connection lost after events were passed to the handler
+    {
+        EXPECT_CALL(*httpHandler, GETJsonSax("/api/" + getBridgeUsername() + path, request, _, getBridgeIp(), 80))
+            .WillOnce(Invoke([](const std::string&, const nlohmann::json&, nlohmann::json::json_sax_t& handler,
+                                 const std::string&, int) -> bool {
+                handler.start_object(std::size_t(-1));
+                throw std::system_error(std::make_error_code(std::errc::connection_reset));
+            }));
+        FilteringJsonSax sax({"a"});
+        EXPECT_THROW(api.GETRequest(path, request, sax), std::system_error);
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    // api returns error
+    {
+        EXPECT_CALL(*httpHandler, GETJsonSax("/api/" + getBridgeUsername() + path, request, _, getBridgeIp(), 80))
+            .WillOnce(Invoke(respond("[{\"error\": {\"type\": 3, \"address\": \"/test\", \"description\": \"x\"}}]")));
+        FilteringJsonSax sax({"a"});
+        try
+        {
+            api.GETRequest(path, request, sax);
+            FAIL() << "Expected HueAPIResponseException";
+        }
+        catch (const HueAPIResponseException& e)
+        {
+            EXPECT_EQ(3, e.GetErrorNumber());
+            EXPECT_EQ("/test", e.GetAddress());
+        }
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    {
+        EXPECT_CALL(*httpHandler, GETJsonSax("/api/" + getBridgeUsername() + path, request, _, getBridgeIp(), 80))
+            .WillOnce(Invoke(respond("{\"error\": {\"type\": 1}}")));
+        FilteringJsonSax sax({"a"});
+        EXPECT_THROW(api.GETRequest(path, request, sax), HueAPIResponseException);
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+}
+
 TEST(HueCommandAPI, DELETERequest)
 {
     using namespace ::testing;
@@ -238,3 +314,385 @@ TEST(HueCommandAPI, DELETERequest)
         Mock::VerifyAndClearExpectations(httpHandler.get());
     }
 }
+
+TEST(HueCommandAPI, setTimeout)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    const nlohmann::json request;
+    const nlohmann::json result = {{"ok", true}};
+    const auto hasDeadline = [&](const std::string&, const nlohmann::json&, const std::string&, int) {
+        EXPECT_NE(RequestOptions::Clock::time_point::max(), RequestOptions::current().deadline);
+        return result;
+    };
+    const auto noDeadline = [&](const std::string&, const nlohmann::json&, const std::string&, int) {
+        EXPECT_EQ(RequestOptions::Clock::time_point::max(), RequestOptions::current().deadline);
+        return result;
+    };
+    // default leaves the timeout to the handler
+    {
+        EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername(), request, getBridgeIp(), 80))
+            .WillOnce(Invoke(noDeadline));
+        EXPECT_EQ(result, api.GETRequest("", request));
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    api.setTimeout(std::chrono::seconds(1));
+    {
+        EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername(), request, getBridgeIp(), 80))
+            .WillOnce(Invoke(hasDeadline));
+        EXPECT_EQ(result, api.GETRequest("", request));
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    // no retry after the deadline
+    api.setTimeout(std::chrono::milliseconds(50));
+    // the request must not time out while waiting for its turn
+    std::this_thread::sleep_for(HueCommandAPI::minDelay);
+    {
+        EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername(), request, getBridgeIp(), 80))
+            .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::timed_out))));
+        EXPECT_THROW(api.GETRequest("", request), std::system_error);
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    EXPECT_EQ(RequestOptions::Clock::time_point::max(), RequestOptions::current().deadline);
+}
+
+TEST(HueCommandAPI, setBurst)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    api.setBurst(3);
+    // Wait until the bucket is full
+    std::this_thread::sleep_for(3 * HueCommandAPI::minDelay);
+    const nlohmann::json request;
+    const nlohmann::json result = {{"ok", true}};
+    EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername(), request, getBridgeIp(), 80))
+        .Times(4)
+        .WillRepeatedly(Return(result));
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i)
+    {
+        api.GETRequest("", request);
+    }
+    EXPECT_GT(HueCommandAPI::minDelay, std::chrono::steady_clock::now() - start);
+    // Afterwards requests are paced again
+    api.GETRequest("", request);
+    EXPECT_LE(HueCommandAPI::minDelay, std::chrono::steady_clock::now() - start);
+}
+
+TEST(HueCommandAPI, setMinDelay)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    EXPECT_EQ(HueCommandAPI::minDelay, api.getMinDelay(HueCommandAPI::RequestType::lights));
+    EXPECT_EQ(HueCommandAPI::groupMinDelay, api.getMinDelay(HueCommandAPI::RequestType::groups));
+    EXPECT_EQ(HueCommandAPI::minDelay, api.getMinDelay(HueCommandAPI::RequestType::other));
+    api.setMinDelay(HueCommandAPI::RequestType::groups, std::chrono::milliseconds(500));
+    EXPECT_EQ(std::chrono::milliseconds(500), api.getMinDelay(HueCommandAPI::RequestType::groups));
+
+    const nlohmann::json request = {{"on", true}};
+    const nlohmann::json result = {{"ok", true}};
+    EXPECT_CALL(*httpHandler, PUTJson(_, request, getBridgeIp(), 80)).WillRepeatedly(Return(result));
+    EXPECT_CALL(*httpHandler, GETJson(_, _, getBridgeIp(), 80)).WillRepeatedly(Return(result));
+    // Wait until the first request of each type can be sent immediately
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const auto start = std::chrono::steady_clock::now();
+    api.PUTRequest("/groups/1/action", request);
+    // Each type has its own budget, so these do not wait for the group request
+    api.PUTRequest("/lights/1/state", request);
+    api.GETRequest("/groups/1", nlohmann::json::object());
+    EXPECT_GT(std::chrono::milliseconds(100), std::chrono::steady_clock::now() - start);
+    api.PUTRequest("groups/2/action", request);
+    EXPECT_LE(std::chrono::milliseconds(500), std::chrono::steady_clock::now() - start);
+}
+
+TEST(HueCommandAPI, PUTRequestCoalescing)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    const std::string path = "/api/" + getBridgeUsername() + "/lights/1/state";
+    const nlohmann::json first = {{"bri", 100}, {"ct", 300}, {"transitiontime", 0}};
+    const nlohmann::json second = {{"bri", 200}, {"xy", {0.5, 0.5}}, {"on", true}};
+    // The transitiontime of the first request is kept, because the second one has none
+    const nlohmann::json merged = {{"bri", 200}, {"xy", {0.5, 0.5}}, {"on", true}, {"transitiontime", 0}};
+    const nlohmann::json response = {{{"success", {{"/lights/1/state/bri", 200}}}},
+        {{"success", {{"/lights/1/state/xy", {0.5, 0.5}}}}}, {{"success", {{"/lights/1/state/on", true}}}}};
+    const nlohmann::json alert = {{"alert", "select"}};
+    const nlohmann::json alertResponse = {{{"success", {{"/lights/1/state/alert", "select"}}}}};
+    EXPECT_CALL(*httpHandler, PUTJson(path, alert, getBridgeIp(), 80)).Times(2).WillRepeatedly(Return(alertResponse));
+    EXPECT_CALL(*httpHandler, PUTJson(path, merged, getBridgeIp(), 80)).WillOnce(Return(response));
+
+    // Alerts are never merged
+    api.PUTRequest("/lights/1/state", alert);
+    std::thread alertThread([&]() { api.PUTRequest("/lights/1/state", alert); });
+    // Waits behind the alerts
+    nlohmann::json firstResult;
+    std::thread firstThread([&]() { firstResult = api.PUTRequest("/lights/1/state", first); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const nlohmann::json secondResult = api.PUTRequest("lights/1/state", second);
+    alertThread.join();
+    firstThread.join();
+    EXPECT_EQ(response, secondResult);
+    // Only the attributes of the first request, with the value that was set
+    EXPECT_EQ(nlohmann::json {response[0]}, firstResult);
+    Mock::VerifyAndClearExpectations(httpHandler.get());
+}
+
+TEST(HueCommandAPI, PUTRequestCoalescingTransition)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    api.setMinDelay(HueCommandAPI::RequestType::lights, std::chrono::milliseconds(500));
+    const std::string path = "/api/" + getBridgeUsername() + "/lights/1/state";
+    const nlohmann::json alert = {{"alert", "select"}};
+    const nlohmann::json first = {{"bri", 100}, {"transitiontime", 10}};
+    const nlohmann::json second = {{"ct", 300}, {"transitiontime", 20}};
+    const nlohmann::json third = {{"on", true}};
+    // The latest explicit transitiontime wins over earlier ones and the default
+    const nlohmann::json merged = {{"bri", 100}, {"ct", 300}, {"on", true}, {"transitiontime", 20}};
+    EXPECT_CALL(*httpHandler, PUTJson(path, alert, getBridgeIp(), 80))
+        .WillOnce(Return(nlohmann::json {{{"success", {{"/lights/1/state/alert", "select"}}}}}));
+    EXPECT_CALL(*httpHandler, PUTJson(path, merged, getBridgeIp(), 80))
+        .WillOnce(Return(nlohmann::json::array()));
+
+    // Wait until the first request can be sent immediately
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    api.PUTRequest("/lights/1/state", alert);
+    // Wait behind the alert
+    std::thread firstThread([&]() { api.PUTRequest("/lights/1/state", first); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::thread secondThread([&]() { api.PUTRequest("/lights/1/state", second); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    api.PUTRequest("/lights/1/state", third);
+    firstThread.join();
+    secondThread.join();
+    Mock::VerifyAndClearExpectations(httpHandler.get());
+}
+
+TEST(HueCommandAPI, PUTRequestCoalescingTimeout)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    api.setMinDelay(HueCommandAPI::RequestType::lights, std::chrono::milliseconds(500));
+    const std::string path = "/api/" + getBridgeUsername() + "/lights/1/state";
+    const nlohmann::json alert = {{"alert", "select"}};
+    const nlohmann::json first = {{"bri", 100}};
+    const nlohmann::json second = {{"on", true}};
+    const nlohmann::json merged = {{"bri", 100}, {"on", true}};
+    const nlohmann::json response
+        = {{{"success", {{"/lights/1/state/bri", 100}}}}, {{"success", {{"/lights/1/state/on", true}}}}};
+    EXPECT_CALL(*httpHandler, PUTJson(path, alert, getBridgeIp(), 80))
+        .WillOnce(Return(nlohmann::json {{{"success", {{"/lights/1/state/alert", "select"}}}}}));
+    EXPECT_CALL(*httpHandler, PUTJson(path, merged, getBridgeIp(), 80)).WillOnce(Return(response));
+
+    // Wait until the first request can be sent immediately
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    api.PUTRequest("/lights/1/state", alert);
+    // Waits behind the alert
+    nlohmann::json firstResult;
+    std::thread firstThread([&]() { firstResult = api.PUTRequest("/lights/1/state", first); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    {
+        // The merged caller does not wait longer than its own timeout
+        RequestOptions::Scope scope(RequestOptions::withTimeout(std::chrono::milliseconds(50)));
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_THROW(api.PUTRequest("/lights/1/state", second), std::system_error);
+        EXPECT_GT(std::chrono::milliseconds(300), std::chrono::steady_clock::now() - start);
+    }
+    firstThread.join();
+    EXPECT_EQ(nlohmann::json {response[0]}, firstResult);
+    Mock::VerifyAndClearExpectations(httpHandler.get());
+}
+
+TEST(HueCommandAPI, setAdaptivePacing)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    AdaptivePacer::Settings settings;
+    settings.enabled = true;
+    settings.minDelay = std::chrono::milliseconds(50);
+    settings.maxDelay = std::chrono::milliseconds(400);
+    settings.step = std::chrono::milliseconds(10);
+    api.setAdaptivePacing(HueCommandAPI::RequestType::other, settings);
+    EXPECT_DOUBLE_EQ(10.0, api.getRequestRate(HueCommandAPI::RequestType::other));
+
+    const nlohmann::json request;
+    const nlohmann::json internalError
+        = {{{"error", {{"type", 901}, {"address", "/"}, {"description", "Internal error, 404"}}}}};
+    EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername(), request, getBridgeIp(), 80))
+        .WillOnce(Return(nlohmann::json::object()))
+        .WillOnce(Return(internalError));
+    api.GETRequest("", request);
+    // Healthy response shrinks the delay
+    EXPECT_EQ(std::chrono::milliseconds(90), api.getMinDelay(HueCommandAPI::RequestType::other));
+    EXPECT_LT(std::chrono::steady_clock::duration::zero(), api.getLatency(HueCommandAPI::RequestType::other));
+    EXPECT_THROW(api.GETRequest("", request), HueAPIResponseException);
+    // Internal error backs off
+    EXPECT_LE(std::chrono::milliseconds(180), api.getMinDelay(HueCommandAPI::RequestType::other));
+    // Other types are not affected
+    EXPECT_EQ(HueCommandAPI::minDelay, api.getMinDelay(HueCommandAPI::RequestType::lights));
+}
+
+TEST(HueCommandAPI, setRetryPolicy)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    ASSERT_NE(nullptr, api.getRetryPolicy());
+    EXPECT_EQ(2u, api.getRetryPolicy()->getSettings().maxAttempts);
+    api.setMinDelay(HueCommandAPI::RequestType::other, std::chrono::milliseconds(10));
+    api.setMinDelay(HueCommandAPI::RequestType::lights, std::chrono::milliseconds(10));
+
+    RetryPolicy::Settings settings;
+    settings.maxAttempts = 3;
+    settings.retryInternalErrors = true;
+    settings.retryPUT = false;
+    api.setRetryPolicy(std::make_shared<RetryPolicy>(settings));
+    EXPECT_EQ(3u, api.getRetryPolicy()->getSettings().maxAttempts);
+
+    const nlohmann::json request;
+    const nlohmann::json internalError
+        = {{{"error", {{"type", 901}, {"address", "/"}, {"description", "Internal error, 404"}}}}};
+    const nlohmann::json result = {{"a", "b"}};
+    {
+        // Internal errors are retried up to the maximum attempts
+        EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername(), request, getBridgeIp(), 80))
+            .WillOnce(Return(internalError))
+            .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_reset))))
+            .WillOnce(Return(result));
+        EXPECT_EQ(result, api.GETRequest("", request));
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    {
+        EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername(), request, getBridgeIp(), 80))
+            .Times(3)
+            .WillRepeatedly(Return(internalError));
+        EXPECT_THROW(api.GETRequest("", request), HueAPIResponseException);
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    {
+        // PUT requests that are not idempotent are not retried
+        const nlohmann::json increment = {{"bri_inc", 10}};
+        EXPECT_CALL(*httpHandler, PUTJson("/api/" + getBridgeUsername() + "/lights/1/state", increment,
+                                      getBridgeIp(), 80))
+            .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_reset))));
+        EXPECT_THROW(api.PUTRequest("/lights/1/state", increment), std::system_error);
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    {
+        // Light state changes without increments are idempotent
+        const nlohmann::json change = {{"on", true}};
+        EXPECT_CALL(*httpHandler, PUTJson("/api/" + getBridgeUsername() + "/lights/1/state", change,
+                                      getBridgeIp(), 80))
+            .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_reset))))
+            .WillOnce(Return(result));
+        EXPECT_EQ(result, api.PUTRequest("/lights/1/state", change));
+        Mock::VerifyAndClearExpectations(httpHandler.get());
+    }
+    // nullptr restores the default policy
+    api.setRetryPolicy(nullptr);
+    EXPECT_EQ(2u, api.getRetryPolicy()->getSettings().maxAttempts);
+}
+
+TEST(HueCommandAPI, getMetrics)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+    api.setMinDelay(HueCommandAPI::RequestType::other, std::chrono::milliseconds(10));
+    EXPECT_TRUE(api.getMetrics().snapshot().empty());
+
+    const nlohmann::json request;
+    const nlohmann::json internalError
+        = {{{"error", {{"type", 901}, {"address", "/"}, {"description", "Internal error, 404"}}}}};
+    EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername() + "/lights/1", request, getBridgeIp(), 80))
+        .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_reset))))
+        .WillOnce(DoAll(InvokeWithoutArgs([]() { RequestMetrics::addParseTime(std::chrono::milliseconds(3)); }),
+            Return(nlohmann::json::object())))
+        .WillOnce(Return(internalError));
+    EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername() + "/lights/2", request, getBridgeIp(), 80))
+        .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_refused))));
+    api.GETRequest("/lights/1", request);
+    EXPECT_THROW(api.GETRequest("/lights/1", request), HueAPIResponseException);
+    EXPECT_THROW(api.GETRequest("/lights/2", request), std::system_error);
+
+    // Copies share the metrics
+    const std::vector<RequestMetrics::EndpointSnapshot> snapshot = HueCommandAPI(api).getMetrics().snapshot();
+    ASSERT_EQ(1u, snapshot.size());
+    const RequestMetrics::EndpointSnapshot& lights = snapshot[0];
+    EXPECT_EQ("GET", lights.method);
+    EXPECT_EQ("/lights/{id}", lights.path);
+    EXPECT_EQ(4u, lights.queueWait.count);
+    EXPECT_EQ(4u, lights.network.count);
+    EXPECT_EQ(4u, lights.parse.count);
+    EXPECT_EQ(std::chrono::milliseconds(3), lights.parse.sum);
+    EXPECT_EQ(3u, lights.total.count);
+    EXPECT_EQ(1u, lights.successes);
+    EXPECT_EQ(1u, lights.failures);
+    EXPECT_EQ(1u, lights.retries);
+    EXPECT_EQ((std::map<int, std::uint64_t> {{901, 1}}), lights.apiErrors);
+}
+
+TEST(HueCommandAPI, GETRequestSharing)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> httpHandler = std::make_shared<MockHttpHandler>();
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), httpHandler);
+
+    const nlohmann::json request;
+    const std::string path = "/api/" + getBridgeUsername() + "/lights/1";
+    const nlohmann::json response = {{"state", {{"on", true}}}};
+    // The first request blocks the rate budget, so the identical ones wait together
+    EXPECT_CALL(*httpHandler, GETJson("/api/" + getBridgeUsername() + "/config", request, getBridgeIp(), 80))
+        .WillOnce(Return(nlohmann::json::object()));
+    EXPECT_CALL(*httpHandler, GETJson(path, request, getBridgeIp(), 80)).WillOnce(Return(response));
+    api.GETRequest("/config", request);
+
+    std::vector<std::future<nlohmann::json>> results;
+    for (int i = 0; i < 4; ++i)
+    {
+        results.push_back(std::async(std::launch::async, [&]() { return api.GETRequest("/lights/1", request); }));
+    }
+    for (std::future<nlohmann::json>& result : results)
+    {
+        EXPECT_EQ(response, result.get());
+    }
+    Mock::VerifyAndClearExpectations(httpHandler.get());
+
+    // Completed requests are not shared, errors reach all waiting callers
+    const nlohmann::json error = {{{"error", {{"type", 3}, {"address", "/lights/1"}, {"description", "unavailable"}}}}};
+    EXPECT_CALL(*httpHandler, GETJson(path, request, getBridgeIp(), 80)).WillOnce(Return(error));
+    results.clear();
+    for (int i = 0; i < 2; ++i)
+    {
+        results.push_back(std::async(std::launch::async, [&]() { return api.GETRequest("/lights/1", request); }));
+    }
+    for (std::future<nlohmann::json>& result : results)
+    {
+        EXPECT_THROW(result.get(), HueAPIResponseException);
+    }
+    Mock::VerifyAndClearExpectations(httpHandler.get());
+
+    // Callers that shared a request are counted
+    std::uint64_t coalesced = 0;
+    for (const RequestMetrics::EndpointSnapshot& endpoint : api.getMetrics().snapshot())
+    {
+        coalesced += endpoint.coalesced;
+    }
+    EXPECT_EQ(4u, coalesced);
+}
@@ -0,0 +1,121 @@
+/**
+    \file test_HueFleet.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "testhelper.h"
+
+#include "../include/HueException.h"
+#include "../include/HueFleet.h"
+#include "../include/json/json.hpp"
+#include "mocks/mock_HttpHandler.h"
+
+TEST(HueFleet, addBridge)
+{
+    using namespace ::testing;
+    auto handler = std::make_shared<MockHttpHandler>();
+    HueFleet fleet(2);
+    EXPECT_TRUE(fleet.getBridgeNames().empty());
+    EXPECT_THROW(fleet.getBridge("first"), HueException);
+
+    Hue& first = fleet.addBridge("first", Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler));
+    fleet.addBridge("second", Hue("192.168.2.117", getBridgePort(), getBridgeUsername(), handler));
+    EXPECT_EQ(&first, &fleet.getBridge("first"));
+    EXPECT_EQ("192.168.2.117", fleet.getBridge("second").getBridgeIP());
+    EXPECT_THAT(fleet.getBridgeNames(), ElementsAre("first", "second"));
+}
+
+TEST(HueFleet, submit)
+{
+    auto handler = std::make_shared<MockHttpHandler>();
+    HueFleet fleet(4);
+    fleet.addBridge("first", Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler));
+
+    EXPECT_THROW(fleet.submit("unknown", [](Hue&) { return 0; }), HueException);
+
+    // Tasks of one bridge run in order and never at the same time
+    std::vector<int> order;
+    std::vector<std::future<void>> results;
+    for (int i = 0; i < 5; ++i)
+    {
+        results.push_back(fleet.submit("first", [&order, i](Hue&) {
+            order.push_back(i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }));
+    }
+    for (std::future<void>& result : results)
+    {
+        result.get();
+    }
+    EXPECT_EQ((std::vector<int> {0, 1, 2, 3, 4}), order);
+
+    // Result and exceptions are passed through
+    EXPECT_EQ(getBridgeIp(), fleet.submit("first", [](Hue& hue) { return hue.getBridgeIP(); }).get());
+    std::future<int> failed = fleet.submit("first", [](Hue&) -> int { throw std::runtime_error("failed"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+
+    // Tasks run with the options of the submitting thread
+    RequestOptions::Scope scope(RequestOptions::withPriority(RequestOptions::Priority::background));
+    EXPECT_EQ(RequestOptions::Priority::background,
+        fleet.submit("first", [](Hue&) { return RequestOptions::current().priority; }).get());
+}
+
+TEST(HueFleet, setLightStates)
+{
+    using namespace ::testing;
+    const std::chrono::milliseconds roundTrip(300);
+    const nlohmann::json state = {{"on", true}};
+    const std::string prefix = "/api/" + getBridgeUsername() + "/lights/";
+    auto slowResponse = [roundTrip](const std::string& path) {
+        return InvokeWithoutArgs([roundTrip, path]() {
+            std::this_thread::sleep_for(roundTrip);
+            return nlohmann::json::array({{{"success", {{path, true}}}}});
+        });
+    };
+    auto firstHandler = std::make_shared<MockHttpHandler>();
+    auto secondHandler = std::make_shared<MockHttpHandler>();
+    EXPECT_CALL(*firstHandler, PUTJson(prefix + "1/state", state, getBridgeIp(), getBridgePort()))
+        .WillOnce(slowResponse("/lights/1/state/on"));
+    EXPECT_CALL(*secondHandler, PUTJson(prefix + "3/state", state, "192.168.2.117", getBridgePort()))
+        .WillOnce(slowResponse("/lights/3/state/on"));
+
+    HueFleet fleet(4);
+    fleet.addBridge("first", Hue(getBridgeIp(), getBridgePort(), getBridgeUsername(), firstHandler));
+    fleet.addBridge("second", Hue("192.168.2.117", getBridgePort(), getBridgeUsername(), secondHandler));
+
+    EXPECT_THROW(fleet.setLightStates({{"first", 1}, {"unknown", 2}}, state), HueException);
+
+    // Bridges are changed in parallel
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<nlohmann::json>> results = fleet.setLightStates({{"first", 1}, {"second", 3}}, state);
+    ASSERT_EQ(2u, results.size());
+    EXPECT_EQ(nlohmann::json::array({{{"success", {{"/lights/1/state/on", true}}}}}), results[0].get());
+    EXPECT_EQ(nlohmann::json::array({{{"success", {{"/lights/3/state/on", true}}}}}), results[1].get());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 2 * roundTrip - std::chrono::milliseconds(50));
+}
@@ -20,16 +20,34 @@
     along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
+#include <string>
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "testhelper.h"
 
 #include "../include/Hue.h"
+#include "../include/HueExceptionMacro.h"
 #include "../include/HueLight.h"
 #include "../include/json/json.hpp"
 #include "mocks/mock_HttpHandler.h"
 
+//! Light that exposes SendPutRequest and refreshState and keeps its state for an hour
+class PutHueLight : public HueLight
+{
+public:
+    PutHueLight(const HueCommandAPI& commands, const nlohmann::json& state)
+        : HueLight(1, commands, nullptr, nullptr, nullptr, state)
+    {
+        stateMaxAge = std::chrono::hours(1);
+    }
+
+    using HueLight::refreshState;
+    using HueLight::SendPutRequest;
+};
+
 class HueLightTest : public ::testing::Test
 {
 protected:
@@ -108,24 +126,28 @@ protected:
         EXPECT_CALL(*handler, GETJson("/api/" + getBridgeUsername(), nlohmann::json::object(), getBridgeIp(), 80))
             .Times(AtLeast(1))
             .WillRepeatedly(Return(hue_bridge_state));
-        EXPECT_CALL(
-            *handler, GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), 80))
-            .Times(AtLeast(1))
-            .WillRepeatedly(Return(hue_bridge_state["lights"]["1"]));
-        EXPECT_CALL(
-            *handler, GETJson("/api/" + getBridgeUsername() + "/lights/2", nlohmann::json::object(), getBridgeIp(), 80))
-            .Times(AtLeast(1))
-            .WillRepeatedly(Return(hue_bridge_state["lights"]["2"]));
-        EXPECT_CALL(
-            *handler, GETJson("/api/" + getBridgeUsername() + "/lights/3", nlohmann::json::object(), getBridgeIp(), 80))
-            .Times(AtLeast(1))
-            .WillRepeatedly(Return(hue_bridge_state["lights"]["3"]));
     }
     ~HueLightTest() {};
+
+    //! Expects that each light in ids requests its own state at least once, other lights must not request it
+    void expectLightRequests(const std::vector<int>& ids = {1, 2, 3})
+    {
+        using namespace ::testing;
+        for (int id : ids)
+        {
+            const std::string light = std::to_string(id);
+            EXPECT_CALL(*handler,
+                GETJson(
+                    "/api/" + getBridgeUsername() + "/lights/" + light, nlohmann::json::object(), getBridgeIp(), 80))
+                .Times(AtLeast(1))
+                .WillRepeatedly(Return(hue_bridge_state["lights"][light]));
+        }
+    }
 };
 
 TEST_F(HueLightTest, Constructor)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     HueLight test_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
@@ -137,6 +159,7 @@ TEST_F(HueLightTest, Constructor)
 TEST_F(HueLightTest, On)
 {
     using namespace ::testing;
+    expectLightRequests();
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/2/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -165,6 +188,7 @@ TEST_F(HueLightTest, On)
 TEST_F(HueLightTest, Off)
 {
     using namespace ::testing;
+    expectLightRequests();
     nlohmann::json prep_ret;
     prep_ret = nlohmann::json::array();
     prep_ret[0] = nlohmann::json::object();
@@ -188,6 +212,7 @@ TEST_F(HueLightTest, Off)
 
 TEST_F(HueLightTest, isOn)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -205,6 +230,7 @@ TEST_F(HueLightTest, isOn)
 
 TEST_F(HueLightTest, getId)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -222,6 +248,7 @@ TEST_F(HueLightTest, getId)
 
 TEST_F(HueLightTest, getType)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -239,6 +266,7 @@ TEST_F(HueLightTest, getType)
 
 TEST_F(HueLightTest, getName)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -256,6 +284,7 @@ TEST_F(HueLightTest, getName)
 
 TEST_F(HueLightTest, getModelId)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -273,6 +302,7 @@ TEST_F(HueLightTest, getModelId)
 
 TEST_F(HueLightTest, getUId)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -290,6 +320,7 @@ TEST_F(HueLightTest, getUId)
 
 TEST_F(HueLightTest, getManufacturername)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -307,6 +338,7 @@ TEST_F(HueLightTest, getManufacturername)
 
 TEST_F(HueLightTest, getProductname)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -324,6 +356,7 @@ TEST_F(HueLightTest, getProductname)
 
 TEST_F(HueLightTest, getLuminaireUId)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -341,6 +374,7 @@ TEST_F(HueLightTest, getLuminaireUId)
 
 TEST_F(HueLightTest, getSwVersion)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -388,10 +422,17 @@ TEST_F(HueLightTest, setName)
     EXPECT_EQ(true, test_light_1.setName(expected_request["name"]));
     EXPECT_EQ(false, test_light_2.setName(expected_request["name"]));
     EXPECT_EQ(true, test_light_3.setName(expected_request["name"]));
+
+    // Confirmed names are written to the cached state
+    const HueLight& ctest_light_1 = test_light_1;
+    const HueLight& ctest_light_2 = test_light_2;
+    EXPECT_EQ("Baskj189", ctest_light_1.getName());
+    EXPECT_EQ("Hue lamp 2", ctest_light_2.getName());
 }
 
 TEST_F(HueLightTest, getColorType)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -409,6 +450,7 @@ TEST_F(HueLightTest, getColorType)
 
 TEST_F(HueLightTest, KelvinToMired)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -426,6 +468,7 @@ TEST_F(HueLightTest, KelvinToMired)
 
 TEST_F(HueLightTest, MiredToKelvin)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -444,6 +487,7 @@ TEST_F(HueLightTest, MiredToKelvin)
 
 TEST_F(HueLightTest, hasBrightnessControl)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -461,6 +505,7 @@ TEST_F(HueLightTest, hasBrightnessControl)
 
 TEST_F(HueLightTest, hasTemperatureControl)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -478,6 +523,7 @@ TEST_F(HueLightTest, hasTemperatureControl)
 
 TEST_F(HueLightTest, hasColorControl)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -496,6 +542,7 @@ TEST_F(HueLightTest, hasColorControl)
 TEST_F(HueLightTest, setBrightness)
 {
     using namespace ::testing;
+    expectLightRequests();
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/1/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -525,6 +572,7 @@ TEST_F(HueLightTest, setBrightness)
 
 TEST_F(HueLightTest, getBrightness)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -543,6 +591,7 @@ TEST_F(HueLightTest, getBrightness)
 TEST_F(HueLightTest, setColorTemperature)
 {
     using namespace ::testing;
+    expectLightRequests({3});
     nlohmann::json prep_ret;
     prep_ret = nlohmann::json::array();
     prep_ret[2] = nlohmann::json::object();
@@ -569,6 +618,7 @@ TEST_F(HueLightTest, setColorTemperature)
 
 TEST_F(HueLightTest, getColorTemperature)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -587,6 +637,7 @@ TEST_F(HueLightTest, getColorTemperature)
 TEST_F(HueLightTest, setColorHue)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/2/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -617,6 +668,7 @@ TEST_F(HueLightTest, setColorHue)
 TEST_F(HueLightTest, setColorSaturation)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/2/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -647,6 +699,7 @@ TEST_F(HueLightTest, setColorSaturation)
 TEST_F(HueLightTest, setColorHueSaturation)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/2/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -679,6 +732,7 @@ TEST_F(HueLightTest, setColorHueSaturation)
 
 TEST_F(HueLightTest, getColorHueSaturation)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -701,6 +755,7 @@ TEST_F(HueLightTest, getColorHueSaturation)
 TEST_F(HueLightTest, setColorXY)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/2/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -731,6 +786,7 @@ TEST_F(HueLightTest, setColorXY)
 
 TEST_F(HueLightTest, getColorXY)
 {
+    expectLightRequests();
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     const HueLight ctest_light_2 = test_bridge.getLight(2);
     const HueLight ctest_light_3 = test_bridge.getLight(3);
@@ -749,6 +805,7 @@ TEST_F(HueLightTest, getColorXY)
 TEST_F(HueLightTest, setColorRGB)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/2/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -807,6 +864,7 @@ TEST_F(HueLightTest, alert)
 TEST_F(HueLightTest, alertTemperature)
 {
     using namespace ::testing;
+    expectLightRequests({3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/3/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -823,6 +881,7 @@ TEST_F(HueLightTest, alertTemperature)
 TEST_F(HueLightTest, alertHueSaturation)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/3/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -839,6 +898,7 @@ TEST_F(HueLightTest, alertHueSaturation)
 TEST_F(HueLightTest, alertXY)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/3/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -855,6 +915,7 @@ TEST_F(HueLightTest, alertXY)
 TEST_F(HueLightTest, alertRGB)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/3/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -871,6 +932,7 @@ TEST_F(HueLightTest, alertRGB)
 TEST_F(HueLightTest, setColorLoop)
 {
     using namespace ::testing;
+    expectLightRequests({2, 3});
     EXPECT_CALL(*handler, PUTJson("/api/" + getBridgeUsername() + "/lights/2/state", _, getBridgeIp(), 80))
         .Times(1)
         .WillOnce(Return(nlohmann::json::array()));
@@ -902,3 +964,36 @@ TEST_F(HueLightTest, refreshState)
     const HueLight ctest_light_1 = test_bridge.getLight(1);
     HueLight test_light_1 = test_bridge.getLight(1);
 }
+
+TEST_F(HueLightTest, SendPutRequestUnapplied)
+{
+    using namespace ::testing;
+    const std::string statePath = "/api/" + getBridgeUsername() + "/lights/1/state";
+    nlohmann::json reply = {{{"success", {{"/lights/1/state/bri", 200}}}},
+        {{"success", {{"/lights/1/state/transitiontime", 4}}}}};
+    EXPECT_CALL(*handler, PUTJson(statePath, nlohmann::json({{"bri", 200}, {"transitiontime", 4}}), getBridgeIp(), 80))
+        .WillOnce(Return(reply));
+    // Creates the light from the state of the bridge
+    test_bridge.getLight(1);
+    PutHueLight light(test_bridge.getCommandAPI(), (*test_bridge.getStateSnapshot())["lights"]["1"]);
+
+    // The transition time is no part of the state, so the state stays up to date
+    light.SendPutRequest({{"bri", 200}, {"transitiontime", 4}}, "/state", CURRENT_FILE_INFO);
+    light.refreshState();
+    EXPECT_EQ(200, (*light.getStateSnapshot())["state"]["bri"]);
+
+    // The new brightness of a relative change is unknown, so the state is requested again
+    reply = {{{"success", {{"/lights/1/state/bri_inc", 20}}}}};
+    EXPECT_CALL(*handler, PUTJson(statePath, nlohmann::json({{"bri_inc", 20}}), getBridgeIp(), 80))
+        .WillOnce(Return(reply));
+    nlohmann::json refreshed = hue_bridge_state["lights"]["1"];
+    refreshed["state"]["bri"] = 220;
+    EXPECT_CALL(
+        *handler, GETJson("/api/" + getBridgeUsername() + "/lights/1", nlohmann::json::object(), getBridgeIp(), 80))
+        .WillOnce(Return(refreshed));
+    light.SendPutRequest({{"bri_inc", 20}}, "/state", CURRENT_FILE_INFO);
+    light.refreshState();
+    EXPECT_EQ(220, (*light.getStateSnapshot())["state"]["bri"]);
+    // The requested state is up to date again
+    light.refreshState();
+}
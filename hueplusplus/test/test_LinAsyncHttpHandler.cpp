@@ -0,0 +1,239 @@
+/**
+    \file test_LinAsyncHttpHandler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "../include/HueException.h"
+#include "../include/LinAsyncHttpHandler.h"
+#include "../include/RequestOptions.h"
+#include "../include/SyncHttpHandler.h"
+#include "TcpResponder.h"
+
+namespace
+{
+    const std::string jsonResponse = "HTTP/1.1 200 OK\r\nContent-Length: 11\r\n\r\n{\"on\":true}";
+}
+
+TEST(LinAsyncHttpHandler, concurrentRequests)
+{
+    TcpResponder responder(jsonResponse, std::chrono::milliseconds(20));
+
+    LinAsyncHttpHandler handler;
+    handler.setMaxConnections(2);
+    std::vector<std::future<nlohmann::json>> results;
+    for (int i = 0; i < 10; ++i)
+    {
+        results.push_back(handler.GETJson("/api", nullptr, "127.0.0.1", responder.getPort()));
+    }
+    for (std::future<nlohmann::json>& result : results)
+    {
+        EXPECT_EQ(nlohmann::json({{"on", true}}), result.get());
+    }
+    // Queued requests wait for a free connection instead of opening more
+    EXPECT_LE(responder.getConnections(), 2);
+    EXPECT_LE(responder.getMaxActive(), 2);
+}
+
+TEST(LinAsyncHttpHandler, pipelining)
+{
+    // The first response is delayed, so the other requests are sent before it arrives
+    TcpResponder responder(jsonResponse, std::chrono::milliseconds(50));
+
+    LinAsyncHttpHandler handler;
+    handler.setMaxConnections(1);
+    handler.setPipelining(8);
+    std::vector<std::future<nlohmann::json>> results;
+    for (int i = 0; i < 8; ++i)
+    {
+        results.push_back(handler.PUTJson("/api", nullptr, "127.0.0.1", responder.getPort()));
+    }
+    for (std::future<nlohmann::json>& result : results)
+    {
+        EXPECT_EQ(nlohmann::json({{"on", true}}), result.get());
+    }
+    EXPECT_EQ(1, responder.getConnections());
+    EXPECT_GT(responder.getMaxBatch(), 1);
+}
+
+TEST(LinAsyncHttpHandler, pipeliningConnectionClose)
+{
+    // The host closes the connection after each response, so requests behind it are sent again
+    TcpResponder responder("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 11\r\n\r\n{\"on\":true}",
+        std::chrono::milliseconds(10));
+
+    LinAsyncHttpHandler handler;
+    handler.setMaxConnections(1);
+    handler.setPipelining(4);
+    std::vector<std::future<nlohmann::json>> results;
+    for (int i = 0; i < 4; ++i)
+    {
+        results.push_back(handler.GETJson("/api", nullptr, "127.0.0.1", responder.getPort()));
+    }
+    for (std::future<nlohmann::json>& result : results)
+    {
+        EXPECT_EQ(nlohmann::json({{"on", true}}), result.get());
+    }
+    EXPECT_EQ(4, responder.getConnections());
+}
+
+TEST(LinAsyncHttpHandler, callback)
+{
+    TcpResponder responder(jsonResponse);
+
+    LinAsyncHttpHandler handler;
+    std::promise<std::thread::id> thread;
+    handler.sendHTTPRequest("GET", "/api", "application/json", "null", "127.0.0.1", responder.getPort(),
+        [&](std::string body, std::exception_ptr error) {
+            EXPECT_FALSE(error);
+            EXPECT_EQ("{\"on\":true}", body);
+            thread.set_value(std::this_thread::get_id());
+        });
+    // Callbacks are called on the event loop thread
+    EXPECT_NE(std::this_thread::get_id(), thread.get_future().get());
+
+    // The connection is kept open and reused
+    EXPECT_EQ(nlohmann::json({{"on", true}}),
+        handler.PUTJson("/api", nullptr, "127.0.0.1", responder.getPort()).get());
+    EXPECT_EQ(1, responder.getConnections());
+}
+
+TEST(LinAsyncHttpHandler, connectionRefused)
+{
+    // A bound socket that does not listen refuses connections
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    const int port = ntohs(addr.sin_port);
+
+    LinAsyncHttpHandler handler;
+    std::future<nlohmann::json> result = handler.GETJson("/api", nullptr, "127.0.0.1", port);
+    EXPECT_THROW(result.get(), std::system_error);
+    close(fd);
+}
+
+TEST(LinAsyncHttpHandler, cancelOnDestruction)
+{
+    TcpResponder responder(jsonResponse, std::chrono::milliseconds(200));
+
+    std::future<std::string> result;
+    {
+        LinAsyncHttpHandler handler;
+        result = handler.send("GET /api HTTP/1.1\r\nContent-Length: 4\r\n\r\nnull", "127.0.0.1", responder.getPort());
+    }
+    try
+    {
+        result.get();
+        FAIL() << "Request was not canceled";
+    }
+    catch (const std::system_error& e)
+    {
+        EXPECT_EQ(std::errc::operation_canceled, e.code());
+    }
+}
+
+TEST(LinAsyncHttpHandler, timeout)
+{
+    TcpResponder responder(jsonResponse, std::chrono::milliseconds(300));
+
+    LinAsyncHttpHandler handler;
+    handler.setMaxConnections(1);
+    handler.setPipelining(4);
+    handler.setTimeout(std::chrono::milliseconds(50));
+    std::future<std::string> first = handler.send("GET /a HTTP/1.1\r\n\r\nnull", "127.0.0.1", responder.getPort());
+    std::future<std::string> second;
+    {
+        // Pending behind the first request, but with a longer deadline
+        RequestOptions::Scope scope(RequestOptions::withTimeout(std::chrono::seconds(5)));
+        handler.setTimeout(std::chrono::steady_clock::duration::zero());
+        second = handler.send("POST /b HTTP/1.1\r\n\r\nnull", "127.0.0.1", responder.getPort());
+    }
+    try
+    {
+        first.get();
+        FAIL() << "Expected timeout";
+    }
+    catch (const std::system_error& e)
+    {
+        EXPECT_EQ(std::errc::timed_out, e.code());
+    }
+    // Sent again on a new connection
+    EXPECT_NE(std::string::npos, second.get().find("{\"on\":true}"));
+    EXPECT_EQ(2, responder.getConnections());
+}
+
+TEST(LinAsyncHttpHandler, timeoutPipelined)
+{
+    TcpResponder responder(jsonResponse, std::chrono::milliseconds(300));
+
+    LinAsyncHttpHandler handler;
+    handler.setMaxConnections(1);
+    handler.setPipelining(4);
+    handler.setTimeout(std::chrono::milliseconds(50));
+    std::future<std::string> first = handler.send("GET /a HTTP/1.1\r\n\r\nnull", "127.0.0.1", responder.getPort());
+    std::future<std::string> second;
+    {
+        // Sent behind the first request, but with a longer deadline
+        RequestOptions::Scope scope(RequestOptions::withTimeout(std::chrono::seconds(5)));
+        handler.setTimeout(std::chrono::steady_clock::duration::zero());
+        second = handler.send("PUT /b HTTP/1.1\r\n\r\nnull", "127.0.0.1", responder.getPort());
+    }
+    EXPECT_THROW(first.get(), std::system_error);
+    // The host may have applied it, so it is not sent again
+    try
+    {
+        second.get();
+        FAIL() << "Expected connection reset";
+    }
+    catch (const std::system_error& e)
+    {
+        EXPECT_EQ(std::errc::connection_reset, e.code());
+    }
+    EXPECT_EQ(1, responder.getConnections());
+}
+
+TEST(SyncHttpHandler, overAsyncHandler)
+{
+    TcpResponder responder(jsonResponse);
+
+    SyncHttpHandler handler(std::make_shared<LinAsyncHttpHandler>());
+    EXPECT_EQ(nlohmann::json({{"on", true}}), handler.GETJson("/api", nullptr, "127.0.0.1", responder.getPort()));
+    EXPECT_EQ("{\"on\":true}", handler.GETString("/api", "text/html", "null", "127.0.0.1", responder.getPort()));
+    EXPECT_EQ(1, responder.getConnections());
+
+    EXPECT_THROW(handler.sendMulticast("M-SEARCH"), HueException);
+}
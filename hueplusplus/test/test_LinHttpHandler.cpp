@@ -0,0 +1,207 @@
+/**
+    \file test_LinHttpHandler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "../include/FilteringJsonSax.h"
+#include "../include/LinHttpHandler.h"
+#include "../include/RequestOptions.h"
+#include "TcpResponder.h"
+
+namespace
+{
+    // Opens an udp socket on an ephemeral loopback port
+    int OpenUdpSocket(int& port)
+    {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd, (sockaddr*)&addr, sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(fd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+        return fd;
+    }
+
+    // Answers the first datagram with each of the answers as a separate datagram
+    std::thread AnswerOnce(int fd, std::vector<std::string> answers)
+    {
+        return std::thread([fd, answers] {
+            char buffer[2048];
+            sockaddr_in sender = {};
+            socklen_t len = sizeof(sender);
+            if (recvfrom(fd, buffer, sizeof(buffer), 0, (sockaddr*)&sender, &len) > 0)
+            {
+                for (const std::string& answer : answers)
+                {
+                    sendto(fd, answer.data(), answer.size(), 0, (sockaddr*)&sender, len);
+                }
+            }
+        });
+    }
+} // namespace
+
+TEST(LinHttpHandler, GETJsonSax)
+{
+    TcpResponder responder("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                           "a\r\n{\"lights\":\r\n"
+                           "1c\r\n{\"1\":{\"state\":{\"on\":true}}}}\r\n"
+                           "0\r\n\r\n");
+
+    LinHttpHandler handler;
+    for (int i = 0; i < 2; ++i)
+    {
+        FilteringJsonSax sax({"lights/*/state"});
+        EXPECT_TRUE(handler.GETJsonSax("/api", nullptr, sax, "127.0.0.1", responder.getPort()));
+        EXPECT_EQ(nlohmann::json({{"lights", {{"1", {{"state", {{"on", true}}}}}}}}), sax.getResult());
+    }
+    // The connection is reused
+    EXPECT_EQ(1, responder.getConnections());
+    EXPECT_EQ(nlohmann::json({{"lights", {{"1", {{"state", {{"on", true}}}}}}}}),
+        handler.GETJson("/api", nullptr, "127.0.0.1", responder.getPort()));
+    EXPECT_EQ(1, responder.getConnections());
+}
+
+TEST(LinHttpHandler, sendGetHTTPBodyStopEarly)
+{
+    const std::string body(1024 * 1024, 'x');
+    TcpResponder responder("HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+    const std::string request = "GET /api HTTP/1.1\r\nContent-Length: 4\r\n\r\nnull";
+
+    LinHttpHandler handler;
+    std::string start(16, '\0');
+    handler.sendGetHTTPBody(
+        request, [&](std::istream& stream) { stream.read(&start[0], start.size()); }, "127.0.0.1",
+        responder.getPort());
+    EXPECT_EQ(body.substr(0, start.size()), start);
+
+    // The rest of the body was not read, so the connection cannot be reused
+    EXPECT_EQ(body, handler.sendGetHTTPBody(request, "127.0.0.1", responder.getPort()));
+    EXPECT_EQ(2, responder.getConnections());
+}
+
+TEST(LinHttpHandler, sendHTTPRequestLargeBody)
+{
+    TcpResponder responder("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+
+    LinHttpHandler handler;
+    // Larger than the socket buffer, so the pieces of the request are not sent at once
+    const std::string body = "null" + std::string(256 * 1024, ' ');
+    EXPECT_EQ("ok", handler.PUTString("/api", "application/json", body, "127.0.0.1", responder.getPort()));
+    EXPECT_EQ("ok", handler.PUTString("/api", "application/json", body, "127.0.0.1", responder.getPort()));
+    EXPECT_EQ(1, responder.getConnections());
+}
+
+TEST(LinHttpHandler, timeout)
+{
+    TcpResponder responder("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok", std::chrono::milliseconds(500));
+
+    LinHttpHandler handler;
+    handler.setTimeout(std::chrono::milliseconds(50));
+    const auto start = std::chrono::steady_clock::now();
+    try
+    {
+        handler.GETString("/api", "application/json", "null", "127.0.0.1", responder.getPort());
+        FAIL() << "Expected timeout";
+    }
+    catch (const std::system_error& e)
+    {
+        EXPECT_EQ(std::errc::timed_out, e.code());
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(400));
+
+    // The deadline of the current options is earlier than the handler timeout
+    handler.setTimeout(std::chrono::seconds(10));
+    RequestOptions::Scope scope(RequestOptions::withTimeout(std::chrono::milliseconds(50)));
+    EXPECT_THROW(handler.GETString("/api", "application/json", "null", "127.0.0.1", responder.getPort()),
+        std::system_error);
+}
+
+TEST(LinHttpHandler, sendMulticast)
+{
+    int port = 0;
+    int fd = OpenUdpSocket(port);
+    std::thread responder = AnswerOnce(fd, {"first\r\n\r\n", "second\r\n\r\nthird\r\n\r\n"});
+
+    LinHttpHandler handler;
+    std::vector<std::string> answers = handler.sendMulticast("M-SEARCH", "127.0.0.1", port, 1);
+    responder.join();
+    close(fd);
+
+    EXPECT_EQ(std::vector<std::string>({"first", "second", "third"}), answers);
+}
+
+TEST(LinHttpHandler, sendMulticastStopEarly)
+{
+    int port = 0;
+    int fd = OpenUdpSocket(port);
+    std::thread responder = AnswerOnce(fd, {"first\r\n\r\n", "second\r\n\r\n"});
+
+    LinHttpHandler handler;
+    std::vector<std::string> answers;
+    const auto start = std::chrono::steady_clock::now();
+    handler.sendMulticast(
+        "M-SEARCH",
+        [&](const std::string& answer) {
+            answers.push_back(answer);
+            return false;
+        },
+        "127.0.0.1", port, 5);
+    const auto duration = std::chrono::steady_clock::now() - start;
+    responder.join();
+    close(fd);
+
+    EXPECT_EQ(std::vector<std::string>({"first"}), answers);
+    // Returns without waiting for the timeout
+    EXPECT_LT(duration, std::chrono::seconds(2));
+}
+
+TEST(LinHttpHandler, sendMulticastTimeout)
+{
+    int port = 0;
+    int fd = OpenUdpSocket(port);
+
+    LinHttpHandler handler;
+    const auto start = std::chrono::steady_clock::now();
+    const std::clock_t cpuStart = std::clock();
+    std::vector<std::string> answers = handler.sendMulticast("M-SEARCH", "127.0.0.1", port, 1);
+    const auto duration = std::chrono::steady_clock::now() - start;
+    const double cpuSeconds = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    close(fd);
+
+    EXPECT_TRUE(answers.empty());
+    EXPECT_GE(duration, std::chrono::seconds(1));
+    // Waiting must not spin
+    EXPECT_LT(cpuSeconds, 0.5);
+}
@@ -0,0 +1,89 @@
+/**
+    \file test_Log.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/Log.h"
+
+namespace
+{
+    class LogTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            Log::setLevel(LogLevel::info);
+            Log::setSink([this](LogLevel level, const std::string& message) { messages.emplace_back(level, message); });
+        }
+        void TearDown() override
+        {
+            Log::setLevel(LogLevel::info);
+            Log::resetSink();
+        }
+
+        std::vector<std::pair<LogLevel, std::string>> messages;
+    };
+} // namespace
+
+TEST_F(LogTest, write)
+{
+    HUE_LOG(LogLevel::error, "Failed " << 1 << " time");
+    HUE_LOG(LogLevel::info, "info");
+    ASSERT_EQ(2u, messages.size());
+    EXPECT_EQ(LogLevel::error, messages[0].first);
+    EXPECT_EQ("Failed 1 time", messages[0].second);
+    EXPECT_EQ(LogLevel::info, messages[1].first);
+    EXPECT_EQ("info", messages[1].second);
+}
+
+TEST_F(LogTest, setLevel)
+{
+    int evaluated = 0;
+    const auto count = [&]() { return ++evaluated; };
+    HUE_LOG(LogLevel::debug, "debug " << count());
+    EXPECT_TRUE(messages.empty());
+    // Disabled messages are not formatted
+    EXPECT_EQ(0, evaluated);
+
+    Log::setLevel(LogLevel::debug);
+    EXPECT_EQ(LogLevel::debug, Log::getLevel());
+    HUE_LOG(LogLevel::debug, "debug " << count());
+    EXPECT_EQ(1, evaluated);
+    ASSERT_EQ(1u, messages.size());
+    EXPECT_EQ("debug 1", messages[0].second);
+
+    Log::setLevel(LogLevel::off);
+    HUE_LOG(LogLevel::error, "error");
+    EXPECT_EQ(1u, messages.size());
+}
+
+TEST_F(LogTest, setSink)
+{
+    Log::setSink(nullptr);
+    HUE_LOG(LogLevel::error, "discarded");
+    EXPECT_TRUE(messages.empty());
+}
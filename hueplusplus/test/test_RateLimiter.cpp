@@ -0,0 +1,107 @@
+/**
+    \file test_RateLimiter.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/RateLimiter.h"
+
+TEST(RateLimiter, tryReserve)
+{
+    const std::chrono::milliseconds interval(100);
+    RateLimiter limiter(interval);
+    EXPECT_EQ(interval, limiter.getInterval());
+    EXPECT_EQ(1u, limiter.getBurst());
+
+    RateLimiter::Clock::time_point next;
+    const RateLimiter::Clock::time_point before = RateLimiter::Clock::now();
+    EXPECT_TRUE(limiter.tryReserve(next));
+    // The next request can start one interval later
+    EXPECT_FALSE(limiter.tryReserve(next));
+    EXPECT_LT(before, next);
+    EXPECT_GE(RateLimiter::Clock::now() + interval, next);
+    // Failed attempts reserve nothing
+    RateLimiter::Clock::time_point again;
+    EXPECT_FALSE(limiter.tryReserve(again));
+    EXPECT_EQ(next, again);
+
+    limiter.setInterval(std::chrono::milliseconds(10));
+    EXPECT_EQ(std::chrono::milliseconds(10), limiter.getInterval());
+    // The earlier reservation is kept
+    EXPECT_FALSE(limiter.tryReserve(again));
+    EXPECT_EQ(next, again);
+    std::this_thread::sleep_until(next);
+    EXPECT_TRUE(limiter.tryReserve(again));
+}
+
+TEST(RateLimiter, burst)
+{
+    const std::chrono::milliseconds interval(100);
+    RateLimiter limiter(interval, 3);
+    EXPECT_EQ(3u, limiter.getBurst());
+
+    // A full bucket starts 3 requests immediately
+    RateLimiter::Clock::time_point next;
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_TRUE(limiter.tryReserve(next));
+    }
+    // Then requests are paced
+    const RateLimiter::Clock::time_point now = RateLimiter::Clock::now();
+    EXPECT_FALSE(limiter.tryReserve(next));
+    EXPECT_LT(now, next);
+
+    limiter.setBurst(0);
+    EXPECT_EQ(1u, limiter.getBurst());
+}
+
+TEST(RateLimiter, concurrentTryReserve)
+{
+    // No request can start again during the test, so only the full bucket is reserved
+    RateLimiter limiter(std::chrono::hours(1), 5);
+    std::atomic<int> reserved(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                RateLimiter::Clock::time_point next;
+                if (limiter.tryReserve(next))
+                {
+                    ++reserved;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    // No two threads got the same token
+    EXPECT_EQ(5, reserved);
+}
@@ -0,0 +1,191 @@
+/**
+    \file test_RequestMetrics.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/RequestMetrics.h"
+
+TEST(LatencyHistogram, buckets)
+{
+    for (std::uint64_t micros : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 1000ull, 123456ull, 1ull << 40})
+    {
+        const std::size_t bucket = LatencyHistogram::bucketOf(micros);
+        ASSERT_LT(bucket, LatencyHistogram::bucketCount);
+        EXPECT_LE(micros, LatencyHistogram::upperBound(bucket));
+        // Relative error of at most 12.5%
+        EXPECT_LE(LatencyHistogram::upperBound(bucket) - micros, micros / 8 + 1);
+        if (bucket > 0)
+        {
+            EXPECT_GT(micros, LatencyHistogram::upperBound(bucket - 1));
+        }
+    }
+    EXPECT_EQ(LatencyHistogram::bucketCount - 1, LatencyHistogram::bucketOf(~0ull));
+}
+
+TEST(LatencyHistogram, snapshot)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(std::chrono::steady_clock::duration::zero(), histogram.snapshot().quantile(0.5));
+    for (int i = 1; i <= 100; ++i)
+    {
+        histogram.record(std::chrono::milliseconds(i));
+    }
+    histogram.record(std::chrono::milliseconds(-1));
+
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(101u, snapshot.count);
+    EXPECT_EQ(std::chrono::milliseconds(5050), snapshot.sum);
+    EXPECT_LE(std::chrono::milliseconds(50), snapshot.quantile(0.5));
+    EXPECT_GE(std::chrono::microseconds(50000 + 50000 / 8), snapshot.quantile(0.5));
+    EXPECT_LE(std::chrono::milliseconds(99), snapshot.quantile(0.99));
+    EXPECT_EQ(1u, snapshot.countAtMost(std::chrono::steady_clock::duration::zero()));
+    EXPECT_EQ(101u, snapshot.countAtMost(std::chrono::seconds(1)));
+}
+
+TEST(RequestMetrics, normalizePath)
+{
+    EXPECT_EQ("/", RequestMetrics::normalizePath(""));
+    EXPECT_EQ("/", RequestMetrics::normalizePath("/"));
+    EXPECT_EQ("/lights", RequestMetrics::normalizePath("lights"));
+    EXPECT_EQ("/lights/{id}/state", RequestMetrics::normalizePath("/lights/12/state"));
+    EXPECT_EQ("/scenes/{id}", RequestMetrics::normalizePath("/scenes/ab1Cd2/"));
+    EXPECT_EQ("/config", RequestMetrics::normalizePath("/config"));
+}
+
+TEST(RequestMetrics, getEndpoint)
+{
+    RequestMetrics metrics;
+    EXPECT_TRUE(metrics.snapshot().empty());
+
+    RequestMetrics::Endpoint& light = metrics.getEndpoint("PUT", "/lights/1/state");
+    EXPECT_EQ(&light, &metrics.getEndpoint("PUT", "lights/2/state"));
+    EXPECT_NE(&light, &metrics.getEndpoint("GET", "/lights/1/state"));
+    EXPECT_EQ("/lights/{id}/state", light.getPath());
+
+    light.recordQueueWait(std::chrono::milliseconds(100));
+    light.recordNetwork(std::chrono::milliseconds(20));
+    light.recordParse(std::chrono::milliseconds(2));
+    light.recordTotal(std::chrono::milliseconds(120));
+    light.recordSuccess();
+    light.recordRetry();
+    light.recordCoalesced();
+    light.recordFailure();
+    light.recordAPIError(901);
+    light.recordAPIError(901);
+    light.recordAPIError(7);
+
+    std::vector<RequestMetrics::EndpointSnapshot> snapshot = metrics.snapshot();
+    ASSERT_EQ(2u, snapshot.size());
+    EXPECT_EQ("GET", snapshot[0].method);
+    const RequestMetrics::EndpointSnapshot& put = snapshot[1];
+    EXPECT_EQ("PUT", put.method);
+    EXPECT_EQ("/lights/{id}/state", put.path);
+    EXPECT_EQ(1u, put.queueWait.count);
+    EXPECT_EQ(std::chrono::milliseconds(20), put.network.sum);
+    EXPECT_EQ(std::chrono::milliseconds(2), put.parse.sum);
+    EXPECT_EQ(1u, put.total.count);
+    EXPECT_EQ(1u, put.successes);
+    EXPECT_EQ(1u, put.failures);
+    EXPECT_EQ(1u, put.retries);
+    EXPECT_EQ(1u, put.coalesced);
+    EXPECT_EQ((std::map<int, std::uint64_t> {{7, 1}, {901, 2}}), put.apiErrors);
+
+    // Endpoints beyond the maximum are combined
+    for (std::size_t i = 0; i < RequestMetrics::maxEndpoints; ++i)
+    {
+        metrics.getEndpoint("GET", "/path" + std::string(i + 1, 'a')).recordSuccess();
+    }
+    snapshot = metrics.snapshot();
+    EXPECT_EQ(RequestMetrics::maxEndpoints + 1, snapshot.size());
+    EXPECT_EQ("*", snapshot.front().path);
+    EXPECT_EQ(2u, snapshot.front().successes);
+}
+
+TEST(RequestMetrics, concurrentRecording)
+{
+    RequestMetrics metrics;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&metrics] {
+            for (int i = 0; i < 1000; ++i)
+            {
+                RequestMetrics::Endpoint& endpoint = metrics.getEndpoint("GET", "/lights/" + std::to_string(i % 3));
+                endpoint.recordTotal(std::chrono::microseconds(i));
+                endpoint.recordAPIError(i % 20 + 1);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    const std::vector<RequestMetrics::EndpointSnapshot> snapshot = metrics.snapshot();
+    ASSERT_EQ(1u, snapshot.size());
+    EXPECT_EQ(4000u, snapshot[0].total.count);
+    std::uint64_t errors = 0;
+    for (const auto& entry : snapshot[0].apiErrors)
+    {
+        errors += entry.second;
+    }
+    EXPECT_EQ(4000u, errors);
+    // More types than slots are counted as type 0
+    EXPECT_EQ(1u, snapshot[0].apiErrors.count(0));
+}
+
+TEST(RequestMetrics, takeParseTime)
+{
+    EXPECT_EQ(RequestMetrics::Clock::duration::zero(), RequestMetrics::takeParseTime());
+    RequestMetrics::addParseTime(std::chrono::milliseconds(2));
+    RequestMetrics::addParseTime(std::chrono::milliseconds(3));
+    std::thread([]() { RequestMetrics::addParseTime(std::chrono::milliseconds(7)); }).join();
+    EXPECT_EQ(std::chrono::milliseconds(5), RequestMetrics::takeParseTime());
+    EXPECT_EQ(RequestMetrics::Clock::duration::zero(), RequestMetrics::takeParseTime());
+}
+
+TEST(RequestMetrics, toPrometheus)
+{
+    RequestMetrics metrics;
+    RequestMetrics::Endpoint& endpoint = metrics.getEndpoint("PUT", "/lights/1/state");
+    endpoint.recordTotal(std::chrono::milliseconds(3));
+    endpoint.recordParse(std::chrono::microseconds(200));
+    endpoint.recordSuccess();
+    endpoint.recordAPIError(901);
+
+    const std::string text = RequestMetrics::toPrometheus(metrics.snapshot());
+    const std::string labels = "method=\"PUT\",path=\"/lights/{id}/state\"";
+    EXPECT_NE(std::string::npos, text.find("# TYPE hueplusplus_request_total_seconds histogram\n"));
+    EXPECT_NE(std::string::npos, text.find("hueplusplus_request_total_seconds_bucket{" + labels + ",le=\"0.0025\"} 0\n"));
+    EXPECT_NE(std::string::npos, text.find("hueplusplus_request_total_seconds_bucket{" + labels + ",le=\"0.005\"} 1\n"));
+    EXPECT_NE(std::string::npos, text.find("hueplusplus_request_total_seconds_bucket{" + labels + ",le=\"+Inf\"} 1\n"));
+    EXPECT_NE(std::string::npos, text.find("hueplusplus_request_total_seconds_count{" + labels + "} 1\n"));
+    EXPECT_NE(std::string::npos, text.find("# TYPE hueplusplus_request_parse_seconds histogram\n"));
+    EXPECT_NE(std::string::npos, text.find("hueplusplus_request_parse_seconds_count{" + labels + "} 1\n"));
+    EXPECT_NE(std::string::npos, text.find("hueplusplus_requests_total{" + labels + ",outcome=\"success\"} 1\n"));
+    EXPECT_NE(std::string::npos, text.find("hueplusplus_request_api_errors_total{" + labels + ",type=\"901\"} 1\n"));
+}
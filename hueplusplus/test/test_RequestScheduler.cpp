@@ -0,0 +1,115 @@
+/**
+    \file test_RequestScheduler.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <chrono>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/RequestScheduler.h"
+
+namespace
+{
+    // Starts a thread that waits in scheduler and appends id to order when it is its turn
+    std::thread StartWaiting(RequestScheduler& scheduler, RequestOptions::Priority priority, int id,
+        std::vector<int>& order, std::mutex& mutex)
+    {
+        return std::thread([&, priority, id]() {
+            scheduler.wait(priority, RequestScheduler::Clock::time_point::max());
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(id);
+        });
+    }
+} // namespace
+
+TEST(RequestScheduler, wait)
+{
+    const std::chrono::milliseconds interval(50);
+    RequestScheduler scheduler(interval);
+    EXPECT_EQ(interval, scheduler.getRateLimiter().getInterval());
+    const auto start = RequestScheduler::Clock::now();
+    scheduler.wait(RequestOptions::Priority::normal, RequestScheduler::Clock::time_point::max());
+    EXPECT_GT(interval, RequestScheduler::Clock::now() - start);
+    scheduler.wait(RequestOptions::Priority::normal, RequestScheduler::Clock::time_point::max());
+    EXPECT_LE(interval, RequestScheduler::Clock::now() - start);
+}
+
+TEST(RequestScheduler, priority)
+{
+    RequestScheduler scheduler(std::chrono::milliseconds(100));
+    std::vector<int> order;
+    std::mutex mutex;
+    // Takes the first slot, so the others have to wait
+    scheduler.wait(RequestOptions::Priority::normal, RequestScheduler::Clock::time_point::max());
+    std::vector<std::thread> threads;
+    threads.push_back(StartWaiting(scheduler, RequestOptions::Priority::background, 0, order, mutex));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    threads.push_back(StartWaiting(scheduler, RequestOptions::Priority::normal, 1, order, mutex));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    threads.push_back(StartWaiting(scheduler, RequestOptions::Priority::interactive, 2, order, mutex));
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ((std::vector<int> {2, 1, 0}), order);
+}
+
+TEST(RequestScheduler, aging)
+{
+    RequestScheduler scheduler(std::chrono::milliseconds(100));
+    scheduler.setAgingDelay(std::chrono::milliseconds(20));
+    EXPECT_EQ(std::chrono::milliseconds(20), scheduler.getAgingDelay());
+    std::vector<int> order;
+    std::mutex mutex;
+    scheduler.wait(RequestOptions::Priority::normal, RequestScheduler::Clock::time_point::max());
+    std::vector<std::thread> threads;
+    threads.push_back(StartWaiting(scheduler, RequestOptions::Priority::background, 0, order, mutex));
+    // Waited for more than two aging delays, so it is ahead of the interactive request
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    threads.push_back(StartWaiting(scheduler, RequestOptions::Priority::interactive, 1, order, mutex));
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ((std::vector<int> {0, 1}), order);
+}
+
+TEST(RequestScheduler, deadline)
+{
+    RequestScheduler scheduler(std::chrono::seconds(1));
+    scheduler.wait(RequestOptions::Priority::normal, RequestScheduler::Clock::time_point::max());
+    const auto start = RequestScheduler::Clock::now();
+    try
+    {
+        scheduler.wait(RequestOptions::Priority::interactive, start + std::chrono::milliseconds(50));
+        FAIL() << "Expected timeout";
+    }
+    catch (const std::system_error& e)
+    {
+        EXPECT_EQ(std::errc::timed_out, e.code());
+    }
+    EXPECT_GT(std::chrono::milliseconds(500), RequestScheduler::Clock::now() - start);
+}
@@ -0,0 +1,141 @@
+/**
+    \file test_RetryPolicy.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <chrono>
+#include <system_error>
+
+#include <gtest/gtest.h>
+
+#include "../include/RetryPolicy.h"
+
+namespace
+{
+    RetryPolicy::Failure TransportFailure(std::errc code, unsigned int attempt)
+    {
+        RetryPolicy::Failure failure;
+        failure.type = RetryPolicy::ErrorType::transport;
+        failure.code = std::make_error_code(code);
+        failure.attempt = attempt;
+        failure.interval = std::chrono::milliseconds(100);
+        return failure;
+    }
+} // namespace
+
+TEST(RetryPolicy, defaultSettings)
+{
+    RetryPolicy policy;
+    std::chrono::steady_clock::duration delay = std::chrono::steady_clock::duration::zero();
+
+    // One retry after the interval for connection resets and timeouts
+    EXPECT_TRUE(policy.shouldRetry(TransportFailure(std::errc::connection_reset, 1), delay));
+    EXPECT_EQ(std::chrono::milliseconds(100), delay);
+    EXPECT_TRUE(policy.shouldRetry(TransportFailure(std::errc::timed_out, 1), delay));
+    EXPECT_FALSE(policy.shouldRetry(TransportFailure(std::errc::timed_out, 2), delay));
+    EXPECT_FALSE(policy.shouldRetry(TransportFailure(std::errc::connection_refused, 1), delay));
+    EXPECT_FALSE(policy.shouldRetry(TransportFailure(std::errc::connection_aborted, 1), delay));
+
+    RetryPolicy::Failure failure;
+    failure.type = RetryPolicy::ErrorType::api;
+    failure.apiError = 901;
+    EXPECT_FALSE(policy.isRetryable(failure));
+    failure.type = RetryPolicy::ErrorType::http;
+    EXPECT_FALSE(policy.isRetryable(failure));
+
+    // PUT requests are retried by default
+    failure = TransportFailure(std::errc::connection_reset, 1);
+    failure.idempotent = false;
+    EXPECT_TRUE(policy.isRetryable(failure));
+}
+
+TEST(RetryPolicy, classification)
+{
+    RetryPolicy::Settings settings;
+    settings.retryPUT = false;
+    settings.retryInternalErrors = true;
+    settings.retryHttpErrors = true;
+    RetryPolicy policy(settings);
+
+    RetryPolicy::Failure failure;
+    failure.type = RetryPolicy::ErrorType::api;
+    failure.apiError = 901;
+    EXPECT_TRUE(policy.isRetryable(failure));
+    // Other errors of the bridge do not go away by repeating the request
+    failure.apiError = 7;
+    EXPECT_FALSE(policy.isRetryable(failure));
+    failure.type = RetryPolicy::ErrorType::http;
+    EXPECT_TRUE(policy.isRetryable(failure));
+    failure.idempotent = false;
+    EXPECT_FALSE(policy.isRetryable(failure));
+}
+
+TEST(RetryPolicy, backoff)
+{
+    RetryPolicy::Settings settings;
+    settings.maxAttempts = 5;
+    settings.initialBackoff = std::chrono::milliseconds(200);
+    settings.backoffFactor = 2.0;
+    settings.maxBackoff = std::chrono::milliseconds(500);
+    settings.jitter = 0.0;
+    RetryPolicy policy(settings);
+
+    RetryPolicy::Failure failure = TransportFailure(std::errc::connection_reset, 1);
+    EXPECT_EQ(std::chrono::milliseconds(200), policy.getBackoff(failure));
+    failure.attempt = 2;
+    EXPECT_EQ(std::chrono::milliseconds(400), policy.getBackoff(failure));
+    failure.attempt = 3;
+    EXPECT_EQ(std::chrono::milliseconds(500), policy.getBackoff(failure));
+    // At least the interval of the request type
+    failure.interval = std::chrono::seconds(1);
+    EXPECT_EQ(std::chrono::seconds(1), policy.getBackoff(failure));
+
+    std::chrono::steady_clock::duration delay;
+    failure.attempt = 4;
+    EXPECT_TRUE(policy.shouldRetry(failure, delay));
+    failure.attempt = 5;
+    EXPECT_FALSE(policy.shouldRetry(failure, delay));
+
+    settings.jitter = 0.5;
+    RetryPolicy jittered(settings);
+    failure = TransportFailure(std::errc::connection_reset, 1);
+    for (int i = 0; i < 10; ++i)
+    {
+        const std::chrono::steady_clock::duration backoff = jittered.getBackoff(failure);
+        EXPECT_LE(std::chrono::milliseconds(200), backoff);
+        EXPECT_GE(std::chrono::milliseconds(300), backoff);
+    }
+}
+
+TEST(RetryPolicy, budget)
+{
+    RetryPolicy::Settings settings;
+    settings.maxAttempts = 10;
+    settings.budget = std::chrono::seconds(1);
+    RetryPolicy policy(settings);
+
+    std::chrono::steady_clock::duration delay;
+    RetryPolicy::Failure failure = TransportFailure(std::errc::timed_out, 3);
+    failure.elapsed = std::chrono::milliseconds(800);
+    EXPECT_TRUE(policy.shouldRetry(failure, delay));
+    failure.elapsed = std::chrono::milliseconds(950);
+    EXPECT_FALSE(policy.shouldRetry(failure, delay));
+}
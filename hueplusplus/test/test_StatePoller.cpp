@@ -0,0 +1,171 @@
+/**
+    \file test_StatePoller.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "testhelper.h"
+
+#include "../include/StatePoller.h"
+#include "../include/json/json.hpp"
+#include "mocks/mock_HttpHandler.h"
+
+namespace
+{
+    nlohmann::json getLightsState(int bri, bool reachable)
+    {
+        return {{"1", {{"state", {{"on", true}, {"bri", bri}, {"reachable", reachable}}}, {"name", "Lamp 1"}}},
+            {"2", {{"state", {{"on", false}, {"bri", 1}, {"reachable", true}}}, {"name", "Lamp 2"}}}};
+    }
+
+    auto respond(const nlohmann::json& lights)
+    {
+        const std::string response = nlohmann::json({{"lights", lights}, {"config", {{"name", "Bridge"}}}}).dump();
+        return [response](const std::string&, const nlohmann::json&, nlohmann::json::json_sax_t& handler,
+                   const std::string&, int) { return nlohmann::json::sax_parse(response, &handler); };
+    }
+} // namespace
+
+TEST(StatePoller, diff)
+{
+    using Type = StatePoller::LightChange::Type;
+    const nlohmann::json oldLights = getLightsState(120, true);
+    EXPECT_TRUE(StatePoller::diff(oldLights, oldLights).empty());
+
+    nlohmann::json newLights = getLightsState(200, false);
+    newLights.erase("2");
+    newLights["1"]["state"]["xy"] = {0.1, 0.2};
+    newLights["3"] = {{"name", "Lamp 3"}};
+    std::vector<StatePoller::LightChange> changes = StatePoller::diff(oldLights, newLights);
+    ASSERT_EQ(5u, changes.size());
+    EXPECT_EQ(Type::changed, changes[0].type);
+    EXPECT_EQ(1, changes[0].id);
+    EXPECT_EQ("/state/bri", changes[0].attribute);
+    EXPECT_EQ(120, changes[0].oldValue);
+    EXPECT_EQ(200, changes[0].newValue);
+    EXPECT_EQ("/state/reachable", changes[1].attribute);
+    EXPECT_EQ(false, changes[1].newValue);
+    EXPECT_EQ("/state/xy", changes[2].attribute);
+    EXPECT_TRUE(changes[2].oldValue.is_null());
+    EXPECT_EQ(nlohmann::json({0.1, 0.2}), changes[2].newValue);
+    EXPECT_EQ(Type::removed, changes[3].type);
+    EXPECT_EQ(2, changes[3].id);
+    EXPECT_EQ(oldLights["2"], changes[3].oldValue);
+    EXPECT_EQ(Type::added, changes[4].type);
+    EXPECT_EQ(3, changes[4].id);
+    EXPECT_EQ(newLights["3"], changes[4].newValue);
+
+    // Arrays are compared as a whole
+    nlohmann::json xyLights = newLights;
+    xyLights["1"]["state"]["xy"] = {0.1, 0.3};
+    changes = StatePoller::diff(newLights, xyLights);
+    ASSERT_EQ(1u, changes.size());
+    EXPECT_EQ("/state/xy", changes[0].attribute);
+
+    // Keys are escaped in the JSON pointer
+    nlohmann::json escapedLights = xyLights;
+    escapedLights["1"]["state"]["a/b~c"] = 1;
+    changes = StatePoller::diff(xyLights, escapedLights);
+    ASSERT_EQ(1u, changes.size());
+    EXPECT_EQ("/state/a~1b~0c", changes[0].attribute);
+    EXPECT_EQ(1, escapedLights["1"][nlohmann::json::json_pointer(changes[0].attribute)]);
+}
+
+TEST(StatePoller, subscribe)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    std::promise<void> subscribed;
+    std::shared_future<void> ready = subscribed.get_future().share();
+    // Changes only start after the subscriber was added
+    EXPECT_CALL(*handler, GETJsonSax("/api/" + getBridgeUsername(), nlohmann::json::object(), _, getBridgeIp(), 80))
+        .WillOnce(Invoke(respond(getLightsState(120, true))))
+        .WillRepeatedly(
+            DoAll(InvokeWithoutArgs([ready] { ready.wait(); }), Invoke(respond(getLightsState(200, false)))));
+    HueCommandAPI commands(getBridgeIp(), 80, getBridgeUsername(), handler);
+
+    std::mutex mutex;
+    std::vector<StatePoller::LightChange> changes;
+    std::promise<void> received;
+    StatePoller poller(commands, std::chrono::milliseconds(5));
+    EXPECT_TRUE(poller.isRunning());
+    EXPECT_EQ(std::chrono::milliseconds(5), poller.getInterval());
+    std::atomic<int> appliedBri{0};
+    poller.addUpdateHandler(
+        [&](const nlohmann::json& lights) { appliedBri = lights["1"]["state"]["bri"].get<int>(); });
+    poller.subscribe([&](const StatePoller::LightChange& change) {
+        // Update handlers are called before the changes are passed on
+        EXPECT_EQ(200, appliedBri);
+        std::lock_guard<std::mutex> lock(mutex);
+        changes.push_back(change);
+        if (changes.size() == 2)
+        {
+            received.set_value();
+        }
+    });
+    const std::uint64_t removed = poller.subscribe([](const StatePoller::LightChange&) { FAIL(); });
+    poller.unsubscribe(removed);
+    subscribed.set_value();
+
+    ASSERT_EQ(std::future_status::ready, received.get_future().wait_for(std::chrono::seconds(5)));
+    std::chrono::steady_clock::time_point time;
+    EXPECT_EQ(getLightsState(200, false)["1"], poller.getLightState(1, time));
+    EXPECT_NE(std::chrono::steady_clock::time_point(), time);
+    EXPECT_TRUE(poller.getLightState(3, time).is_null());
+
+    poller.stop();
+    EXPECT_FALSE(poller.isRunning());
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(2u, changes.size());
+    EXPECT_EQ(1, changes[0].id);
+    EXPECT_EQ("/state/bri", changes[0].attribute);
+    EXPECT_EQ(120, changes[0].oldValue);
+    EXPECT_EQ(200, changes[0].newValue);
+    EXPECT_EQ("/state/reachable", changes[1].attribute);
+    EXPECT_EQ(false, changes[1].newValue);
+}
+
+TEST(StatePoller, errors)
+{
+    using namespace ::testing;
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    std::promise<void> retried;
+    EXPECT_CALL(*handler, GETJsonSax("/api/" + getBridgeUsername(), nlohmann::json::object(), _, getBridgeIp(), 80))
+        .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_refused))))
+        .WillOnce(Throw(std::system_error(std::make_error_code(std::errc::connection_refused))))
+        .WillOnce(DoAll(InvokeWithoutArgs([&] { retried.set_value(); }), Invoke(respond(getLightsState(1, true)))))
+        .WillRepeatedly(Invoke(respond(getLightsState(1, true))));
+    HueCommandAPI commands(getBridgeIp(), 80, getBridgeUsername(), handler);
+
+    StatePoller poller(commands, std::chrono::milliseconds(5));
+    // Polling continues after errors
+    ASSERT_EQ(std::future_status::ready, retried.get_future().wait_for(std::chrono::seconds(5)));
+    poller.stop();
+    EXPECT_NE(std::chrono::steady_clock::time_point(), poller.getUpdateTime());
+}
@@ -0,0 +1,246 @@
+/**
+    \file test_Trace.cpp
+    Copyright Notice\n
+    Copyright (C) 2020  Jan Rogall		- developer\n
+    Copyright (C) 2020  Moritz Wirger	- developer\n
+
+    This file is part of hueplusplus.
+
+    hueplusplus is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    hueplusplus is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with hueplusplus.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "testhelper.h"
+
+#include "../include/BaseAsyncHttpHandler.h"
+#include "../include/HueCommandAPI.h"
+#include "../include/Trace.h"
+#include "mocks/mock_BaseHttpHandler.h"
+
+namespace
+{
+    // Records all finished spans
+    class RecordingInterceptor : public TraceInterceptor
+    {
+    public:
+        void onStart(const TraceSpan& span) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            started.push_back(span.spanId);
+        }
+        void onEnd(const TraceSpan& span) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ended.push_back(span);
+        }
+
+        std::mutex mutex;
+        std::vector<std::uint64_t> started;
+        std::vector<TraceSpan> ended;
+    };
+
+    // Answers every request on another thread with the same response or error
+    class ThreadAsyncHttpHandler : public BaseAsyncHttpHandler
+    {
+    public:
+        ThreadAsyncHttpHandler(std::string response, std::exception_ptr error = nullptr)
+            : response(std::move(response)), error(error)
+        {}
+
+        using BaseAsyncHttpHandler::send;
+        void send(const std::string&, const std::string&, int, ResponseCallback onResponse) const override
+        {
+            std::thread(onResponse, response, error).join();
+        }
+
+    private:
+        std::string response;
+        std::exception_ptr error;
+    };
+
+    class TraceTest : public ::testing::Test
+    {
+    protected:
+        ~TraceTest() { Trace::clearInterceptors(); }
+    };
+} // namespace
+
+TEST_F(TraceTest, disabled)
+{
+    EXPECT_FALSE(Trace::isEnabled());
+    Trace::Span span(SpanKind::user, "action");
+    EXPECT_FALSE(span.isActive());
+    EXPECT_EQ(nullptr, span.get());
+    EXPECT_EQ(0u, RequestOptions::current().spanId);
+    EXPECT_EQ(42, Trace::inSpan(SpanKind::user, "action", "", [] { return 42; }));
+}
+
+TEST_F(TraceTest, nestedSpans)
+{
+    auto interceptor = std::make_shared<RecordingInterceptor>();
+    Trace::addInterceptor(interceptor);
+    EXPECT_TRUE(Trace::isEnabled());
+    {
+        Trace::Span outer(SpanKind::user, "outer");
+        ASSERT_TRUE(outer.isActive());
+        EXPECT_EQ(outer.get()->spanId, RequestOptions::current().spanId);
+        EXPECT_EQ(outer.get()->spanId, outer.get()->traceId);
+        EXPECT_EQ(0u, outer.get()->parentId);
+        EXPECT_THROW(Trace::inSpan(SpanKind::user, "inner", "/path", []() -> int { throw std::runtime_error("fail"); }),
+            std::runtime_error);
+        EXPECT_EQ(outer.get()->spanId, RequestOptions::current().spanId);
+    }
+    EXPECT_EQ(0u, RequestOptions::current().spanId);
+
+    ASSERT_EQ(2u, interceptor->ended.size());
+    const TraceSpan& inner = interceptor->ended[0];
+    const TraceSpan& outer = interceptor->ended[1];
+    EXPECT_EQ((std::vector<std::uint64_t> {outer.spanId, inner.spanId}), interceptor->started);
+    EXPECT_EQ(outer.traceId, inner.traceId);
+    EXPECT_EQ(outer.spanId, inner.parentId);
+    EXPECT_EQ("inner", inner.method);
+    EXPECT_EQ("/path", inner.path);
+    EXPECT_TRUE(inner.failed);
+    EXPECT_EQ("fail", inner.error);
+    EXPECT_FALSE(outer.failed);
+    EXPECT_LE(outer.start, inner.start);
+    EXPECT_LE(inner.end, outer.end);
+
+    Trace::removeInterceptor(interceptor);
+    EXPECT_FALSE(Trace::isEnabled());
+}
+
+TEST_F(TraceTest, bridgeCalls)
+{
+    using namespace ::testing;
+    auto interceptor = std::make_shared<RecordingInterceptor>();
+    Trace::addInterceptor(interceptor);
+    auto handler = std::make_shared<MockBaseHttpHandler>();
+    EXPECT_CALL(*handler, send(_, getBridgeIp(), getBridgePort()))
+        .WillOnce(Return("HTTP/1.1 200 OK\r\n\r\n{\"on\": true}"));
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    {
+        Trace::Span action(SpanKind::user, "setColorRGB");
+        api.GETRequest("/lights/1", nlohmann::json::object());
+    }
+
+    ASSERT_EQ(3u, interceptor->ended.size());
+    const TraceSpan& http = interceptor->ended[0];
+    const TraceSpan& call = interceptor->ended[1];
+    const TraceSpan& action = interceptor->ended[2];
+    EXPECT_EQ(SpanKind::api, call.kind);
+    EXPECT_EQ("GET", call.method);
+    EXPECT_EQ("/lights/1", call.path);
+    EXPECT_EQ(action.spanId, call.parentId);
+    EXPECT_EQ(SpanKind::http, http.kind);
+    EXPECT_EQ("GET", http.method);
+    EXPECT_EQ("/api/" + getBridgeUsername() + "/lights/1", http.path);
+    EXPECT_EQ(call.spanId, http.parentId);
+    EXPECT_EQ(action.traceId, http.traceId);
+    EXPECT_EQ(2u, http.requestBytes);
+    EXPECT_EQ(12u, http.responseBytes);
+    EXPECT_FALSE(http.failed);
+}
+
+TEST_F(TraceTest, removeDuringSpan)
+{
+    auto interceptor = std::make_shared<RecordingInterceptor>();
+    Trace::addInterceptor(interceptor);
+    {
+        Trace::Span span(SpanKind::user, "action");
+        Trace::removeInterceptor(interceptor);
+        EXPECT_FALSE(Trace::isEnabled());
+    }
+    // The span ends at the interceptors it started with
+    EXPECT_EQ(1u, interceptor->started.size());
+    EXPECT_EQ(1u, interceptor->ended.size());
+}
+
+TEST_F(TraceTest, instanceChains)
+{
+    using namespace ::testing;
+    auto global = std::make_shared<RecordingInterceptor>();
+    auto apiInterceptor = std::make_shared<RecordingInterceptor>();
+    auto httpInterceptor = std::make_shared<RecordingInterceptor>();
+    auto handler = std::make_shared<MockBaseHttpHandler>();
+    EXPECT_CALL(*handler, send(_, getBridgeIp(), getBridgePort()))
+        .Times(2)
+        .WillRepeatedly(Return("HTTP/1.1 200 OK\r\n\r\n{\"on\": true}"));
+    handler->getTraceChain().add(httpInterceptor);
+
+    HueCommandAPI api(getBridgeIp(), getBridgePort(), getBridgeUsername(), handler);
+    // Copies share the chain
+    HueCommandAPI(api).getTraceChain().add(apiInterceptor);
+    EXPECT_FALSE(Trace::isEnabled());
+    api.GETRequest("/lights/1", nlohmann::json::object());
+    ASSERT_EQ(1u, apiInterceptor->ended.size());
+    ASSERT_EQ(1u, httpInterceptor->ended.size());
+    EXPECT_EQ(SpanKind::api, apiInterceptor->ended[0].kind);
+    EXPECT_EQ(SpanKind::http, httpInterceptor->ended[0].kind);
+    EXPECT_EQ(apiInterceptor->ended[0].spanId, httpInterceptor->ended[0].parentId);
+
+    // Global interceptors are called before the ones of the instance
+    Trace::addInterceptor(global);
+    api.GETRequest("/lights/2", nlohmann::json::object());
+    EXPECT_EQ(2u, global->ended.size());
+    EXPECT_EQ(2u, apiInterceptor->ended.size());
+    EXPECT_EQ(2u, httpInterceptor->ended.size());
+
+    api.getTraceChain().clear();
+    EXPECT_FALSE(api.getTraceChain().isEnabled());
+}
+
+TEST_F(TraceTest, asyncHandler)
+{
+    auto interceptor = std::make_shared<RecordingInterceptor>();
+    ThreadAsyncHttpHandler handler("HTTP/1.1 200 OK\r\n\r\n{\"on\": true}");
+    handler.getTraceChain().add(interceptor);
+    {
+        Trace::Span action(SpanKind::user, "action", "", &handler.getTraceChain());
+        EXPECT_EQ(nlohmann::json({{"on", true}}), handler.PUTJson("/api/1", {{"on", true}}, getBridgeIp()).get());
+        // The span of the request is not the current span of the thread anymore
+        EXPECT_EQ(action.get()->spanId, RequestOptions::current().spanId);
+    }
+    ThreadAsyncHttpHandler failing("", std::make_exception_ptr(std::system_error(
+                                           std::make_error_code(std::errc::connection_reset), "reset")));
+    failing.getTraceChain().add(interceptor);
+    EXPECT_THROW(failing.sendHTTPRequest("GET", "/api/1", "", "", getBridgeIp()).get(), std::system_error);
+
+    ASSERT_EQ(3u, interceptor->ended.size());
+    const TraceSpan& put = interceptor->ended[0];
+    const TraceSpan& action = interceptor->ended[1];
+    const TraceSpan& get = interceptor->ended[2];
+    EXPECT_EQ(SpanKind::http, put.kind);
+    EXPECT_EQ("PUT", put.method);
+    EXPECT_EQ("/api/1", put.path);
+    EXPECT_EQ(action.spanId, put.parentId);
+    EXPECT_EQ(11u, put.requestBytes);
+    EXPECT_EQ(12u, put.responseBytes);
+    EXPECT_FALSE(put.failed);
+    EXPECT_EQ("GET", get.method);
+    EXPECT_EQ(0u, get.parentId);
+    EXPECT_TRUE(get.failed);
+}
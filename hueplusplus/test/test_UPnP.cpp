@@ -49,3 +49,31 @@ TEST(UPnP, getDevices)
 
     EXPECT_EQ(foundDevices, expected_uplug_dev);
 }
+
+TEST(UPnP, getDevicesCallback)
+{
+    std::shared_ptr<MockHttpHandler> handler = std::make_shared<MockHttpHandler>();
+    EXPECT_CALL(*handler,
+        sendMulticast("M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: "
+                      "\"ssdp:discover\"\r\nMX: 5\r\nST: ssdp:all\r\n\r\n",
+            "239.255.255.250", 1900, 5))
+        .Times(2)
+        .WillRepeatedly(::testing::Return(getMulticastReply()));
+
+    UPnP uplug;
+    std::vector<std::pair<std::string, std::string>> foundDevices;
+    uplug.getDevices(handler, [&](const std::pair<std::string, std::string>& device) {
+        foundDevices.push_back(device);
+        return true;
+    });
+    EXPECT_EQ(foundDevices, expected_uplug_dev);
+
+    // Stop after first device
+    foundDevices.clear();
+    uplug.getDevices(handler, [&](const std::pair<std::string, std::string>& device) {
+        foundDevices.push_back(device);
+        return false;
+    });
+    ASSERT_EQ(1u, foundDevices.size());
+    EXPECT_EQ(expected_uplug_dev[0], foundDevices[0]);
+}